@@ -0,0 +1,137 @@
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../models/fingerprinter.hpp"
+#include "../models/musicformat.hpp"
+
+using namespace NickvisionTagger::Models;
+
+/**
+ * Computes the chromaprint fingerprint of a music file by spawning fpcalc and parsing its output, the way files were fingerprinted before the in-process engine
+ *
+ * @param path The path of the music file
+ * @param length The length of audio to fingerprint (in seconds)
+ * @returns The chromaprint fingerprint, or an empty string if fpcalc failed
+ */
+static std::string fingerprintWithFpcalc(const std::filesystem::path& path, unsigned int length)
+{
+    int pipeFds[2];
+    if(pipe2(pipeFds, O_CLOEXEC) != 0)
+    {
+        return "";
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipeFds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    std::string pathString{ path.string() };
+    std::string lengthString{ std::to_string(length) };
+    char* argv[]{ const_cast<char*>("fpcalc"), const_cast<char*>("-length"), lengthString.data(), pathString.data(), nullptr };
+    pid_t pid;
+    int spawnResult{ posix_spawnp(&pid, "fpcalc", &actions, nullptr, argv, environ) };
+    posix_spawn_file_actions_destroy(&actions);
+    close(pipeFds[1]);
+    if(spawnResult != 0)
+    {
+        close(pipeFds[0]);
+        return "";
+    }
+    std::string output;
+    std::array<char, 4096> buffer;
+    ssize_t count;
+    while((count = read(pipeFds[0], buffer.data(), buffer.size())) != 0)
+    {
+        if(count > 0)
+        {
+            output.append(buffer.data(), count);
+        }
+        else if(errno != EINTR)
+        {
+            break;
+        }
+    }
+    close(pipeFds[0]);
+    int status{ 0 };
+    while(waitpid(pid, &status, 0) < 0 && errno == EINTR);
+    std::size_t start{ output.find("FINGERPRINT=") };
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS || start == std::string::npos)
+    {
+        return "";
+    }
+    start += 12;
+    return output.substr(start, output.find_first_of("\r\n", start) - start);
+}
+
+/**
+ * Benchmarks fingerprinting the music files in a folder in process against spawning fpcalc for each file
+ *
+ * @param The number of arguments
+ * @param The array of arguments (the folder of music files and optionally the length of audio to fingerprint in seconds)
+ *
+ * @returns The exit code
+ */
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: fingerprint-bench FOLDER [LENGTH]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    unsigned int length{ argc > 2 ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : Fingerprinter::getLength() };
+    Fingerprinter::setLength(length);
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for(std::filesystem::recursive_directory_iterator it{ argv[1], error }; !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+    {
+        if(it->is_regular_file() && MusicFormatRegistry::getInstance().isSupported(it->path()))
+        {
+            paths.push_back(it->path());
+        }
+    }
+    if(paths.empty())
+    {
+        std::cerr << "No music files found." << std::endl;
+        return EXIT_FAILURE;
+    }
+    //Both engines are measured with the files in the page cache, so only decoding and process overhead differ
+    std::array<char, 65536> buffer;
+    for(const std::filesystem::path& path : paths)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        while(file.read(buffer.data(), buffer.size()));
+    }
+    std::vector<std::string> fpcalcFingerprints;
+    std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+    for(const std::filesystem::path& path : paths)
+    {
+        fpcalcFingerprints.push_back(fingerprintWithFpcalc(path, length));
+    }
+    std::chrono::duration<double> fpcalcElapsed{ std::chrono::steady_clock::now() - start };
+    std::size_t matches{ 0 };
+    std::size_t failures{ 0 };
+    start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < paths.size(); i++)
+    {
+        std::string fingerprint{ Fingerprinter::getInstance().fingerprint(paths[i]) };
+        failures += fingerprint.empty();
+        matches += !fingerprint.empty() && fingerprint == fpcalcFingerprints[i];
+    }
+    std::chrono::duration<double> inProcessElapsed{ std::chrono::steady_clock::now() - start };
+    std::cout << "Files: " << paths.size() << ", length: " << length << " s" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "fpcalc subprocess: " << paths.size() / fpcalcElapsed.count() << " files/s" << std::endl;
+    std::cout << "In process:        " << paths.size() / inProcessElapsed.count() << " files/s (" << std::setprecision(2) << fpcalcElapsed.count() / inProcessElapsed.count() << "x)" << std::endl;
+    std::cout << "Identical fingerprints: " << matches << ", in-process failures: " << failures << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <taglib/tpropertymap.h>
+#include "../models/musicformat.hpp"
+
+using namespace NickvisionTagger::Models;
+
+//The fields that are not part of TagLib::Tag, looked up one at a time the way files were read before the single-pass read
+static const char* const PROPERTY_KEYS[]{ "ALBUMARTIST", "DISCNUMBER", "COMPOSER", "BPM", "ISRC", "MUSICBRAINZ_TRACKID", "MUSICBRAINZ_ALBUMID", "LYRICS" };
+
+/**
+ * Reads every tag field of a music file with a lookup per field through TagLib's generic interfaces
+ *
+ * @param path The path of the music file
+ * @param format The format of the music file
+ * @returns The number of non-empty fields read
+ */
+static std::size_t readPerField(const std::filesystem::path& path, const MusicFormat& format)
+{
+    OpenedMusicFile file{ MusicFormatRegistry::getInstance().open(path, format, false) };
+    std::size_t count{ 0 };
+    count += !file.tag->title().isEmpty();
+    count += !file.tag->artist().isEmpty();
+    count += !file.tag->album().isEmpty();
+    count += file.tag->year() != 0;
+    count += file.tag->track() != 0;
+    count += !file.tag->genre().isEmpty();
+    count += !file.tag->comment().isEmpty();
+    for(const char* key : PROPERTY_KEYS)
+    {
+        count += !file.file->properties()[key].isEmpty();
+    }
+    count += !format.tagHandler->getAlbumArt(file.tag).isEmpty();
+    return count;
+}
+
+/**
+ * Reads every tag field of a music file in a single pass over the tag, as MusicFile does
+ *
+ * @param path The path of the music file
+ * @param format The format of the music file
+ * @returns The number of non-empty fields read
+ */
+static std::size_t readSinglePass(const std::filesystem::path& path, const MusicFormat& format)
+{
+    OpenedMusicFile file{ MusicFormatRegistry::getInstance().open(path, format, false) };
+    TagFields fields;
+    format.tagHandler->read(file.tag, fields);
+    std::size_t count{ 0 };
+    count += !fields.title.isEmpty();
+    count += !fields.artist.isEmpty();
+    count += !fields.album.isEmpty();
+    count += fields.year != 0;
+    count += fields.track != 0;
+    count += !fields.genre.isEmpty();
+    count += !fields.comment.isEmpty();
+    count += !fields.albumArtist.isEmpty();
+    count += fields.discNumber != 0;
+    count += !fields.composer.isEmpty();
+    count += fields.bpm != 0;
+    count += !fields.isrc.isEmpty();
+    count += !fields.musicBrainzRecordingId.isEmpty();
+    count += !fields.musicBrainzReleaseId.isEmpty();
+    count += !fields.lyrics.isEmpty();
+    count += !fields.albumArt.isEmpty();
+    return count;
+}
+
+/**
+ * Measures how many files per second a read function gets through
+ *
+ * @param paths The paths of the music files, all of one format
+ * @param format The format of the music files
+ * @param iterations How many times each file is read
+ * @param read The read function
+ * @returns The number of files read per second
+ */
+static double measure(const std::vector<std::filesystem::path>& paths, const MusicFormat& format, unsigned int iterations, std::size_t (*read)(const std::filesystem::path&, const MusicFormat&))
+{
+    std::size_t count{ 0 };
+    std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+    for(unsigned int i = 0; i < iterations; i++)
+    {
+        for(const std::filesystem::path& path : paths)
+        {
+            count += read(path, format);
+        }
+    }
+    std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+    //Keeps the reads from being optimized away
+    if(count == static_cast<std::size_t>(-1))
+    {
+        std::cout << count;
+    }
+    return paths.size() * iterations / elapsed.count();
+}
+
+/**
+ * Benchmarks reading the tags of the music files in a folder, per format, with a lookup per field against the single-pass read
+ *
+ * @param The number of arguments
+ * @param The array of arguments (the folder of music files and optionally the number of iterations)
+ *
+ * @returns The exit code
+ */
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: tagger-bench FOLDER [ITERATIONS]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    unsigned int iterations{ argc > 2 ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : 10u };
+    std::map<std::string, std::pair<const MusicFormat*, std::vector<std::filesystem::path>>> formats;
+    std::error_code error;
+    for(std::filesystem::recursive_directory_iterator it{ argv[1], error }; !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+    {
+        if(it->is_regular_file() && MusicFormatRegistry::getInstance().isSupported(it->path()))
+        {
+            if(const MusicFormat* format{ MusicFormatRegistry::getInstance().getFormat(it->path()) })
+            {
+                formats[format->name].first = format;
+                formats[format->name].second.push_back(it->path());
+            }
+        }
+    }
+    std::cout << std::left << std::setw(10) << "Format" << std::right << std::setw(8) << "Files" << std::setw(16) << "Per field/s" << std::setw(16) << "Single pass/s" << std::setw(10) << "Speedup" << std::endl;
+    for(const std::pair<const std::string, std::pair<const MusicFormat*, std::vector<std::filesystem::path>>>& pair : formats)
+    {
+        const MusicFormat& format{ *pair.second.first };
+        const std::vector<std::filesystem::path>& paths{ pair.second.second };
+        try
+        {
+            //Warms the page cache so both reads are measured from memory
+            measure(paths, format, 1, &readSinglePass);
+            double perField{ measure(paths, format, iterations, &readPerField) };
+            double singlePass{ measure(paths, format, iterations, &readSinglePass) };
+            std::cout << std::left << std::setw(10) << pair.first << std::right << std::setw(8) << paths.size() << std::fixed << std::setprecision(1) << std::setw(16) << perField << std::setw(16) << singlePass << std::setprecision(2) << std::setw(9) << singlePass / perField << "x" << std::endl;
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << pair.first << ": " << e.what() << std::endl;
+        }
+    }
+    return EXIT_SUCCESS;
+}
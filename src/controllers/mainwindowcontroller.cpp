@@ -1,14 +1,29 @@
 #include "mainwindowcontroller.hpp"
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <filesystem>
 #include <future>
 #include <iterator>
+#include <limits>
+#include <thread>
 #include <curlpp/cURLpp.hpp>
 #include "../helpers/mediahelpers.hpp"
 #include "../helpers/stringhelpers.hpp"
 #include "../helpers/translation.hpp"
 #include "../models/acoustidsubmission.hpp"
+#include "../models/albumartstore.hpp"
+#include "../models/duplicatefinder.hpp"
+#include "../models/fingerprinter.hpp"
+#include "../models/librarystore.hpp"
+#include "../models/stringpool.hpp"
+#include "../models/tagfield.hpp"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 using namespace NickvisionTagger::Controllers;
 using namespace NickvisionTagger::Helpers;
@@ -29,7 +44,82 @@ std::vector<std::string> split(const std::string& s, const std::string& delim)
     return result;
 }
 
-MainWindowController::MainWindowController(AppInfo& appInfo, Configuration& configuration) : m_appInfo{ appInfo }, m_configuration{ configuration }, m_isOpened{ false }, m_isDevVersion{ m_appInfo.getVersion().find("-") != std::string::npos }
+/**
+ * Lowers the CPU and I/O priority of the calling thread so that background work does not compete with the UI
+ */
+static void setBackgroundPriority()
+{
+#ifdef __linux__
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+    //ioprio_set has no glibc wrapper: IOPRIO_WHO_PROCESS (1) for the calling thread, IOPRIO_CLASS_IDLE (3)
+    syscall(SYS_ioprio_set, 1, 0, 3 << 13);
+#endif
+}
+
+/**
+ * Gets the StringPool ID that the lowercase form of an interned field must have to match an advanced search value
+ *
+ * @param value The lowercase search value ("empty" to match empty fields)
+ * @returns The ID of the value, or an ID no string has if the pool does not hold the value
+ */
+static std::uint32_t getSearchId(const std::string& value)
+{
+    if(value == "empty")
+    {
+        return StringPool::EMPTY_ID;
+    }
+    return StringPool::getInstance().find(value).value_or(std::numeric_limits<std::uint32_t>::max());
+}
+
+/**
+ * The value an advanced search matches a tag field against
+ */
+struct SearchValue
+{
+    bool isSet{ false };
+    std::string text;
+    std::uint32_t id{ StringPool::EMPTY_ID };
+    std::uint32_t number{ 0 };
+};
+
+MainWindowController::AudioPropertiesScan::~AudioPropertiesScan()
+{
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        pendingMusicFiles.clear();
+    }
+    if(result.valid())
+    {
+        result.wait();
+    }
+}
+
+//How long the selection must rest on a row before its fingerprint is computed, so rows passed over with the arrow keys are never fingerprinted
+static const std::chrono::milliseconds FINGERPRINT_DELAY{ 250 };
+
+MainWindowController::FingerprintJob::~FingerprintJob()
+{
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        requestedMusicFile = nullptr;
+        generation++;
+    }
+    if(result.valid())
+    {
+        result.wait();
+    }
+}
+
+MainWindowController::SaveQueue::~SaveQueue()
+{
+    if(result.valid())
+    {
+        result.wait();
+    }
+}
+
+MainWindowController::MainWindowController(AppInfo& appInfo, Configuration& configuration) : m_appInfo{ appInfo }, m_configuration{ configuration }, m_isOpened{ false }, m_isDevVersion{ m_appInfo.getVersion().find("-") != std::string::npos }, m_audioPropertiesScan{ std::make_shared<AudioPropertiesScan>() }, m_saveQueue{ std::make_shared<SaveQueue>() }, m_fingerprintJob{ std::make_shared<FingerprintJob>() }, m_fingerprintMusicFile{ nullptr }, m_isRescanPending{ false }
 {
 
 }
@@ -59,17 +149,55 @@ void MainWindowController::startup()
     if(!m_isOpened)
     {
         cURLpp::initialize();
-        m_musicFolder.setIncludeSubfolders(m_configuration.getIncludeSubfolders());
-        if(m_configuration.getRememberLastOpenedFolder())
+        m_tagCache = std::make_shared<TagCache>(m_configuration.getConfigDir() + "tagcache.json");
+        m_saveJournal = std::make_shared<SaveJournal>(m_configuration.getConfigDir() + "journal");
+        m_fingerprintCache = std::make_shared<FingerprintCache>(m_configuration.getConfigDir() + "fingerprints");
         {
-            openMusicFolder(m_configuration.getLastOpenedFolder());
+            std::lock_guard<std::mutex> lock{ m_fingerprintJob->mutex };
+            m_fingerprintJob->cache = m_fingerprintCache;
         }
+        m_musicFolder.setTagCache(m_tagCache);
+        m_musicFolder.setIncludeSubfolders(m_configuration.getIncludeSubfolders());
+        AlbumArtStore::getInstance().setBudget(static_cast<std::size_t>(m_configuration.getAlbumArtCacheSize()) * 1024 * 1024);
+        Fingerprinter::setLength(m_configuration.getFingerprintLength());
         m_isOpened = true;
     }
 }
 
+bool MainWindowController::getHasInterruptedSaves() const
+{
+    return m_saveJournal && m_saveJournal->getHasUnfinishedSaves();
+}
+
+void MainWindowController::recoverInterruptedSaves()
+{
+    m_recoveryReport = m_saveJournal->recover(m_configuration.getTagPaddingSize(), *m_tagCache);
+    m_tagCache->save();
+}
+
+void MainWindowController::finishStartup()
+{
+    if(m_recoveryReport.failureCount > 0)
+    {
+        m_sendToastCallback(StringHelpers::format(_("Unable to recover %d of %d interrupted saves."), static_cast<int>(m_recoveryReport.failureCount), static_cast<int>(m_recoveryReport.results.size())));
+    }
+    else if(m_recoveryReport.successCount > 0)
+    {
+        m_sendToastCallback(StringHelpers::format(_("Recovered %d interrupted saves."), static_cast<int>(m_recoveryReport.successCount)));
+    }
+    m_recoveryReport = {};
+    if(m_configuration.getRememberLastOpenedFolder())
+    {
+        openMusicFolder(m_configuration.getLastOpenedFolder());
+    }
+}
+
 bool MainWindowController::getCanClose() const
 {
+    if(getHasQueuedSaves())
+    {
+        return false;
+    }
     for(bool saved : m_musicFilesSaved)
     {
         if(!saved)
@@ -82,8 +210,11 @@ bool MainWindowController::getCanClose() const
 
 void MainWindowController::onConfigurationChanged()
 {
+    AlbumArtStore::getInstance().setBudget(static_cast<std::size_t>(m_configuration.getAlbumArtCacheSize()) * 1024 * 1024);
+    Fingerprinter::setLength(m_configuration.getFingerprintLength());
     if(m_musicFolder.getIncludeSubfolders() != m_configuration.getIncludeSubfolders())
     {
+        cancelLoadingMusicFolder();
         m_musicFolder.setIncludeSubfolders(m_configuration.getIncludeSubfolders());
         m_musicFolderUpdatedCallback(true);
     }
@@ -96,7 +227,7 @@ const std::filesystem::path& MainWindowController::getMusicFolderPath() const
 
 const std::vector<std::shared_ptr<MusicFile>>& MainWindowController::getMusicFiles() const
 {
-    return m_musicFolder.getMusicFiles();
+    return m_musicFolderScan ? m_loadedMusicFiles : m_musicFolder.getMusicFiles();
 }
 
 void MainWindowController::registerMusicFolderUpdatedCallback(const std::function<void(bool)>& callback)
@@ -114,8 +245,14 @@ void MainWindowController::registerMusicFilesSavedUpdatedCallback(const std::fun
     m_musicFilesSavedUpdatedCallback = callback;
 }
 
+void MainWindowController::registerMusicFileChangedCallback(const std::function<void(FolderChangeType, std::size_t)>& callback)
+{
+    m_musicFileChangedCallback = callback;
+}
+
 void MainWindowController::openMusicFolder(const std::string& folderPath)
 {
+    cancelLoadingMusicFolder();
     m_musicFolder.setParentPath(std::filesystem::exists(folderPath) ? folderPath : "");
     if(m_configuration.getRememberLastOpenedFolder())
     {
@@ -125,97 +262,500 @@ void MainWindowController::openMusicFolder(const std::string& folderPath)
     m_musicFolderUpdatedCallback(true);
 }
 
+bool MainWindowController::getIsLoadingMusicFolder() const
+{
+    return m_musicFolderScan != nullptr;
+}
+
 void MainWindowController::reloadMusicFolder()
 {
+    //Queued changes belong to music files that are about to be replaced, so they are written first
+    flushSaveQueue();
+    cancelLoadingAudioProperties();
     m_musicFilesSaved.clear();
-    m_musicFolder.reloadMusicFiles();
-    for(size_t i = 0; i < m_musicFolder.getMusicFiles().size(); i++)
+    m_selectedMusicFiles.clear();
+    m_loadedMusicFiles.clear();
+    m_folderWatcher = nullptr;
+    m_isRescanPending = false;
+    m_musicFolder.setWorkerCount(m_configuration.getScanWorkerCount());
+    m_musicFolderScan = std::make_shared<MusicFolderScan>();
+    std::shared_ptr<MusicFolderScan> scan{ m_musicFolderScan };
+    scan->result = std::async(std::launch::async, [this, scan]()
     {
-        m_musicFilesSaved.push_back(true);
+        //Start watching before the scan so that changes made while scanning are not missed
+        if(!m_musicFolder.getParentPath().empty())
+        {
+            m_folderWatcher = std::make_shared<FolderWatcher>(m_musicFolder.getParentPath(), m_musicFolder.getIncludeSubfolders(), &MusicFolder::isSupportedMusicFile);
+        }
+        try
+        {
+            m_musicFolder.reloadMusicFiles([scan](const std::vector<std::shared_ptr<MusicFile>>& batch) -> bool
+            {
+                std::lock_guard<std::mutex> lock{ scan->mutex };
+                if(scan->isCancelled)
+                {
+                    return false;
+                }
+                scan->loadedMusicFiles.insert(scan->loadedMusicFiles.end(), batch.begin(), batch.end());
+                return true;
+            });
+        }
+        catch(...) { }
+    });
+}
+
+bool MainWindowController::waitForMusicFolderScan(std::chrono::milliseconds timeout) const
+{
+    return !m_musicFolderScan || m_musicFolderScan->result.wait_for(timeout) == std::future_status::ready;
+}
+
+std::size_t MainWindowController::takeLoadedMusicFiles()
+{
+    if(!m_musicFolderScan)
+    {
+        return 0;
     }
+    std::lock_guard<std::mutex> lock{ m_musicFolderScan->mutex };
+    std::size_t count{ m_musicFolderScan->loadedMusicFiles.size() };
+    m_loadedMusicFiles.insert(m_loadedMusicFiles.end(), m_musicFolderScan->loadedMusicFiles.begin(), m_musicFolderScan->loadedMusicFiles.end());
+    m_musicFilesSaved.insert(m_musicFilesSaved.end(), count, true);
+    m_musicFolderScan->loadedMusicFiles.clear();
+    return count;
 }
 
-void MainWindowController::updateTags(const TagMap& tagMap)
+std::vector<std::size_t> MainWindowController::finishLoadingMusicFolder()
 {
-    for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
+    std::vector<std::size_t> previousIndexes;
+    if(!m_musicFolderScan)
     {
-        bool updated{ false };
-        if(tagMap.getFilename() != pair.second->getFilename() && tagMap.getFilename() != "<keep>")
-        {
-            pair.second->setFilename(tagMap.getFilename());
-            updated = true;
-        }
-        if(tagMap.getTitle() != pair.second->getTitle() && tagMap.getTitle() != "<keep>")
+        return previousIndexes;
+    }
+    m_musicFolderScan->result.wait();
+    takeLoadedMusicFiles();
+    m_musicFolderScan = nullptr;
+    //Files were streamed in the order they finished loading, so find where each one ended up in the sorted list
+    std::unordered_map<const MusicFile*, std::size_t> loadedIndexes;
+    for(std::size_t i = 0; i < m_loadedMusicFiles.size(); i++)
+    {
+        loadedIndexes.insert({ m_loadedMusicFiles[i].get(), i });
+    }
+    std::vector<bool> musicFilesSaved;
+    std::unordered_map<int, std::shared_ptr<MusicFile>> selectedMusicFiles;
+    for(const std::shared_ptr<MusicFile>& musicFile : m_musicFolder.getMusicFiles())
+    {
+        std::size_t previousIndex{ loadedIndexes.at(musicFile.get()) };
+        if(m_selectedMusicFiles.contains(static_cast<int>(previousIndex)))
         {
-            pair.second->setTitle(tagMap.getTitle());
-            updated = true;
+            selectedMusicFiles.insert({ static_cast<int>(previousIndexes.size()), musicFile });
         }
-        if(tagMap.getArtist() != pair.second->getArtist() && tagMap.getArtist() != "<keep>")
+        previousIndexes.push_back(previousIndex);
+        musicFilesSaved.push_back(m_musicFilesSaved[previousIndex]);
+    }
+    m_musicFilesSaved = musicFilesSaved;
+    m_selectedMusicFiles = selectedMusicFiles;
+    m_loadedMusicFiles.clear();
+    loadAudioPropertiesInBackground(m_musicFolder.getMusicFiles());
+    return previousIndexes;
+}
+
+void MainWindowController::cancelLoadingMusicFolder()
+{
+    if(m_musicFolderScan)
+    {
         {
-            pair.second->setArtist(tagMap.getArtist());
-            updated = true;
+            std::lock_guard<std::mutex> lock{ m_musicFolderScan->mutex };
+            m_musicFolderScan->isCancelled = true;
         }
-        if(tagMap.getAlbum() != pair.second->getAlbum() && tagMap.getAlbum() != "<keep>")
+        m_musicFolderScan->result.wait();
+    }
+}
+
+bool MainWindowController::applyFolderChanges()
+{
+    //Changes made by a background save (a rename in particular) are only applied once the music files know their new paths
+    if(m_musicFolderScan || !m_folderWatcher || m_saveQueue->result.valid())
+    {
+        return false;
+    }
+    //A rescan put off for unapplied changes runs once the user has applied or discarded them
+    if(m_isRescanPending && getCanClose())
+    {
+        m_musicFolderUpdatedCallback(false);
+        return true;
+    }
+    bool changed{ false };
+    for(const FolderChange& change : m_folderWatcher->takeChanges())
+    {
+        if(change.type == FolderChangeType::Overflow)
         {
-            pair.second->setAlbum(tagMap.getAlbum());
-            updated = true;
+            //Missed changes can only be caught by rescanning the folder, which would throw away unapplied changes, so it waits for them
+            if(getCanClose())
+            {
+                m_musicFolderUpdatedCallback(false);
+                return true;
+            }
+            if(!m_isRescanPending)
+            {
+                m_isRescanPending = true;
+                m_sendToastCallback(_("The music folder changed on disk. It will be reloaded once all changes are applied or discarded."));
+            }
         }
-        if(tagMap.getYear() != std::to_string(pair.second->getYear()) && tagMap.getYear() != "<keep>")
+        else if(change.type == FolderChangeType::Removed)
         {
-            try
+            std::string folderPrefix{ change.path.string() + "/" };
+            std::erase_if(m_saveQueue->pendingMusicFiles, [&](const std::pair<const MusicFile* const, std::shared_ptr<MusicFile>>& pair)
             {
-                pair.second->setYear(MediaHelpers::stoui(tagMap.getYear()));
-                updated = true;
+                const std::string filePath{ pair.second->getPath().string() };
+                if(filePath != change.path.string() && filePath.rfind(folderPrefix, 0) != 0)
+                {
+                    return false;
+                }
+                m_saveQueue->queuedMusicFiles.erase(pair.first);
+                return true;
+            });
+            for(std::size_t index : m_musicFolder.removeMusicFiles(change.path))
+            {
+                m_musicFilesSaved.erase(m_musicFilesSaved.begin() + index);
+                m_musicFileChangedCallback(FolderChangeType::Removed, index);
+                changed = true;
             }
-            catch(...) { }
         }
-        if(tagMap.getTrack() != std::to_string(pair.second->getTrack()) && tagMap.getTrack() != "<keep>")
+        else
         {
-            try
+            //A file replaced by a rename shows up as added, so the type of change is decided by whether the file is already known
+            std::optional<std::size_t> index{ m_musicFolder.getMusicFileIndex(change.path) };
+            if(!index)
             {
-                pair.second->setTrack(MediaHelpers::stoui(tagMap.getTrack()));
-                updated = true;
+                index = m_musicFolder.addMusicFile(change.path);
+                if(index)
+                {
+                    m_musicFilesSaved.insert(m_musicFilesSaved.begin() + *index, true);
+                    m_musicFileChangedCallback(FolderChangeType::Added, *index);
+                    changed = true;
+                }
+            }
+            else if(m_musicFilesSaved[*index] && m_musicFolder.reloadMusicFile(change.path))
+            {
+                m_musicFileChangedCallback(FolderChangeType::Changed, *index);
+                changed = true;
             }
-            catch(...) { }
         }
-        if(tagMap.getAlbumArtist() != pair.second->getAlbumArtist() && tagMap.getAlbumArtist() != "<keep>")
+    }
+    if(changed)
+    {
+        loadAudioPropertiesInBackground(m_musicFolder.getMusicFiles());
+    }
+    return changed;
+}
+
+bool MainWindowController::applyLoadedAudioProperties()
+{
+    if(m_musicFolderScan)
+    {
+        return false;
+    }
+    std::vector<std::pair<std::shared_ptr<MusicFile>, int>> loadedDurations;
+    bool isFinished{ false };
+    {
+        std::lock_guard<std::mutex> lock{ m_audioPropertiesScan->mutex };
+        loadedDurations.swap(m_audioPropertiesScan->loadedDurations);
+        for(const std::pair<std::shared_ptr<MusicFile>, int>& pair : loadedDurations)
         {
-            pair.second->setAlbumArtist(tagMap.getAlbumArtist());
-            updated = true;
+            m_audioPropertiesScan->queuedMusicFiles.erase(pair.first.get());
         }
-        if(tagMap.getGenre() != pair.second->getGenre() && tagMap.getGenre() != "<keep>")
+        isFinished = !m_audioPropertiesScan->isRunning;
+    }
+    if(loadedDurations.empty())
+    {
+        return false;
+    }
+    std::unordered_set<const MusicFile*> updatedMusicFiles;
+    for(const std::pair<std::shared_ptr<MusicFile>, int>& pair : loadedDurations)
+    {
+        pair.first->setDuration(pair.second);
+        //Only the duration is written to the cache, as the file may have unapplied tag changes
+        if(m_tagCache)
+        {
+            m_tagCache->updateDuration(pair.first->getPath(), pair.second);
+        }
+        updatedMusicFiles.insert(pair.first.get());
+    }
+    if(isFinished && m_tagCache)
+    {
+        m_tagCache->save();
+    }
+    for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
+    {
+        if(updatedMusicFiles.contains(pair.second.get()))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MainWindowController::applySaveQueue()
+{
+    if(m_musicFolderScan)
+    {
+        return;
+    }
+    if(m_saveQueue->result.valid())
+    {
+        if(m_saveQueue->result.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready)
+        {
+            return;
+        }
+        finishSaveBatch();
+    }
+    if(!m_saveQueue->pendingMusicFiles.empty() && std::chrono::steady_clock::now() - m_saveQueue->lastChangeTime >= std::chrono::milliseconds(m_configuration.getWriteBehindDelay()))
+    {
+        startSaveBatch();
+    }
+}
+
+void MainWindowController::flushSaveQueue()
+{
+    finishSaveBatch();
+    if(!m_saveQueue->pendingMusicFiles.empty())
+    {
+        startSaveBatch();
+        finishSaveBatch();
+    }
+    if(m_tagCache)
+    {
+        m_tagCache->save();
+    }
+}
+
+bool MainWindowController::getHasQueuedSaves() const
+{
+    return !m_saveQueue->queuedMusicFiles.empty();
+}
+
+bool MainWindowController::getIsMusicFileQueued(std::size_t index) const
+{
+    return m_saveQueue->queuedMusicFiles.contains(getMusicFiles()[index].get());
+}
+
+void MainWindowController::updateMusicFileSaved(int index, const std::shared_ptr<MusicFile>& musicFile)
+{
+    if(m_configuration.getWriteBehind() && musicFile->getHasUnsavedChanges())
+    {
+        //A music file edited again before its save started is saved once, with all of its changes
+        m_saveQueue->pendingMusicFiles.insert({ musicFile.get(), musicFile });
+        m_saveQueue->queuedMusicFiles.insert(musicFile.get());
+        m_saveQueue->lastChangeTime = std::chrono::steady_clock::now();
+    }
+    m_musicFilesSaved[index] = !musicFile->getHasUnsavedChanges() && !m_saveQueue->queuedMusicFiles.contains(musicFile.get());
+}
+
+void MainWindowController::startSaveBatch()
+{
+    if(m_saveQueue->result.valid())
+    {
+        return;
+    }
+    for(const std::pair<const MusicFile* const, std::shared_ptr<MusicFile>>& pair : m_saveQueue->pendingMusicFiles)
+    {
+        if(pair.second->getHasUnsavedChanges())
+        {
+            m_saveQueue->savingMusicFiles.push_back(pair.second);
+            m_saveQueue->savingChanges.push_back(pair.second->takeChanges());
+        }
+        else
+        {
+            m_saveQueue->queuedMusicFiles.erase(pair.first);
+        }
+    }
+    m_saveQueue->pendingMusicFiles.clear();
+    if(m_saveQueue->savingMusicFiles.empty())
+    {
+        return;
+    }
+    //The changes were copied out of the music files, so the music files can keep being edited while the batch is written
+    SaveQueue* queue{ m_saveQueue.get() };
+    TagSaver saver{ m_configuration.getSaveWorkerCount() };
+    saver.setJournal(m_saveJournal);
+    bool preserveModificationTimeStamp{ m_configuration.getPreserveModificationTimeStamp() };
+    unsigned int paddingSize{ m_configuration.getTagPaddingSize() };
+    std::shared_ptr<TagCache> tagCache{ m_tagCache };
+    queue->result = std::async(std::launch::async, [queue, saver, preserveModificationTimeStamp, paddingSize, tagCache]()
+    {
+        SaveReport report{ saver.save(queue->savingChanges, preserveModificationTimeStamp, paddingSize) };
+        //The cache entries of earlier batches are written here rather than on the UI thread as each batch finishes
+        if(tagCache)
+        {
+            tagCache->save();
+        }
+        return report;
+    });
+}
+
+void MainWindowController::finishSaveBatch()
+{
+    if(!m_saveQueue->result.valid())
+    {
+        return;
+    }
+    SaveReport report{ m_saveQueue->result.get() };
+    std::unordered_map<const MusicFile*, std::size_t> indexes;
+    for(std::size_t i = 0; i < getMusicFiles().size(); i++)
+    {
+        indexes.insert({ getMusicFiles()[i].get(), i });
+    }
+    for(std::size_t i = 0; i < m_saveQueue->savingMusicFiles.size(); i++)
+    {
+        const std::shared_ptr<MusicFile>& musicFile{ m_saveQueue->savingMusicFiles[i] };
+        musicFile->finishSave(m_saveQueue->savingChanges[i], report.results[i].success);
+        if(report.results[i].success && m_tagCache)
+        {
+            m_tagCache->update(musicFile->getPath(), musicFile->getTagCacheEntry());
+        }
+        //A music file edited while it was being saved stays queued for the next batch, while one that failed waits for Apply
+        if(!m_saveQueue->pendingMusicFiles.contains(musicFile.get()))
         {
-            pair.second->setGenre(tagMap.getGenre());
-            updated = true;
+            m_saveQueue->queuedMusicFiles.erase(musicFile.get());
         }
-        if(tagMap.getComment() != pair.second->getComment() && tagMap.getComment() != "<keep>")
+        if(std::unordered_map<const MusicFile*, std::size_t>::iterator it{ indexes.find(musicFile.get()) }; it != indexes.end())
         {
-            pair.second->setComment(tagMap.getComment());
-            updated = true;
+            m_musicFilesSaved[it->second] = !musicFile->getHasUnsavedChanges() && !m_saveQueue->queuedMusicFiles.contains(musicFile.get());
         }
-        m_musicFilesSaved[pair.first] = !updated;
+    }
+    m_saveQueue->savingMusicFiles.clear();
+    m_saveQueue->savingChanges.clear();
+    m_musicFilesSavedUpdatedCallback();
+    if(report.failureCount > 0)
+    {
+        m_sendToastCallback(StringHelpers::format(_("Unable to save %d of %d files."), static_cast<int>(report.failureCount), static_cast<int>(report.results.size())));
+    }
+    m_lastSaveReport = std::move(report);
+}
+
+bool MainWindowController::applyComputedFingerprints()
+{
+    std::vector<std::pair<std::shared_ptr<MusicFile>, std::string>> computedFingerprints;
+    {
+        std::lock_guard<std::mutex> lock{ m_fingerprintJob->mutex };
+        computedFingerprints.swap(m_fingerprintJob->computedFingerprints);
+    }
+    bool updated{ false };
+    for(const std::pair<std::shared_ptr<MusicFile>, std::string>& pair : computedFingerprints)
+    {
+        if(!pair.second.empty())
+        {
+            pair.first->setChromaprintFingerprint(pair.second);
+        }
+        if(pair.first.get() == m_fingerprintMusicFile)
+        {
+            m_fingerprintMusicFile = nullptr;
+            updated = m_selectedMusicFiles.size() == 1 && m_selectedMusicFiles.begin()->second == pair.first;
+        }
+    }
+    return updated;
+}
+
+void MainWindowController::updateTags(const TagMap& tagMap)
+{
+    for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
+    {
+        if(tagMap.getFilename() != pair.second->getFilename() && tagMap.getFilename() != "<keep>")
+        {
+            pair.second->setFilename(tagMap.getFilename());
+        }
+        forEachTagField([&](const auto& field)
+        {
+            const std::string& value{ (tagMap.*field.getTagMapValue)() };
+            if(value == "<keep>" || value == tagFieldToString(pair.second->getField(field)))
+            {
+                return;
+            }
+            if constexpr(std::decay_t<decltype(field)>::isNumber)
+            {
+                try
+                {
+                    pair.second->setField(field, static_cast<std::uint32_t>(MediaHelpers::stoui(value)));
+                }
+                catch(...) { }
+            }
+            else
+            {
+                pair.second->setField(field, typename std::decay_t<decltype(field)>::ValueType(value));
+            }
+        });
+        updateMusicFileSaved(pair.first, pair.second);
     }
     m_musicFilesSavedUpdatedCallback();
 }
 
 void MainWindowController::saveTags()
 {
+    //A music file is never saved by a background batch and here at the same time, so the batch is finished and the selected files leave the queue
+    finishSaveBatch();
     for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
     {
-        pair.second->saveTag(m_configuration.getPreserveModificationTimeStamp());
-        m_musicFilesSaved[pair.first] = true;
+        m_saveQueue->pendingMusicFiles.erase(pair.second.get());
+        m_saveQueue->queuedMusicFiles.erase(pair.second.get());
+    }
+    std::vector<int> indexes;
+    std::vector<std::shared_ptr<MusicFile>> musicFiles;
+    for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
+    {
+        //Files without changes have nothing to write, so they are not even opened
+        if(!pair.second->getHasUnsavedChanges())
+        {
+            m_musicFilesSaved[pair.first] = true;
+            continue;
+        }
+        indexes.push_back(pair.first);
+        musicFiles.push_back(pair.second);
+    }
+    TagSaver saver{ m_configuration.getSaveWorkerCount() };
+    saver.setJournal(m_saveJournal);
+    m_lastSaveReport = saver.save(musicFiles, m_configuration.getPreserveModificationTimeStamp(), m_configuration.getTagPaddingSize());
+    for(std::size_t i = 0; i < musicFiles.size(); i++)
+    {
+        if(!m_lastSaveReport.results[i].success)
+        {
+            continue;
+        }
+        m_musicFilesSaved[indexes[i]] = true;
+        if(m_tagCache)
+        {
+            m_tagCache->update(musicFiles[i]->getPath(), musicFiles[i]->getTagCacheEntry());
+        }
+    }
+    if(m_tagCache)
+    {
+        m_tagCache->save();
     }
     m_musicFilesSavedUpdatedCallback();
-    m_sendToastCallback(_("Tags saved successfully."));
+    if(m_lastSaveReport.failureCount > 0)
+    {
+        m_sendToastCallback(StringHelpers::format(_("Unable to save %d of %d files."), static_cast<int>(m_lastSaveReport.failureCount), static_cast<int>(musicFiles.size())));
+    }
+    else
+    {
+        m_sendToastCallback(_("Tags saved successfully."));
+    }
+}
+
+const SaveReport& MainWindowController::getLastSaveReport() const
+{
+    return m_lastSaveReport;
 }
 
 void MainWindowController::discardUnappliedChanges()
 {
+    finishSaveBatch();
     for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
     {
+        m_saveQueue->pendingMusicFiles.erase(pair.second.get());
+        m_saveQueue->queuedMusicFiles.erase(pair.second.get());
         pair.second->loadFromDisk();
         m_musicFilesSaved[pair.first] = true;
     }
+    loadAudioPropertiesInBackground(getMusicFiles());
     m_musicFilesSavedUpdatedCallback();
 }
 
@@ -224,18 +764,19 @@ void MainWindowController::deleteTags()
     for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
     {
         pair.second->removeTag();
-        m_musicFilesSaved[pair.first] = false;
+        updateMusicFileSaved(pair.first, pair.second);
     }
     m_musicFilesSavedUpdatedCallback();
 }
 
 void MainWindowController::insertAlbumArt(const std::string& pathToImage)
 {
-    TagLib::ByteVector byteVector{ MediaHelpers::byteVectorFromFile(pathToImage) };
+    //Store the image once and let every selected file reference the same album art
+    std::shared_ptr<const AlbumArt> albumArt{ AlbumArtStore::getInstance().insert(MediaHelpers::byteVectorFromFile(pathToImage)) };
     for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
     {
-        pair.second->setAlbumArt(byteVector);
-        m_musicFilesSaved[pair.first] = false;
+        pair.second->setAlbumArt(albumArt);
+        updateMusicFileSaved(pair.first, pair.second);
     }
     m_musicFilesSavedUpdatedCallback();
 }
@@ -244,8 +785,8 @@ void MainWindowController::removeAlbumArt()
 {
     for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
     {
-        pair.second->setAlbumArt({});
-        m_musicFilesSaved[pair.first] = false;
+        pair.second->setAlbumArt(TagLib::ByteVector());
+        updateMusicFileSaved(pair.first, pair.second);
     }
     m_musicFilesSavedUpdatedCallback();
 }
@@ -258,7 +799,7 @@ void MainWindowController::filenameToTag(const std::string& formatString)
         if(pair.second->filenameToTag(formatString))
         {
             success++;
-            m_musicFilesSaved[pair.first] = false;
+            updateMusicFileSaved(pair.first, pair.second);
         }
     }
     m_musicFilesSavedUpdatedCallback();
@@ -273,7 +814,7 @@ void MainWindowController::tagToFilename(const std::string& formatString)
         if(pair.second->tagToFilename(formatString))
         {
             success++;
-            m_musicFilesSaved[pair.first] = false;
+            updateMusicFileSaved(pair.first, pair.second);
         }
     }
     m_musicFilesSavedUpdatedCallback();
@@ -324,7 +865,8 @@ void MainWindowController::downloadMusicBrainzMetadata()
             if(future.get())
             {
                 successful++;
-                m_musicFilesSaved[std::next(m_selectedMusicFiles.begin(), j)->first] = false;
+                std::unordered_map<int, std::shared_ptr<MusicFile>>::iterator it{ std::next(m_selectedMusicFiles.begin(), j) };
+                updateMusicFileSaved(it->first, it->second);
             }
             j++;
         }
@@ -333,6 +875,56 @@ void MainWindowController::downloadMusicBrainzMetadata()
     m_sendToastCallback(StringHelpers::format(_("Downloaded metadata for %d files successfully"), successful));
 }
 
+void MainWindowController::fingerprintAllMusicFiles(const std::function<void(std::size_t, std::size_t)>& progressCallback)
+{
+    //The music files of the folder are still being loaded, and are replaced once the load finishes
+    if(getIsLoadingMusicFolder())
+    {
+        return;
+    }
+    std::pair<int, int> result{ fingerprintMissingMusicFiles(progressCallback) };
+    if(result.first < result.second)
+    {
+        m_sendToastCallback(StringHelpers::format(_("Unable to fingerprint %d of %d files."), result.second - result.first, result.second));
+    }
+    else
+    {
+        m_sendToastCallback(StringHelpers::format(_("Fingerprinted %d files successfully."), result.first));
+    }
+}
+
+std::vector<std::vector<std::size_t>> MainWindowController::findDuplicateMusicFiles(const std::function<void(std::size_t, std::size_t)>& progressCallback)
+{
+    if(getIsLoadingMusicFolder())
+    {
+        return {};
+    }
+    fingerprintMissingMusicFiles(progressCallback);
+    const std::vector<std::shared_ptr<MusicFile>>& musicFiles{ m_musicFolder.getMusicFiles() };
+    std::vector<std::vector<std::uint32_t>> fingerprints;
+    fingerprints.reserve(musicFiles.size());
+    for(const std::shared_ptr<MusicFile>& musicFile : musicFiles)
+    {
+        fingerprints.push_back(musicFile->getHasChromaprintFingerprint() ? Fingerprinter::decode(musicFile->getChromaprintFingerprint()) : std::vector<std::uint32_t>());
+    }
+    DuplicateFinder finder{ fingerprints, m_configuration.getFingerprintWorkerCount() };
+    std::vector<std::vector<std::size_t>> groups{ finder.find() };
+    if(groups.empty())
+    {
+        m_sendToastCallback(_("No duplicate files found."));
+    }
+    else
+    {
+        std::size_t count{ 0 };
+        for(const std::vector<std::size_t>& group : groups)
+        {
+            count += group.size();
+        }
+        m_sendToastCallback(StringHelpers::format(_("Found %d duplicate files of %d recordings."), static_cast<int>(count), static_cast<int>(groups.size())));
+    }
+    return groups;
+}
+
 bool MainWindowController::checkIfAcoustIdUserAPIKeyValid()
 {
     return AcoustIdSubmission::checkIfUserAPIKeyValid(m_appInfo.getAcoustIdClientAPIKey(), m_configuration.getAcoustIdUserAPIKey());
@@ -360,8 +952,8 @@ std::pair<bool, std::vector<std::string>> MainWindowController::advancedSearch(c
         return { false, {} };
     }
     std::vector<std::string> splitProperties{ split(s, ";") };
-    std::vector<std::string> properties{ "filename", "title", "artist", "album", "year", "track", "albumartist", "genre", "comment" };
-    TagMap tagMap;
+    std::string filenameSearch;
+    std::array<SearchValue, TAG_FIELD_COUNT> searchValues;
     for(const std::string& property : splitProperties)
     {
         std::vector<std::string> fields{ split(property, "=") };
@@ -371,7 +963,8 @@ std::pair<bool, std::vector<std::string>> MainWindowController::advancedSearch(c
         }
         const std::string& p{ fields[0] };
         std::string v{ fields[1] };
-        if(std::find(properties.begin(), properties.end(), p) == properties.end())
+        std::optional<std::size_t> fieldIndex{ findTagField(p) };
+        if(p != "filename" && !fieldIndex)
         {
             return { false, {} };
         }
@@ -385,234 +978,95 @@ std::pair<bool, std::vector<std::string>> MainWindowController::advancedSearch(c
         {
             v = "empty";
         }
-        if(p == "filename")
-        {
-            tagMap.setFilename(v);
-        }
-        else if(p == "title")
-        {
-            tagMap.setTitle(v);
-        }
-        else if(p == "artist")
+        if(fieldIndex)
         {
-            tagMap.setArtist(v);
+            searchValues[*fieldIndex].isSet = true;
+            searchValues[*fieldIndex].text = v;
         }
-        else if(p == "album")
+        else
         {
-            tagMap.setAlbum(v);
+            filenameSearch = v;
         }
-        else if(p == "year")
+    }
+    //Interned fields are matched by the ID of their lowercase form, so each file only needs integer compares
+    //"empty" matches a number of 0, the same as the value stored for a missing year or track
+    bool isValid{ true };
+    forEachTagField([&](const auto& field)
+    {
+        using ValueType = typename std::decay_t<decltype(field)>::ValueType;
+        SearchValue& searchValue{ searchValues[field.index] };
+        if(!searchValue.isSet)
         {
-            try
-            {
-                if(v != "empty")
-                {
-                    MediaHelpers::stoui(v);
-                }
-            }
-            catch(...)
-            {
-                return { false, {} };
-            }
-            tagMap.setYear(v);
+            return;
         }
-        else if(p == "track")
+        if constexpr(std::is_same_v<ValueType, std::uint32_t>)
         {
             try
             {
-                if(v != "empty")
-                {
-                    MediaHelpers::stoui(v);
-                }
+                searchValue.number = searchValue.text == "empty" ? 0 : MediaHelpers::stoui(searchValue.text);
             }
             catch(...)
             {
-                return { false, {} };
+                isValid = false;
             }
-            tagMap.setTrack(v);
-        }
-        else if(p == "albumartist")
-        {
-            tagMap.setAlbumArtist(v);
         }
-        else if(p == "genre")
+        else if constexpr(std::is_same_v<ValueType, InternedString>)
         {
-            tagMap.setGenre(v);
+            searchValue.id = getSearchId(searchValue.text);
         }
-        else if(p == "comment")
+        else if(searchValue.text == "empty")
         {
-            tagMap.setComment(v);
+            searchValue.text = "";
         }
+    });
+    if(!isValid)
+    {
+        return { false, {} };
     }
+    //Fields are read from the columns of the LibraryStore by row, instead of through the music file objects
+    StringPool& pool{ StringPool::getInstance() };
+    const LibraryColumns& columns{ LibraryStore::getInstance().getColumns() };
     std::vector<std::string> results;
-    for(const std::shared_ptr<MusicFile>& musicFile : m_musicFolder.getMusicFiles())
+    for(const std::shared_ptr<MusicFile>& musicFile : getMusicFiles())
     {
-        if(!tagMap.getFilename().empty())
+        std::uint32_t row{ musicFile->getRow() };
+        if(!filenameSearch.empty())
         {
             std::string value{ musicFile->getFilename() };
             std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if(tagMap.getFilename() == "empty")
+            if(value != (filenameSearch == "empty" ? "" : filenameSearch))
             {
-                if(!value.empty())
-                {
-                    continue;
-                }
-            }
-            else
-            {
-                if(value != tagMap.getFilename())
-                {
-                    continue;
-                }
+                continue;
             }
         }
-        if(!tagMap.getTitle().empty())
+        bool isMatch{ true };
+        forEachTagField([&](const auto& field)
         {
-            std::string value{ musicFile->getTitle() };
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if(tagMap.getTitle() == "empty")
+            using ValueType = typename std::decay_t<decltype(field)>::ValueType;
+            const SearchValue& searchValue{ searchValues[field.index] };
+            if(!isMatch || !searchValue.isSet)
             {
-                if(!value.empty())
-                {
-                    continue;
-                }
+                return;
             }
-            else
+            const ValueType& value{ getTagFieldValue(columns, row, field) };
+            if constexpr(std::is_same_v<ValueType, std::uint32_t>)
             {
-                if(value != tagMap.getTitle())
-                {
-                    continue;
-                }
+                isMatch = value == searchValue.number;
             }
-        }
-        if(!tagMap.getArtist().empty())
-        {
-            std::string value{ musicFile->getArtist() };
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if(tagMap.getArtist() == "empty")
+            else if constexpr(std::is_same_v<ValueType, InternedString>)
             {
-                if(!value.empty())
-                {
-                    continue;
-                }
+                isMatch = pool.getLowercaseId(value.getId()) == searchValue.id;
             }
             else
             {
-                if(value != tagMap.getArtist())
-                {
-                    continue;
-                }
+                std::string lowercase{ value };
+                std::transform(lowercase.begin(), lowercase.end(), lowercase.begin(), ::tolower);
+                isMatch = lowercase == searchValue.text;
             }
-        }
-        if(!tagMap.getAlbum().empty())
+        });
+        if(!isMatch)
         {
-            std::string value{ musicFile->getAlbum() };
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if(tagMap.getAlbum() == "empty")
-            {
-                if(!value.empty())
-                {
-                    continue;
-                }
-            }
-            else
-            {
-                if(value != tagMap.getAlbum())
-                {
-                    continue;
-                }
-            }
-        }
-        if(!tagMap.getYear().empty())
-        {
-            if(tagMap.getYear() == "empty")
-            {
-                if(musicFile->getYear() != 0)
-                {
-                    continue;
-                }
-            }
-            else
-            {
-                if(musicFile->getYear() != MediaHelpers::stoui(tagMap.getYear()))
-                {
-                    continue;
-                }
-            }
-        }
-        if(!tagMap.getTrack().empty())
-        {
-            if(tagMap.getTrack() == "empty")
-            {
-                if(musicFile->getTrack() != 0)
-                {
-                    continue;
-                }
-            }
-            else
-            {
-                if(musicFile->getTrack() != MediaHelpers::stoui(tagMap.getTrack()))
-                {
-                    continue;
-                }
-            }
-        }
-        if(!tagMap.getAlbumArtist().empty())
-        {
-            std::string value{ musicFile->getAlbumArtist() };
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if(tagMap.getAlbumArtist() == "empty")
-            {
-                if(!value.empty())
-                {
-                    continue;
-                }
-            }
-            else
-            {
-                if(value != tagMap.getAlbumArtist())
-                {
-                    continue;
-                }
-            }
-        }
-        if(!tagMap.getGenre().empty())
-        {
-            std::string value{ musicFile->getGenre() };
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if(tagMap.getGenre() == "empty")
-            {
-                if(!value.empty())
-                {
-                    continue;
-                }
-            }
-            else
-            {
-                if(value != tagMap.getGenre())
-                {
-                    continue;
-                }
-            }
-        }
-        if(!tagMap.getComment().empty())
-        {
-            std::string value{ musicFile->getComment() };
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if(tagMap.getComment() == "empty")
-            {
-                if(!value.empty())
-                {
-                    continue;
-                }
-            }
-            else
-            {
-                if(value != tagMap.getComment())
-                {
-                    continue;
-                }
-            }
+            continue;
         }
         std::string filename{ musicFile->getFilename() };
         std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
@@ -637,14 +1091,10 @@ TagMap MainWindowController::getSelectedTagMap() const
     if(m_selectedMusicFiles.size() == 0)
     {
         tagMap.setFilename("");
-        tagMap.setTitle("");
-        tagMap.setArtist("");
-        tagMap.setAlbum("");
-        tagMap.setYear("");
-        tagMap.setTrack("");
-        tagMap.setAlbumArtist("");
-        tagMap.setGenre("");
-        tagMap.setComment("");
+        forEachTagField([&](const auto& field)
+        {
+            (tagMap.*field.setTagMapValue)("");
+        });
         tagMap.setDuration("00:00:00");
         tagMap.setFingerprint("");
         tagMap.setFileSize("0 MB");
@@ -654,89 +1104,61 @@ TagMap MainWindowController::getSelectedTagMap() const
     {
         const std::shared_ptr<MusicFile>& firstMusicFile{ m_selectedMusicFiles.begin()->second };
         tagMap.setFilename(firstMusicFile->getFilename());
-        tagMap.setTitle(firstMusicFile->getTitle());
-        tagMap.setArtist(firstMusicFile->getArtist());
-        tagMap.setAlbum(firstMusicFile->getAlbum());
-        tagMap.setYear(std::to_string(firstMusicFile->getYear()));
-        tagMap.setTrack(std::to_string(firstMusicFile->getTrack()));
-        tagMap.setAlbumArtist(firstMusicFile->getAlbumArtist());
-        tagMap.setGenre(firstMusicFile->getGenre());
-        tagMap.setComment(firstMusicFile->getComment());
+        forEachTagField([&](const auto& field)
+        {
+            (tagMap.*field.setTagMapValue)(tagFieldToString(firstMusicFile->getField(field)));
+        });
         tagMap.setDuration(firstMusicFile->getDurationAsString());
-        tagMap.setFingerprint(firstMusicFile->getChromaprintFingerprint());
+        if(firstMusicFile->getHasChromaprintFingerprint())
+        {
+            tagMap.setFingerprint(firstMusicFile->getChromaprintFingerprint());
+        }
+        else
+        {
+            tagMap.setFingerprint(firstMusicFile.get() == m_fingerprintMusicFile ? _("Calculating...") : "");
+        }
         tagMap.setFileSize(firstMusicFile->getFileSizeAsString());
-        tagMap.setAlbumArt(firstMusicFile->getAlbumArt().isEmpty() ? "noArt" : "hasArt");
+        tagMap.setAlbumArt(firstMusicFile->getHasAlbumArt() ? "hasArt" : "noArt");
     }
     else
     {
         const std::shared_ptr<MusicFile>& firstMusicFile{ m_selectedMusicFiles.begin()->second };
-        bool haveSameTitle{ true };
-        bool haveSameArtist{ true };
-        bool haveSameAlbum{ true };
-        bool haveSameYear{ true };
-        bool haveSameTrack{ true };
-        bool haveSameAlbumArtist{ true };
-        bool haveSameGenre{ true };
-        bool haveSameComment{ true };
+        std::array<bool, TAG_FIELD_COUNT> haveSame;
+        haveSame.fill(true);
         bool haveSameAlbumArt{ true };
         int totalDuration{ 0 };
         std::uintmax_t totalFileSize{ 0 };
+        //Fields are compared and summed from the columns of the LibraryStore by row, instead of through the music file objects
+        const LibraryColumns& columns{ LibraryStore::getInstance().getColumns() };
+        std::uint32_t firstRow{ firstMusicFile->getRow() };
         for(const std::pair<const int, std::shared_ptr<MusicFile>>& pair : m_selectedMusicFiles)
         {
-            if (firstMusicFile->getTitle() != pair.second->getTitle())
-            {
-                haveSameTitle = false;
-            }
-            if (firstMusicFile->getArtist() != pair.second->getArtist())
-            {
-                haveSameArtist = false;
-            }
-            if (firstMusicFile->getAlbum() != pair.second->getAlbum())
-            {
-                haveSameAlbum = false;
-            }
-            if (firstMusicFile->getYear() != pair.second->getYear())
-            {
-                haveSameYear = false;
-            }
-            if (firstMusicFile->getTrack() != pair.second->getTrack())
-            {
-                haveSameTrack = false;
-            }
-            if (firstMusicFile->getAlbumArtist() != pair.second->getAlbumArtist())
-            {
-                haveSameAlbumArtist = false;
-            }
-            if (firstMusicFile->getGenre() != pair.second->getGenre())
+            std::uint32_t row{ pair.second->getRow() };
+            forEachTagField([&](const auto& field)
             {
-                haveSameGenre = false;
-            }
-            if (firstMusicFile->getComment() != pair.second->getComment())
-            {
-                haveSameComment = false;
-            }
-            if  (firstMusicFile->getAlbumArt() != pair.second->getAlbumArt())
+                if(getTagFieldValue(columns, firstRow, field) != getTagFieldValue(columns, row, field))
+                {
+                    haveSame[field.index] = false;
+                }
+            });
+            if (columns.albumArtHashes[firstRow] != columns.albumArtHashes[row] || columns.albumArtSizes[firstRow] != columns.albumArtSizes[row])
             {
                 haveSameAlbumArt = false;
             }
-            totalDuration += pair.second->getDuration();
-            totalFileSize += pair.second->getFileSize();
+            totalDuration += std::max(columns.durations[row], 0);
+            totalFileSize += columns.fileSizes[row];
         }
         tagMap.setFilename("<keep>");
-        tagMap.setTitle(haveSameTitle ? firstMusicFile->getTitle() : "<keep>");
-        tagMap.setArtist(haveSameArtist ? firstMusicFile->getArtist() : "<keep>");
-        tagMap.setAlbum(haveSameAlbum ? firstMusicFile->getAlbum() : "<keep>");
-        tagMap.setYear(haveSameYear ? std::to_string(firstMusicFile->getYear()) : "<keep>");
-        tagMap.setTrack(haveSameTrack ? std::to_string(firstMusicFile->getTrack()) : "<keep>");
-        tagMap.setAlbumArtist(haveSameAlbumArtist ? firstMusicFile->getAlbumArtist() : "<keep>");
-        tagMap.setGenre(haveSameGenre ? firstMusicFile->getGenre() : "<keep>");
-        tagMap.setComment(haveSameComment ? firstMusicFile->getComment() : "<keep>");
+        forEachTagField([&](const auto& field)
+        {
+            (tagMap.*field.setTagMapValue)(haveSame[field.index] ? tagFieldToString(firstMusicFile->getField(field)) : "<keep>");
+        });
         tagMap.setDuration(MediaHelpers::durationToString(totalDuration));
         tagMap.setFingerprint("<keep>");
         tagMap.setFileSize(MediaHelpers::fileSizeToString(totalFileSize));
         if(haveSameAlbumArt)
         {
-            tagMap.setAlbumArt(firstMusicFile->getAlbumArt().isEmpty() ? "noArt" : "hasArt");
+            tagMap.setAlbumArt(firstMusicFile->getHasAlbumArt() ? "hasArt" : "noArt");
         }
         else
         {
@@ -751,7 +1173,179 @@ void MainWindowController::updateSelectedMusicFiles(std::vector<int> indexes)
     m_selectedMusicFiles.clear();
     for(int index : indexes)
     {
-        m_selectedMusicFiles.insert({ index, m_musicFolder.getMusicFiles()[index] });
+        //While the folder is loading, rows are indexes into the loaded music files, as the music folder is still being filled and sorted by the scan
+        m_selectedMusicFiles.insert({ index, getMusicFiles()[index] });
+    }
+    //Only a single selected music file shows its fingerprint, and a request for a row no longer selected is cancelled
+    if(m_selectedMusicFiles.size() == 1 && !m_selectedMusicFiles.begin()->second->getHasChromaprintFingerprint())
+    {
+        requestFingerprint(m_selectedMusicFiles.begin()->second);
+    }
+    else
+    {
+        requestFingerprint(nullptr);
+    }
+}
+
+void MainWindowController::requestFingerprint(const std::shared_ptr<MusicFile>& musicFile)
+{
+    if(musicFile.get() == m_fingerprintMusicFile)
+    {
+        return;
+    }
+    m_fingerprintMusicFile = musicFile.get();
+    std::lock_guard<std::mutex> lock{ m_fingerprintJob->mutex };
+    m_fingerprintJob->requestedMusicFile = musicFile;
+    m_fingerprintJob->requestedPath = musicFile ? musicFile->getPath() : std::filesystem::path();
+    m_fingerprintJob->generation++;
+    if(!musicFile || m_fingerprintJob->isRunning)
+    {
+        return;
     }
+    m_fingerprintJob->isRunning = true;
+    //The job outlives every thread it starts (its destructor waits), so the thread uses it through a plain pointer
+    FingerprintJob* job{ m_fingerprintJob.get() };
+    job->result = std::async(std::launch::async, [job]()
+    {
+        while(true)
+        {
+            std::shared_ptr<FingerprintCache> cache;
+            std::shared_ptr<MusicFile> musicFile;
+            std::filesystem::path path;
+            std::uint64_t generation;
+            {
+                std::lock_guard<std::mutex> lock{ job->mutex };
+                if(!job->requestedMusicFile)
+                {
+                    job->isRunning = false;
+                    return;
+                }
+                cache = job->cache;
+                musicFile = job->requestedMusicFile;
+                path = job->requestedPath;
+                generation = job->generation;
+            }
+            std::this_thread::sleep_for(FINGERPRINT_DELAY);
+            if(job->generation != generation)
+            {
+                continue;
+            }
+            std::function<bool()> isCancelled{ [job, generation]() { return job->generation != generation; } };
+            std::string fingerprint{ cache ? cache->getFingerprint(path, isCancelled) : MusicFile::readChromaprintFingerprint(path, isCancelled) };
+            std::lock_guard<std::mutex> lock{ job->mutex };
+            if(job->generation == generation)
+            {
+                job->computedFingerprints.push_back({ musicFile, fingerprint });
+                job->requestedMusicFile = nullptr;
+            }
+        }
+    });
 }
 
+std::pair<int, int> MainWindowController::fingerprintMissingMusicFiles(const std::function<void(std::size_t, std::size_t)>& progressCallback)
+{
+    std::vector<std::shared_ptr<MusicFile>> musicFiles;
+    std::vector<std::filesystem::path> paths;
+    for(const std::shared_ptr<MusicFile>& musicFile : m_musicFolder.getMusicFiles())
+    {
+        if(!musicFile->getHasChromaprintFingerprint())
+        {
+            musicFiles.push_back(musicFile);
+            paths.push_back(musicFile->getPath());
+        }
+    }
+    std::vector<std::string> fingerprints(musicFiles.size());
+    std::atomic<std::size_t> next{ 0 };
+    std::atomic<std::size_t> done{ 0 };
+    progressCallback(0, musicFiles.size());
+    //Workers take the next music file as they finish one, so a few long files never hold back the rest
+    unsigned int workerCount{ m_configuration.getFingerprintWorkerCount() > 0 ? m_configuration.getFingerprintWorkerCount() : std::max(std::thread::hardware_concurrency(), 1u) };
+    workerCount = static_cast<unsigned int>(std::min<std::size_t>(workerCount, musicFiles.size()));
+    std::vector<std::future<void>> workers;
+    for(unsigned int i = 0; i < workerCount; i++)
+    {
+        workers.push_back(std::async(std::launch::async, [&]()
+        {
+            setBackgroundPriority();
+            for(std::size_t index{ next++ }; index < paths.size(); index = next++)
+            {
+                fingerprints[index] = m_fingerprintCache ? m_fingerprintCache->getFingerprint(paths[index]) : MusicFile::readChromaprintFingerprint(paths[index]);
+                progressCallback(++done, paths.size());
+            }
+        }));
+    }
+    for(std::future<void>& worker : workers)
+    {
+        worker.wait();
+    }
+    int successful{ 0 };
+    for(std::size_t i = 0; i < musicFiles.size(); i++)
+    {
+        if(!fingerprints[i].empty())
+        {
+            musicFiles[i]->setChromaprintFingerprint(fingerprints[i]);
+            successful++;
+        }
+    }
+    if(m_fingerprintCache)
+    {
+        m_fingerprintCache->save();
+    }
+    return { successful, static_cast<int>(musicFiles.size()) };
+}
+
+void MainWindowController::loadAudioPropertiesInBackground(const std::vector<std::shared_ptr<MusicFile>>& musicFiles)
+{
+    std::lock_guard<std::mutex> lock{ m_audioPropertiesScan->mutex };
+    for(const std::shared_ptr<MusicFile>& musicFile : musicFiles)
+    {
+        if(musicFile->getDuration() < 0 && m_audioPropertiesScan->queuedMusicFiles.insert(musicFile.get()).second)
+        {
+            //The path is copied here, as the music file may be renamed on the UI thread while it waits
+            m_audioPropertiesScan->pendingMusicFiles.push_back({ musicFile, musicFile->getPath() });
+        }
+    }
+    if(m_audioPropertiesScan->isRunning || m_audioPropertiesScan->pendingMusicFiles.empty())
+    {
+        return;
+    }
+    m_audioPropertiesScan->isRunning = true;
+    //The scan outlives every thread it starts (its destructor waits), so the thread uses it through a plain pointer
+    AudioPropertiesScan* scan{ m_audioPropertiesScan.get() };
+    scan->result = std::async(std::launch::async, [scan]()
+    {
+        setBackgroundPriority();
+        while(true)
+        {
+            std::pair<std::shared_ptr<MusicFile>, std::filesystem::path> next;
+            {
+                std::lock_guard<std::mutex> lock{ scan->mutex };
+                if(scan->pendingMusicFiles.empty())
+                {
+                    scan->isRunning = false;
+                    return;
+                }
+                next = scan->pendingMusicFiles.front();
+                scan->pendingMusicFiles.pop_front();
+            }
+            int duration{ MusicFile::readDuration(next.second) };
+            std::lock_guard<std::mutex> lock{ scan->mutex };
+            scan->loadedDurations.push_back({ next.first, duration });
+        }
+    });
+}
+
+void MainWindowController::cancelLoadingAudioProperties()
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_audioPropertiesScan->mutex };
+        m_audioPropertiesScan->pendingMusicFiles.clear();
+    }
+    if(m_audioPropertiesScan->result.valid())
+    {
+        m_audioPropertiesScan->result.wait();
+    }
+    std::lock_guard<std::mutex> lock{ m_audioPropertiesScan->mutex };
+    m_audioPropertiesScan->loadedDurations.clear();
+    m_audioPropertiesScan->queuedMusicFiles.clear();
+}
@@ -1,16 +1,28 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
 #include <functional>
+#include <future>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include "preferencesdialogcontroller.hpp"
 #include "../models/appinfo.hpp"
 #include "../models/configuration.hpp"
+#include "../models/fingerprintcache.hpp"
+#include "../models/folderwatcher.hpp"
 #include "../models/musicfile.hpp"
 #include "../models/musicfolder.hpp"
+#include "../models/savejournal.hpp"
+#include "../models/tagcache.hpp"
 #include "../models/tagmap.hpp"
+#include "../models/tagsaver.hpp"
 
 namespace NickvisionTagger::Controllers
 {
@@ -52,9 +64,23 @@ namespace NickvisionTagger::Controllers
     	 */
     	void registerSendToastCallback(const std::function<void(const std::string&)>& callback);
     	/**
-    	 * Runs startup functions
+    	 * Runs startup functions, up to recovering interrupted saves
     	 */
     	void startup();
+    	/**
+    	 * Gets whether or not saves were interrupted by a crash and need recoverInterruptedSaves before the music folder is opened
+    	 *
+    	 * @returns True if there are interrupted saves, else false
+    	 */
+    	bool getHasInterruptedSaves() const;
+    	/**
+    	 * Finishes the saves interrupted by a crash. Slow, so it is run off the main loop between startup and finishStartup
+    	 */
+    	void recoverInterruptedSaves();
+    	/**
+    	 * Runs the startup functions left after recovering interrupted saves, reporting the recovery and opening the last opened folder
+    	 */
+    	void finishStartup();
     	/**
     	 * Gets whether or not the window can close
     	 *
@@ -74,6 +100,8 @@ namespace NickvisionTagger::Controllers
 	 	/**
 	 	 * Gets the list of music files in the music folder
 	 	 *
+	 	 * While the music folder is loading, this is the list of music files taken so far with takeLoadedMusicFiles, in the order they were loaded
+	 	 *
 	 	 * @returns The list of music files in the music folder
 	 	 */
 		const std::vector<std::shared_ptr<NickvisionTagger::Models::MusicFile>>& getMusicFiles() const;
@@ -95,6 +123,12 @@ namespace NickvisionTagger::Controllers
     	 * @param callback A void() function
     	 */
     	void registerMusicFilesSavedUpdatedCallback(const std::function<void()>& callback);
+    	/**
+    	 * Registers a callback for when a single music file is added to, removed from or changed in the music folder by another program
+    	 *
+    	 * @param callback A void(NickvisionTagger::Models::FolderChangeType, std::size_t) function, receiving the type of change and the index of the music file (for removals, the index the file had before it was removed)
+    	 */
+    	void registerMusicFileChangedCallback(const std::function<void(NickvisionTagger::Models::FolderChangeType, std::size_t)>& callback);
     	/**
     	 * Opens a music folder with the given path
     	 * 
@@ -102,17 +136,103 @@ namespace NickvisionTagger::Controllers
     	 */
     	void openMusicFolder(const std::string& folderPath);
     	/**
-    	 * Reloads a music folder
+    	 * Gets whether or not the music folder is loading
+    	 *
+    	 * @returns True if a reload was started and not yet finished with finishLoadingMusicFolder, else false
+    	 */
+    	bool getIsLoadingMusicFolder() const;
+    	/**
+    	 * Starts reloading a music folder in the background
+    	 *
+    	 * While loading, takeLoadedMusicFiles should be called periodically to stream the loaded music files into the list of music files, and finishLoadingMusicFolder once waitForMusicFolderScan returns true
     	 */
     	void reloadMusicFolder();
+    	/**
+    	 * Waits for the background scan of the music folder to complete
+    	 *
+    	 * @param timeout The maximum time to wait
+    	 * @returns True if the scan is complete (or no scan is running), else false
+    	 */
+    	bool waitForMusicFolderScan(std::chrono::milliseconds timeout) const;
+    	/**
+    	 * Appends the music files loaded since the last call to the end of the list of music files
+    	 *
+    	 * @returns The number of music files appended
+    	 */
+    	std::size_t takeLoadedMusicFiles();
+    	/**
+    	 * Finishes loading the music folder, replacing the list of music files with the sorted list
+    	 *
+    	 * The saved status and selection of music files follow the files into their sorted position
+    	 *
+    	 * @returns A list where each element is the index the music file at that position had before sorting
+    	 */
+    	std::vector<std::size_t> finishLoadingMusicFolder();
+    	/**
+    	 * Cancels loading the music folder, waiting for the background scan to stop. The files loaded so far remain and must still be finished with finishLoadingMusicFolder
+    	 */
+    	void cancelLoadingMusicFolder();
+    	/**
+    	 * Applies the changes made to the music folder by other programs since the last call, without reloading the whole folder
+    	 *
+    	 * Files with unapplied changes are not reloaded so that the user's changes are kept. When changes were missed (the watcher overflowed), the folder is reloaded, but only once no music file has unapplied changes
+    	 *
+    	 * @returns True if any music file was added, removed or changed, else false
+    	 */
+    	bool applyFolderChanges();
+    	/**
+    	 * Applies the durations read in the background since the last call to their music files
+    	 *
+    	 * Tags are loaded without audio properties so the list appears quickly, and durations are read afterwards on a low priority thread
+    	 *
+    	 * @returns True if the duration of a selected music file was updated, else false
+    	 */
+    	bool applyLoadedAudioProperties();
+    	/**
+    	 * Applies the results of background saves that finished since the last call, and starts saving the queued changes once edits have paused for the write-behind delay
+    	 *
+    	 * In write-behind mode, edited music files are queued instead of waiting for Apply. Repeated edits to a queued music file are coalesced into a single save
+    	 */
+    	void applySaveQueue();
+    	/**
+    	 * Saves all queued changes right away, waiting for them to be written, and saves the tag cache entries of the written files
+    	 */
+    	void flushSaveQueue();
+    	/**
+    	 * Gets whether or not any music file has changes queued or being saved in the background
+    	 *
+    	 * @returns True if there are queued saves, else false
+    	 */
+    	bool getHasQueuedSaves() const;
+    	/**
+    	 * Gets whether or not a music file has changes queued or being saved in the background
+    	 *
+    	 * @param index The index of the music file
+    	 * @returns True if the music file is queued, else false
+    	 */
+    	bool getIsMusicFileQueued(std::size_t index) const;
+    	/**
+    	 * Applies the fingerprints computed in the background since the last call to their music files
+    	 *
+    	 * The fingerprint of a single selected music file is computed on a background thread, so selecting a row never waits for it
+    	 *
+    	 * @returns True if the fingerprint of the selected music file was computed (or failed to), else false
+    	 */
+    	bool applyComputedFingerprints();
     	/**
     	 * Updates the tags of the selected music files
     	 */
     	void updateTags(const NickvisionTagger::Models::TagMap& tagMap);
     	/**
-    	 * Saves the tags of the selected music files
+    	 * Saves the tags of the selected music files. Music files that fail to save are left unsaved and listed in the save report
     	 */
     	void saveTags();
+    	/**
+    	 * Gets the report of the last call to saveTags
+    	 *
+    	 * @returns The report of the last save
+    	 */
+    	const NickvisionTagger::Models::SaveReport& getLastSaveReport() const;
     	/**
     	 * Discards unapplied changes to the selected music files
     	 */
@@ -147,6 +267,19 @@ namespace NickvisionTagger::Controllers
     	 * Downloads and applys tag metadata from MusicBrainz for the selected files
     	 */
     	void downloadMusicBrainzMetadata();
+    	/**
+    	 * Computes the chromaprint fingerprints of all music files in the folder that do not have one yet, on a bounded number of worker threads. Fingerprints are kept in the fingerprint cache, so files fingerprinted before are not decoded again. Does nothing while the folder is loading
+    	 *
+    	 * @param progressCallback A void(std::size_t done, std::size_t total) function called from the worker threads as music files are fingerprinted
+    	 */
+    	void fingerprintAllMusicFiles(const std::function<void(std::size_t, std::size_t)>& progressCallback);
+    	/**
+    	 * Finds the music files in the folder that hold the same recording (e.g. an MP3 and a FLAC copy) by comparing their chromaprint fingerprints. Music files without a fingerprint are fingerprinted first. Finds nothing while the folder is loading
+    	 *
+    	 * @param progressCallback A void(std::size_t done, std::size_t total) function called from the worker threads as music files are fingerprinted
+    	 * @returns The groups of duplicate music files, as indexes into the music files of the folder
+    	 */
+    	std::vector<std::vector<std::size_t>> findDuplicateMusicFiles(const std::function<void(std::size_t, std::size_t)>& progressCallback);
     	/**
     	 * Checks whether or not the configuration contains a valid AcoustId User API Key
     	 *
@@ -192,15 +325,130 @@ namespace NickvisionTagger::Controllers
     	void updateSelectedMusicFiles(std::vector<int> indexes);
     	
     private:
+    	/**
+    	 * The state shared between the UI thread and a background scan of the music folder
+    	 */
+    	struct MusicFolderScan
+    	{
+    		std::mutex mutex;
+    		std::vector<std::shared_ptr<NickvisionTagger::Models::MusicFile>> loadedMusicFiles;
+    		bool isCancelled{ false };
+    		std::future<void> result;
+    	};
+    	/**
+    	 * The state shared between the UI thread and the background thread reading audio properties
+    	 */
+    	struct AudioPropertiesScan
+    	{
+    		std::mutex mutex;
+    		std::deque<std::pair<std::shared_ptr<NickvisionTagger::Models::MusicFile>, std::filesystem::path>> pendingMusicFiles;
+    		std::unordered_set<const NickvisionTagger::Models::MusicFile*> queuedMusicFiles;
+    		std::vector<std::pair<std::shared_ptr<NickvisionTagger::Models::MusicFile>, int>> loadedDurations;
+    		bool isRunning{ false };
+    		std::future<void> result;
+    		/**
+    		 * Destructs an AudioPropertiesScan, waiting only for the music file being read
+    		 */
+    		~AudioPropertiesScan();
+    	};
+    	/**
+    	 * The state shared between the UI thread and the background thread computing the fingerprint of the selected music file
+    	 */
+    	struct FingerprintJob
+    	{
+    		std::mutex mutex;
+    		std::shared_ptr<NickvisionTagger::Models::FingerprintCache> cache;
+    		std::shared_ptr<NickvisionTagger::Models::MusicFile> requestedMusicFile;
+    		std::filesystem::path requestedPath;
+    		/**
+    		 * Bumped whenever the request changes, which cancels the fingerprint being computed
+    		 */
+    		std::atomic<std::uint64_t> generation{ 0 };
+    		std::vector<std::pair<std::shared_ptr<NickvisionTagger::Models::MusicFile>, std::string>> computedFingerprints;
+    		bool isRunning{ false };
+    		std::future<void> result;
+    		/**
+    		 * Destructs a FingerprintJob, cancelling the fingerprint being computed
+    		 */
+    		~FingerprintJob();
+    	};
+    	/**
+    	 * The changes waiting to be saved in write-behind mode, and the batch of changes being saved in the background
+    	 */
+    	struct SaveQueue
+    	{
+    		std::unordered_map<const NickvisionTagger::Models::MusicFile*, std::shared_ptr<NickvisionTagger::Models::MusicFile>> pendingMusicFiles;
+    		std::unordered_set<const NickvisionTagger::Models::MusicFile*> queuedMusicFiles;
+    		std::chrono::steady_clock::time_point lastChangeTime;
+    		std::vector<std::shared_ptr<NickvisionTagger::Models::MusicFile>> savingMusicFiles;
+    		std::vector<NickvisionTagger::Models::TagChanges> savingChanges;
+    		std::future<NickvisionTagger::Models::SaveReport> result;
+    		/**
+    		 * Destructs a SaveQueue, waiting for the batch being saved
+    		 */
+    		~SaveQueue();
+    	};
     	NickvisionTagger::Models::AppInfo& m_appInfo;
     	NickvisionTagger::Models::Configuration& m_configuration;
     	bool m_isOpened;
     	bool m_isDevVersion;
     	std::function<void(const std::string& message)> m_sendToastCallback;
+    	std::shared_ptr<NickvisionTagger::Models::TagCache> m_tagCache;
+    	std::shared_ptr<NickvisionTagger::Models::SaveJournal> m_saveJournal;
+    	std::shared_ptr<NickvisionTagger::Models::FingerprintCache> m_fingerprintCache;
     	NickvisionTagger::Models::MusicFolder m_musicFolder;
     	std::function<void(bool sendToast)> m_musicFolderUpdatedCallback;
+    	std::shared_ptr<MusicFolderScan> m_musicFolderScan;
+    	std::shared_ptr<AudioPropertiesScan> m_audioPropertiesScan;
+    	std::shared_ptr<SaveQueue> m_saveQueue;
+    	std::shared_ptr<FingerprintJob> m_fingerprintJob;
+    	const NickvisionTagger::Models::MusicFile* m_fingerprintMusicFile;
+    	std::vector<std::shared_ptr<NickvisionTagger::Models::MusicFile>> m_loadedMusicFiles;
     	std::vector<bool> m_musicFilesSaved;
     	std::function<void()> m_musicFilesSavedUpdatedCallback;
+    	std::shared_ptr<NickvisionTagger::Models::FolderWatcher> m_folderWatcher;
+    	std::function<void(NickvisionTagger::Models::FolderChangeType type, std::size_t index)> m_musicFileChangedCallback;
     	std::unordered_map<int, std::shared_ptr<NickvisionTagger::Models::MusicFile>> m_selectedMusicFiles;
+    	NickvisionTagger::Models::SaveReport m_lastSaveReport;
+    	NickvisionTagger::Models::SaveReport m_recoveryReport;
+    	bool m_isRescanPending;
+    	/**
+    	 * Queues the music files whose duration is unknown to have their audio properties read in the background
+    	 *
+    	 * @param musicFiles The music files to check
+    	 */
+    	void loadAudioPropertiesInBackground(const std::vector<std::shared_ptr<NickvisionTagger::Models::MusicFile>>& musicFiles);
+    	/**
+    	 * Computes the chromaprint fingerprints of the music files in the folder that do not have one yet
+    	 *
+    	 * @param progressCallback A void(std::size_t done, std::size_t total) function called from the worker threads as music files are fingerprinted
+    	 * @returns A std::pair<int, int>. The first value is the number of music files fingerprinted successfully, the second the number of music files that needed a fingerprint
+    	 */
+    	std::pair<int, int> fingerprintMissingMusicFiles(const std::function<void(std::size_t, std::size_t)>& progressCallback);
+    	/**
+    	 * Requests the fingerprint of a music file to be computed in the background, cancelling the previous request
+    	 *
+    	 * @param musicFile The music file (nullptr to only cancel)
+    	 */
+    	void requestFingerprint(const std::shared_ptr<NickvisionTagger::Models::MusicFile>& musicFile);
+    	/**
+    	 * Updates the saved status of a music file after it was edited. In write-behind mode, a music file with unsaved changes is queued to be saved in the background
+    	 *
+    	 * @param index The index of the music file
+    	 * @param musicFile The music file
+    	 */
+    	void updateMusicFileSaved(int index, const std::shared_ptr<NickvisionTagger::Models::MusicFile>& musicFile);
+    	/**
+    	 * Starts saving the pending changes in the background
+    	 */
+    	void startSaveBatch();
+    	/**
+    	 * Waits for the batch of changes being saved in the background (if any) and applies its results
+    	 */
+    	void finishSaveBatch();
+    	/**
+    	 * Cancels reading audio properties in the background, waiting for the music file being read and discarding unapplied durations
+    	 */
+    	void cancelLoadingAudioProperties();
     };
 }
\ No newline at end of file
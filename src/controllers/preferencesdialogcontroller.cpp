@@ -58,6 +58,16 @@ void PreferencesDialogController::setOverwriteTagWithMusicBrainz(bool overwriteT
     m_configuration.setOverwriteTagWithMusicBrainz(overwriteTagWithMusicBrainz);
 }
 
+bool PreferencesDialogController::getWriteBehind() const
+{
+    return m_configuration.getWriteBehind();
+}
+
+void PreferencesDialogController::setWriteBehind(bool writeBehind)
+{
+    m_configuration.setWriteBehind(writeBehind);
+}
+
 const std::string& PreferencesDialogController::getAcoustIdUserAPIKey() const
 {
     return m_configuration.getAcoustIdUserAPIKey();
@@ -76,6 +76,18 @@ namespace NickvisionTagger::Controllers
     	 * @param overwriteTagWithMusicBrainz True to overwrite tag, false to preserve already filled-in properties
     	 */
     	void setOverwriteTagWithMusicBrainz(bool overwriteTagWithMusicBrainz);
+    	/**
+    	 * Gets whether or not to save changes to music files automatically in the background
+    	 *
+    	 * @returns True to save changes automatically, else false to save them with Apply
+    	 */
+    	bool getWriteBehind() const;
+    	/**
+    	 * Sets whether or not to save changes to music files automatically in the background
+    	 *
+    	 * @param writeBehind True to save changes automatically, else false to save them with Apply
+    	 */
+    	void setWriteBehind(bool writeBehind);
     	/**
     	 * Gets the AcoustId User API Key
     	 *
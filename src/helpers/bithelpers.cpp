@@ -0,0 +1,75 @@
+#include "bithelpers.hpp"
+#include <bit>
+#include <cstring>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BITHELPERS_HAS_AVX2_KERNEL
+#endif
+
+using namespace NickvisionTagger::Helpers;
+
+/**
+ * Counts the bits that differ between two arrays of 32-bit words, two words at a time
+ *
+ * @param first The first array
+ * @param second The second array
+ * @param count The number of words to compare from each array
+ * @returns The number of differing bits
+ */
+static std::uint64_t hammingDistanceScalar(const std::uint32_t* first, const std::uint32_t* second, std::size_t count)
+{
+    std::uint64_t distance{ 0 };
+    std::size_t i{ 0 };
+    for(; i + 2 <= count; i += 2)
+    {
+        std::uint64_t a;
+        std::uint64_t b;
+        std::memcpy(&a, first + i, sizeof(a));
+        std::memcpy(&b, second + i, sizeof(b));
+        distance += std::popcount(a ^ b);
+    }
+    if(i < count)
+    {
+        distance += std::popcount(first[i] ^ second[i]);
+    }
+    return distance;
+}
+
+#ifdef BITHELPERS_HAS_AVX2_KERNEL
+/**
+ * Counts the bits that differ between two arrays of 32-bit words, eight words at a time. Bytes are counted with a nibble lookup table (vpshufb) and summed with vpsadbw, which outruns scalar popcnt on long arrays
+ *
+ * @param first The first array
+ * @param second The second array
+ * @param count The number of words to compare from each array
+ * @returns The number of differing bits
+ */
+__attribute__((target("avx2"))) static std::uint64_t hammingDistanceAvx2(const std::uint32_t* first, const std::uint32_t* second, std::size_t count)
+{
+    const __m256i lookup{ _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4) };
+    const __m256i lowNibbles{ _mm256_set1_epi8(0x0f) };
+    __m256i totals{ _mm256_setzero_si256() };
+    std::size_t i{ 0 };
+    for(; i + 8 <= count; i += 8)
+    {
+        __m256i bits{ _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + i))) };
+        __m256i lowCounts{ _mm256_shuffle_epi8(lookup, _mm256_and_si256(bits, lowNibbles)) };
+        __m256i highCounts{ _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(bits, 4), lowNibbles)) };
+        totals = _mm256_add_epi64(totals, _mm256_sad_epu8(_mm256_add_epi8(lowCounts, highCounts), _mm256_setzero_si256()));
+    }
+    std::uint64_t distance{ static_cast<std::uint64_t>(_mm256_extract_epi64(totals, 0)) + static_cast<std::uint64_t>(_mm256_extract_epi64(totals, 1)) + static_cast<std::uint64_t>(_mm256_extract_epi64(totals, 2)) + static_cast<std::uint64_t>(_mm256_extract_epi64(totals, 3)) };
+    return distance + hammingDistanceScalar(first + i, second + i, count - i);
+}
+#endif
+
+std::uint64_t BitHelpers::hammingDistance(const std::uint32_t* first, const std::uint32_t* second, std::size_t count)
+{
+#ifdef BITHELPERS_HAS_AVX2_KERNEL
+    static const bool hasAvx2{ __builtin_cpu_supports("avx2") != 0 };
+    if(hasAvx2)
+    {
+        return hammingDistanceAvx2(first, second, count);
+    }
+#endif
+    return hammingDistanceScalar(first, second, count);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NickvisionTagger::Helpers::BitHelpers
+{
+    /**
+     * Counts the bits that differ between two arrays of 32-bit words (the Hamming distance). Uses AVX2 when the processor supports it, else 64-bit popcounts
+     *
+     * @param first The first array
+     * @param second The second array
+     * @param count The number of words to compare from each array
+     * @returns The number of differing bits
+     */
+    std::uint64_t hammingDistance(const std::uint32_t* first, const std::uint32_t* second, std::size_t count);
+}
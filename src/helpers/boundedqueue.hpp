@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace NickvisionTagger::Helpers
+{
+    /**
+     * A thread-safe first-in-first-out queue with a fixed capacity
+     */
+    template<typename T>
+    class BoundedQueue
+    {
+    public:
+    	/**
+    	 * Constructs a BoundedQueue
+    	 *
+    	 * @param capacity The maximum number of items the queue can hold before push blocks
+    	 */
+    	BoundedQueue(std::size_t capacity) : m_capacity{ capacity > 0 ? capacity : 1 }, m_closed{ false }
+    	{
+
+    	}
+    	/**
+    	 * Adds an item to the back of the queue, waiting while the queue is full
+    	 *
+    	 * @param item The item to add
+    	 * @returns True if the item was added, else false if the queue was closed
+    	 */
+    	bool push(T item)
+    	{
+    	    std::unique_lock<std::mutex> lock{ m_mutex };
+    	    m_notFull.wait(lock, [&]() { return m_closed || m_items.size() < m_capacity; });
+    	    if(m_closed)
+    	    {
+    	        return false;
+    	    }
+    	    m_items.push_back(std::move(item));
+    	    m_notEmpty.notify_one();
+    	    return true;
+    	}
+    	/**
+    	 * Removes an item from the front of the queue, waiting while the queue is empty
+    	 *
+    	 * @returns The item, or std::nullopt if the queue was closed and has been drained
+    	 */
+    	std::optional<T> pop()
+    	{
+    	    std::unique_lock<std::mutex> lock{ m_mutex };
+    	    m_notEmpty.wait(lock, [&]() { return m_closed || !m_items.empty(); });
+    	    if(m_items.empty())
+    	    {
+    	        return std::nullopt;
+    	    }
+    	    std::optional<T> item{ std::move(m_items.front()) };
+    	    m_items.pop_front();
+    	    m_notFull.notify_one();
+    	    return item;
+    	}
+    	/**
+    	 * Closes the queue. Pending items can still be popped, but no new items are accepted
+    	 */
+    	void close()
+    	{
+    	    std::lock_guard<std::mutex> lock{ m_mutex };
+    	    m_closed = true;
+    	    m_notEmpty.notify_all();
+    	    m_notFull.notify_all();
+    	}
+
+    private:
+    	std::size_t m_capacity;
+    	bool m_closed;
+    	std::deque<T> m_items;
+    	std::mutex m_mutex;
+    	std::condition_variable m_notEmpty;
+    	std::condition_variable m_notFull;
+    };
+}
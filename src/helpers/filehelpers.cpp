@@ -0,0 +1,499 @@
+#include "filehelpers.hpp"
+#include <algorithm>
+#include <string>
+#include <system_error>
+#include <vector>
+#ifdef __linux__
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+using namespace NickvisionTagger::Helpers;
+
+/**
+ * Gets the start of the filenames of temporary files next to a file
+ *
+ * @param path The path of the file
+ * @returns The start of the filenames
+ */
+static std::string getTemporaryPrefix(const std::filesystem::path& path)
+{
+    return "." + path.filename().string() + ".tagger-";
+}
+
+/**
+ * Gets the path of a temporary file next to a file. The name starts with a dot and ends without a music dot extension, so folder scans and watchers skip it
+ *
+ * @param path The path of the file
+ * @returns The path of the temporary file, ending with XXXXXX for mkstemp
+ */
+static std::string getTemporaryPath(const std::filesystem::path& path)
+{
+    return (path.parent_path() / getTemporaryPrefix(path)).string() + "XXXXXX";
+}
+
+#ifdef __linux__
+//The buffer used where the kernel cannot copy between files itself
+static const std::size_t COPY_BUFFER_SIZE{ 1024 * 1024 };
+
+/**
+ * A file descriptor that is closed when it goes out of scope
+ */
+struct FileDescriptor
+{
+    int fd;
+    ~FileDescriptor()
+    {
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+    }
+};
+
+/**
+ * Throws the error of the last failed system call
+ *
+ * @param message The description of what failed
+ * @param path The path of the file
+ * @throws std::filesystem::filesystem_error Always
+ */
+[[noreturn]] static void throwLastError(const std::string& message, const std::filesystem::path& path)
+{
+    throw std::filesystem::filesystem_error(message, path, std::error_code(errno, std::generic_category()));
+}
+
+/**
+ * Writes data to a file at an offset
+ *
+ * @param fd The file descriptor of the file
+ * @param data The data to write
+ * @param size The size of the data
+ * @param offset The offset to write at
+ * @param path The path of the file
+ * @throws std::filesystem::filesystem_error Thrown when the data could not be written
+ */
+static void writeAll(int fd, const char* data, std::size_t size, std::uint64_t offset, const std::filesystem::path& path)
+{
+    while(size > 0)
+    {
+        ssize_t written{ pwrite(fd, data, size, static_cast<off_t>(offset)) };
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            throwLastError("Unable to write the file", path);
+        }
+        data += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+/**
+ * Copies a range of one file into another. The kernel copies the data with copy_file_range, falling back to a buffer only when the kernel or filesystem does not support it
+ *
+ * @param source The file descriptor of the file to copy from
+ * @param sourceOffset The offset to copy from
+ * @param destination The file descriptor of the file to copy to
+ * @param destinationOffset The offset to copy to
+ * @param length The number of bytes to copy
+ * @param path The path of the file to copy from
+ * @throws std::filesystem::filesystem_error Thrown when the range could not be copied
+ */
+static void copyRange(int source, std::uint64_t sourceOffset, int destination, std::uint64_t destinationOffset, std::uint64_t length, const std::filesystem::path& path)
+{
+    loff_t in{ static_cast<loff_t>(sourceOffset) };
+    loff_t out{ static_cast<loff_t>(destinationOffset) };
+    bool useCopyFileRange{ true };
+    std::vector<char> buffer;
+    while(length > 0)
+    {
+        ssize_t copied{ -1 };
+        if(useCopyFileRange)
+        {
+            copied = copy_file_range(source, &in, destination, &out, length, 0);
+            if(copied < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP))
+            {
+                useCopyFileRange = false;
+                continue;
+            }
+        }
+        else
+        {
+            buffer.resize(COPY_BUFFER_SIZE);
+            copied = pread(source, buffer.data(), std::min<std::uint64_t>(length, buffer.size()), in);
+            if(copied > 0)
+            {
+                writeAll(destination, buffer.data(), copied, out, path);
+                in += copied;
+                out += copied;
+            }
+        }
+        if(copied < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            throwLastError("Unable to copy the file", path);
+        }
+        if(copied == 0)
+        {
+            throw std::filesystem::filesystem_error("The file changed while it was copied", path, std::make_error_code(std::errc::io_error));
+        }
+        length -= copied;
+    }
+}
+
+/**
+ * Makes a file share the extents of another file from an offset to its end
+ *
+ * @param source The file descriptor of the file to share from
+ * @param sourceOffset The offset to share from (a multiple of CLONE_BLOCK_SIZE)
+ * @param destination The file descriptor of the file to share to
+ * @param destinationOffset The offset to share to (a multiple of CLONE_BLOCK_SIZE)
+ * @returns True if the extents are shared, else false if the filesystem does not support it
+ */
+static bool cloneRange(int source, std::uint64_t sourceOffset, int destination, std::uint64_t destinationOffset)
+{
+#ifdef FICLONERANGE
+    //A length of 0 shares everything up to the end of the source, including its last partial block
+    file_clone_range range{ source, sourceOffset, 0, destinationOffset };
+    return ioctl(destination, FICLONERANGE, &range) == 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Syncs a folder, so that files created, renamed or removed in it survive a crash
+ *
+ * @param folder The path of the folder
+ */
+static void syncFolder(const std::filesystem::path& folder)
+{
+    FileDescriptor fd{ open(folder.empty() ? "." : folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) };
+    if(fd.fd >= 0)
+    {
+        fsync(fd.fd);
+    }
+}
+
+/**
+ * Syncs a file and renames it over another, then syncs their folder so the rename survives a crash too
+ *
+ * @param fd The file descriptor of the file
+ * @param temporaryPath The path of the file
+ * @param path The path of the file to replace
+ * @throws std::filesystem::filesystem_error Thrown when the file could not be synced or renamed
+ */
+static void syncAndRename(int fd, const std::filesystem::path& temporaryPath, const std::filesystem::path& path)
+{
+    if(fsync(fd) != 0)
+    {
+        throwLastError("Unable to sync the file", temporaryPath);
+    }
+    if(rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        throwLastError("Unable to replace the file", path);
+    }
+    syncFolder(path.parent_path());
+}
+
+/**
+ * Copies the extended attributes (ACLs included) of one file to another
+ *
+ * @param source The file descriptor of the file to copy from
+ * @param destination The file descriptor of the file to copy to
+ * @returns True if every attribute was copied, else false
+ */
+static bool copyExtendedAttributes(int source, int destination)
+{
+    ssize_t size{ flistxattr(source, nullptr, 0) };
+    if(size < 0)
+    {
+        return errno == ENOTSUP;
+    }
+    std::vector<char> names(size);
+    size = flistxattr(source, names.data(), names.size());
+    if(size < 0)
+    {
+        return false;
+    }
+    std::vector<char> value;
+    for(const char* name = names.data(); name < names.data() + size; name += std::char_traits<char>::length(name) + 1)
+    {
+        ssize_t valueSize{ fgetxattr(source, name, nullptr, 0) };
+        if(valueSize < 0)
+        {
+            return false;
+        }
+        value.resize(valueSize);
+        valueSize = fgetxattr(source, name, value.data(), value.size());
+        if(valueSize < 0 || fsetxattr(destination, name, value.data(), valueSize, 0) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Creates a temporary file to be renamed over a file, with the owner, group, permissions and extended attributes of the file, so the rename keeps everything but the contents of the file
+ *
+ * @param source The file descriptor of the file
+ * @param sourceStat The stat record of the file
+ * @param path The path of the file, with symlinks resolved
+ * @param temporaryPath Set to the path of the temporary file
+ * @returns The file descriptor of the temporary file, or -1 if the file cannot be replaced without splitting its hard links or losing its owner or attributes
+ */
+static int createReplacementFile(int source, const struct stat& sourceStat, const std::filesystem::path& path, std::string& temporaryPath)
+{
+    if(sourceStat.st_nlink > 1)
+    {
+        return -1;
+    }
+    temporaryPath = getTemporaryPath(path);
+    int destination{ mkostemp(temporaryPath.data(), O_CLOEXEC) };
+    if(destination < 0)
+    {
+        return -1;
+    }
+    //The owner is set first, as changing it clears set-user-ID and set-group-ID bits
+    if(fchown(destination, sourceStat.st_uid, sourceStat.st_gid) != 0 || fchmod(destination, sourceStat.st_mode & 07777) != 0 || !copyExtendedAttributes(source, destination))
+    {
+        unlink(temporaryPath.c_str());
+        close(destination);
+        return -1;
+    }
+    return destination;
+}
+#endif
+
+bool FileHelpers::replaceFileStart(const std::filesystem::path& path, const TagLib::ByteVector& start, std::uintmax_t replacedSize)
+{
+#ifdef __linux__
+    //The file a symlink points to is replaced, not the symlink
+    std::filesystem::path target{ std::filesystem::canonical(path) };
+    FileDescriptor source{ open(target.c_str(), O_RDONLY | O_CLOEXEC) };
+    struct stat sourceStat;
+    if(source.fd < 0 || fstat(source.fd, &sourceStat) != 0)
+    {
+        throwLastError("Unable to open the file", path);
+    }
+    std::uint64_t size{ static_cast<std::uint64_t>(sourceStat.st_size) };
+    if(replacedSize > size)
+    {
+        throw std::filesystem::filesystem_error("The replaced start is larger than the file", path, std::make_error_code(std::errc::invalid_argument));
+    }
+    std::string temporaryPath;
+    FileDescriptor destination{ createReplacementFile(source.fd, sourceStat, target, temporaryPath) };
+    if(destination.fd < 0)
+    {
+        return false;
+    }
+    try
+    {
+        writeAll(destination.fd, start.data(), start.size(), 0, temporaryPath);
+        std::uint64_t offset{ replacedSize };
+        std::uint64_t destinationOffset{ start.size() };
+        //Extents can only be shared at block-aligned offsets in both files, so copy up to the first block boundary and share the rest
+        if(offset < size && offset % CLONE_BLOCK_SIZE == destinationOffset % CLONE_BLOCK_SIZE)
+        {
+            std::uint64_t head{ std::min<std::uint64_t>((CLONE_BLOCK_SIZE - offset % CLONE_BLOCK_SIZE) % CLONE_BLOCK_SIZE, size - offset) };
+            copyRange(source.fd, offset, destination.fd, destinationOffset, head, path);
+            offset += head;
+            destinationOffset += head;
+            if(offset < size && cloneRange(source.fd, offset, destination.fd, destinationOffset))
+            {
+                offset = size;
+            }
+        }
+        copyRange(source.fd, offset, destination.fd, destinationOffset, size - offset, path);
+        syncAndRename(destination.fd, temporaryPath, target);
+    }
+    catch(...)
+    {
+        unlink(temporaryPath.c_str());
+        throw;
+    }
+    return true;
+#else
+    std::filesystem::path temporaryPath{ getTemporaryPath(path) };
+    {
+        std::ifstream source{ path, std::ios::binary };
+        std::ofstream destination{ temporaryPath, std::ios::binary | std::ios::trunc };
+        source.seekg(replacedSize);
+        destination.write(start.data(), start.size());
+        destination << source.rdbuf();
+        if(!source || !destination)
+        {
+            destination.close();
+            std::filesystem::remove(temporaryPath);
+            throw std::filesystem::filesystem_error("Unable to replace the file", path, std::make_error_code(std::errc::io_error));
+        }
+    }
+    std::filesystem::rename(temporaryPath, path);
+    return true;
+#endif
+}
+
+std::optional<std::filesystem::path> FileHelpers::reflinkToTemporaryFile(const std::filesystem::path& path)
+{
+#if defined(__linux__) && defined(FICLONE)
+    std::error_code error;
+    std::filesystem::path target{ std::filesystem::canonical(path, error) };
+    if(error)
+    {
+        return std::nullopt;
+    }
+    FileDescriptor source{ open(target.c_str(), O_RDONLY | O_CLOEXEC) };
+    struct stat sourceStat;
+    if(source.fd < 0 || fstat(source.fd, &sourceStat) != 0)
+    {
+        return std::nullopt;
+    }
+    std::string temporaryPath;
+    FileDescriptor destination{ createReplacementFile(source.fd, sourceStat, target, temporaryPath) };
+    if(destination.fd < 0)
+    {
+        return std::nullopt;
+    }
+    if(ioctl(destination.fd, FICLONE, source.fd) != 0)
+    {
+        unlink(temporaryPath.c_str());
+        return std::nullopt;
+    }
+    return temporaryPath;
+#else
+    return std::nullopt;
+#endif
+}
+
+void FileHelpers::commitTemporaryFile(const std::filesystem::path& temporaryPath, const std::filesystem::path& path)
+{
+#ifdef __linux__
+    FileDescriptor temporary{ open(temporaryPath.c_str(), O_RDONLY | O_CLOEXEC) };
+    if(temporary.fd < 0)
+    {
+        throwLastError("Unable to open the file", temporaryPath);
+    }
+    syncAndRename(temporary.fd, temporaryPath, std::filesystem::canonical(path));
+#else
+    std::filesystem::rename(temporaryPath, path);
+#endif
+}
+
+void FileHelpers::removeTemporaryFiles(const std::filesystem::path& path)
+{
+    std::string prefix{ getTemporaryPrefix(path) };
+    std::error_code error;
+    for(std::filesystem::directory_iterator it{ path.has_parent_path() ? path.parent_path() : ".", error }; !error && it != std::filesystem::directory_iterator(); it.increment(error))
+    {
+        if(it->path().filename().string().rfind(prefix, 0) == 0)
+        {
+            std::error_code removeError;
+            std::filesystem::remove(it->path(), removeError);
+        }
+    }
+}
+
+void FileHelpers::writeFile(const std::filesystem::path& path, const char* data, std::size_t size, bool append, bool sync)
+{
+#ifdef __linux__
+    bool isCreated{ !std::filesystem::exists(path) };
+    FileDescriptor file{ open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644) };
+    if(file.fd < 0)
+    {
+        throwLastError("Unable to open the file", path);
+    }
+    while(size > 0)
+    {
+        ssize_t written{ write(file.fd, data, size) };
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            throwLastError("Unable to write the file", path);
+        }
+        data += written;
+        size -= written;
+    }
+    if(sync)
+    {
+        if(fdatasync(file.fd) != 0)
+        {
+            throwLastError("Unable to sync the file", path);
+        }
+        if(isCreated)
+        {
+            syncFolder(path.parent_path());
+        }
+    }
+#else
+    std::ofstream file{ path, std::ios::binary | (append ? std::ios::app : std::ios::trunc) };
+    file.write(data, size);
+    file.flush();
+    if(!file)
+    {
+        throw std::filesystem::filesystem_error("Unable to write the file", path, std::make_error_code(std::errc::io_error));
+    }
+#endif
+}
+
+void FileHelpers::writeFileAt(const std::filesystem::path& path, const char* data, std::size_t size, std::uintmax_t offset)
+{
+#ifdef __linux__
+    FileDescriptor file{ open(path.c_str(), O_WRONLY | O_CLOEXEC) };
+    if(file.fd < 0)
+    {
+        throwLastError("Unable to open the file", path);
+    }
+    writeAll(file.fd, data, size, offset, path);
+    if(fdatasync(file.fd) != 0)
+    {
+        throwLastError("Unable to sync the file", path);
+    }
+#else
+    std::fstream file{ path, std::ios::binary | std::ios::in | std::ios::out };
+    file.seekp(offset);
+    file.write(data, size);
+    file.flush();
+    if(!file)
+    {
+        throw std::filesystem::filesystem_error("Unable to write the file", path, std::make_error_code(std::errc::io_error));
+    }
+#endif
+}
+
+void FileHelpers::syncFile(const std::filesystem::path& path, bool syncFolder)
+{
+#ifdef __linux__
+    FileDescriptor file{ open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+    if(file.fd < 0)
+    {
+        throwLastError("Unable to open the file", path);
+    }
+    if(fsync(file.fd) != 0)
+    {
+        throwLastError("Unable to sync the file", path);
+    }
+    if(syncFolder)
+    {
+        ::syncFolder(path.parent_path());
+    }
+#endif
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <taglib/tbytevector.h>
+
+namespace NickvisionTagger::Helpers::FileHelpers
+{
+    /**
+     * The block size that offsets must be aligned to for a copy to share extents with its source, common to the filesystems that support reflinks (Btrfs, XFS)
+     */
+    inline constexpr std::uintmax_t CLONE_BLOCK_SIZE{ 4096 };
+    /**
+     * Replaces the start of a file, keeping the rest of it. The new file is written next to the old one (the target of a symlink), given the owner, group, permissions and extended attributes of the old one, synced and renamed over it, so a crash leaves either the old or the new file on disk
+     *
+     * The rest of the old file is copied by the kernel without passing through userspace. When the new start differs in size from the old one by whole blocks (CLONE_BLOCK_SIZE), the copy shares its extents with the old file on filesystems that support reflinks
+     *
+     * @param path The path of the file
+     * @param start The new start of the file
+     * @param replacedSize The size of the old start of the file to replace
+     * @returns True if the file was replaced, else false if it cannot be replaced without splitting its hard links or losing its owner or attributes (nothing is written then)
+     * @throws std::filesystem::filesystem_error Thrown when the file could not be replaced
+     */
+    bool replaceFileStart(const std::filesystem::path& path, const TagLib::ByteVector& start, std::uintmax_t replacedSize);
+    /**
+     * Creates a copy of a file next to it (the target of a symlink) that shares the extents of the file, so it takes no time or space until either is written. The copy has the owner, group, permissions and extended attributes of the file
+     *
+     * @param path The path of the file
+     * @returns The path of the copy, or std::nullopt if the filesystem does not support reflinks or the file cannot be replaced without splitting its hard links or losing its owner or attributes
+     */
+    std::optional<std::filesystem::path> reflinkToTemporaryFile(const std::filesystem::path& path);
+    /**
+     * Syncs a temporary file created by reflinkToTemporaryFile and renames it over the file it was copied from (the target of a symlink)
+     *
+     * @param temporaryPath The path of the temporary file
+     * @param path The path of the file to replace
+     * @throws std::filesystem::filesystem_error Thrown when the file could not be replaced
+     */
+    void commitTemporaryFile(const std::filesystem::path& temporaryPath, const std::filesystem::path& path);
+    /**
+     * Removes the temporary files left next to a file by a rewrite that was interrupted (e.g. by a crash)
+     *
+     * @param path The path of the file
+     */
+    void removeTemporaryFiles(const std::filesystem::path& path);
+    /**
+     * Writes data to a file, creating the file if needed
+     *
+     * @param path The path of the file
+     * @param data The data to write
+     * @param size The size of the data
+     * @param append True to append the data to the file, else false to replace the contents of the file
+     * @param sync True to sync the file to disk before returning (and its folder if the file was created), else false
+     * @throws std::filesystem::filesystem_error Thrown when the file could not be written
+     */
+    void writeFile(const std::filesystem::path& path, const char* data, std::size_t size, bool append, bool sync);
+    /**
+     * Writes data over part of an existing file and syncs the data to disk before returning
+     *
+     * @param path The path of the file
+     * @param data The data to write
+     * @param size The size of the data
+     * @param offset The offset in the file to write the data at
+     * @throws std::filesystem::filesystem_error Thrown when the data could not be written or synced
+     */
+    void writeFileAt(const std::filesystem::path& path, const char* data, std::size_t size, std::uintmax_t offset);
+    /**
+     * Syncs a file written in place to disk, along with its time stamps
+     *
+     * @param path The path of the file
+     * @param syncFolder True to also sync the folder of the file (e.g. after the file was renamed), else false
+     * @throws std::filesystem::filesystem_error Thrown when the file could not be synced
+     */
+    void syncFile(const std::filesystem::path& path, bool syncFolder);
+}
@@ -0,0 +1,51 @@
+#include "hashhelpers.hpp"
+#include <cstring>
+
+using namespace NickvisionTagger::Helpers;
+
+std::uint64_t HashHelpers::hash64(const void* data, std::size_t size, std::uint64_t seed)
+{
+    const std::uint64_t m{ 0xc6a4a7935bd1e995ULL };
+    const int r{ 47 };
+    std::uint64_t h{ seed ^ (size * m) };
+    const unsigned char* bytes{ static_cast<const unsigned char*>(data) };
+    const unsigned char* end{ bytes + (size / 8) * 8 };
+    for(; bytes != end; bytes += 8)
+    {
+        std::uint64_t k;
+        std::memcpy(&k, bytes, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    switch(size & 7)
+    {
+    case 7:
+        h ^= std::uint64_t(bytes[6]) << 48;
+        [[fallthrough]];
+    case 6:
+        h ^= std::uint64_t(bytes[5]) << 40;
+        [[fallthrough]];
+    case 5:
+        h ^= std::uint64_t(bytes[4]) << 32;
+        [[fallthrough]];
+    case 4:
+        h ^= std::uint64_t(bytes[3]) << 24;
+        [[fallthrough]];
+    case 3:
+        h ^= std::uint64_t(bytes[2]) << 16;
+        [[fallthrough]];
+    case 2:
+        h ^= std::uint64_t(bytes[1]) << 8;
+        [[fallthrough]];
+    case 1:
+        h ^= std::uint64_t(bytes[0]);
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NickvisionTagger::Helpers::HashHelpers
+{
+    /**
+     * Computes a fast, non-cryptographic 64-bit hash of a block of memory (MurmurHash64A). The result is stable across runs and platforms of the same endianness, so it can be persisted
+     *
+     * @param data The data to hash
+     * @param size The size of the data in bytes
+     * @param seed The seed of the hash
+     * @returns The 64-bit hash of the data
+     */
+    std::uint64_t hash64(const void* data, std::size_t size, std::uint64_t seed = 0);
+}
@@ -0,0 +1,116 @@
+#include "albumartstore.hpp"
+#include "../helpers/hashhelpers.hpp"
+
+using namespace NickvisionTagger::Helpers;
+using namespace NickvisionTagger::Models;
+
+AlbumArtStore& AlbumArtStore::getInstance()
+{
+    static AlbumArtStore instance;
+    return instance;
+}
+
+std::uint64_t AlbumArtStore::hash(const TagLib::ByteVector& data)
+{
+    return HashHelpers::hash64(data.data(), data.size());
+}
+
+AlbumArtStore::AlbumArtStore() : m_budget{ 64 * 1024 * 1024 }, m_recentSize{ 0 }
+{
+
+}
+
+std::size_t AlbumArtStore::getBudget() const
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    return m_budget;
+}
+
+void AlbumArtStore::setBudget(std::size_t budget)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    m_budget = budget;
+    touch(nullptr);
+}
+
+std::shared_ptr<const AlbumArt> AlbumArtStore::get(std::uint64_t hash, std::size_t size)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    std::unordered_map<std::uint64_t, std::weak_ptr<const AlbumArt>>::iterator it{ m_albumArts.find(hash) };
+    if(it == m_albumArts.end())
+    {
+        return nullptr;
+    }
+    std::shared_ptr<const AlbumArt> albumArt{ it->second.lock() };
+    if(!albumArt)
+    {
+        m_albumArts.erase(it);
+        return nullptr;
+    }
+    if(albumArt->data.size() != size)
+    {
+        return nullptr;
+    }
+    touch(albumArt);
+    return albumArt;
+}
+
+std::shared_ptr<const AlbumArt> AlbumArtStore::insert(const TagLib::ByteVector& data)
+{
+    if(data.isEmpty())
+    {
+        return nullptr;
+    }
+    //Hash outside of the lock, as it is the expensive part and needs no shared state
+    std::uint64_t hash{ AlbumArtStore::hash(data) };
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    std::shared_ptr<const AlbumArt> albumArt{ nullptr };
+    std::unordered_map<std::uint64_t, std::weak_ptr<const AlbumArt>>::iterator it{ m_albumArts.find(hash) };
+    if(it != m_albumArts.end())
+    {
+        albumArt = it->second.lock();
+    }
+    //The hash alone does not prove the album art is identical, and different album art with the same hash is kept on its own rather than aliased to the held one
+    if(albumArt && (albumArt->data.size() != data.size() || albumArt->data != data))
+    {
+        return std::make_shared<const AlbumArt>(AlbumArt{ hash, data });
+    }
+    if(!albumArt)
+    {
+        albumArt = std::make_shared<const AlbumArt>(AlbumArt{ hash, data });
+        m_albumArts.insert_or_assign(hash, albumArt);
+    }
+    touch(albumArt);
+    return albumArt;
+}
+
+void AlbumArtStore::touch(const std::shared_ptr<const AlbumArt>& albumArt)
+{
+    if(albumArt && albumArt->data.size() <= m_budget)
+    {
+        std::unordered_map<std::uint64_t, std::list<std::shared_ptr<const AlbumArt>>::iterator>::iterator it{ m_recentIndex.find(albumArt->hash) };
+        if(it != m_recentIndex.end())
+        {
+            m_recent.splice(m_recent.begin(), m_recent, it->second);
+        }
+        else
+        {
+            m_recent.push_front(albumArt);
+            m_recentIndex.insert({ albumArt->hash, m_recent.begin() });
+            m_recentSize += albumArt->data.size();
+        }
+    }
+    while(m_recentSize > m_budget && !m_recent.empty())
+    {
+        std::uint64_t hash{ m_recent.back()->hash };
+        m_recentSize -= m_recent.back()->data.size();
+        m_recentIndex.erase(hash);
+        m_recent.pop_back();
+        //Drop the lookup entry too unless a music file still references the album art
+        std::unordered_map<std::uint64_t, std::weak_ptr<const AlbumArt>>::iterator it{ m_albumArts.find(hash) };
+        if(it != m_albumArts.end() && it->second.expired())
+        {
+            m_albumArts.erase(it);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <taglib/tbytevector.h>
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * Album art held by the AlbumArtStore, identified by a hash of its content
+     */
+    struct AlbumArt
+    {
+    	std::uint64_t hash;
+    	TagLib::ByteVector data;
+    };
+
+    /**
+     * A content-addressed store of album art shared by all music files. Identical album art is held once and referenced by every music file that uses it
+     *
+     * Album art stays in the store while any music file references it, and the most recently used unreferenced album art is kept alive up to a budget of bytes
+     */
+    class AlbumArtStore
+    {
+    public:
+    	/**
+    	 * Gets the AlbumArtStore shared by all music files
+    	 *
+    	 * @returns The AlbumArtStore
+    	 */
+    	static AlbumArtStore& getInstance();
+    	/**
+    	 * Computes the content hash of album art
+    	 *
+    	 * @param data The album art
+    	 * @returns The hash of the album art
+    	 */
+    	static std::uint64_t hash(const TagLib::ByteVector& data);
+    	AlbumArtStore(const AlbumArtStore&) = delete;
+    	AlbumArtStore& operator=(const AlbumArtStore&) = delete;
+    	/**
+    	 * Gets the maximum number of bytes of recently used album art kept alive by the store
+    	 *
+    	 * @returns The budget in bytes
+    	 */
+    	std::size_t getBudget() const;
+    	/**
+    	 * Sets the maximum number of bytes of recently used album art kept alive by the store, evicting the least recently used album art if needed
+    	 *
+    	 * @param budget The new budget in bytes
+    	 */
+    	void setBudget(std::size_t budget);
+    	/**
+    	 * Gets album art by its hash, marking it as most recently used
+    	 *
+    	 * @param hash The hash of the album art
+    	 * @param size The size of the album art (in bytes)
+    	 * @returns The album art if it is still held, else nullptr (also if the album art held for the hash has another size)
+    	 */
+    	std::shared_ptr<const AlbumArt> get(std::uint64_t hash, std::size_t size);
+    	/**
+    	 * Adds album art to the store, marking it as most recently used
+    	 *
+    	 * @param data The album art
+    	 * @returns The album art held by the store (the existing one if identical album art is already held), or nullptr if data is empty. Album art whose hash collides with different album art already held is returned without being added
+    	 */
+    	std::shared_ptr<const AlbumArt> insert(const TagLib::ByteVector& data);
+
+    private:
+    	/**
+    	 * Constructs an AlbumArtStore
+    	 */
+    	AlbumArtStore();
+    	/**
+    	 * Marks album art as most recently used and evicts the least recently used album art until the store fits its budget
+    	 *
+    	 * @param albumArt The album art that was used
+    	 */
+    	void touch(const std::shared_ptr<const AlbumArt>& albumArt);
+    	std::size_t m_budget;
+    	std::size_t m_recentSize;
+    	std::unordered_map<std::uint64_t, std::weak_ptr<const AlbumArt>> m_albumArts;
+    	std::list<std::shared_ptr<const AlbumArt>> m_recent;
+    	std::unordered_map<std::uint64_t, std::list<std::shared_ptr<const AlbumArt>>::iterator> m_recentIndex;
+    	mutable std::mutex m_mutex;
+    };
+}
@@ -6,7 +6,7 @@
 
 using namespace NickvisionTagger::Models;
 
-Configuration::Configuration() : m_configDir{ std::string(g_get_user_config_dir()) + "/Nickvision/NickvisionTagger/" }, m_theme{ Theme::System }, m_includeSubfolders{ true }, m_rememberLastOpenedFolder{ true }, m_lastOpenedFolder{ "" }, m_preserveModificationTimeStamp{ false }, m_overwriteTagWithMusicBrainz{ true }, m_acoustIdUserAPIKey{ "" }
+Configuration::Configuration() : m_configDir{ std::string(g_get_user_config_dir()) + "/Nickvision/NickvisionTagger/" }, m_theme{ Theme::System }, m_includeSubfolders{ true }, m_rememberLastOpenedFolder{ true }, m_lastOpenedFolder{ "" }, m_preserveModificationTimeStamp{ false }, m_overwriteTagWithMusicBrainz{ true }, m_acoustIdUserAPIKey{ "" }, m_writeBehind{ false }, m_writeBehindDelay{ 2000 }, m_scanWorkerCount{ 0 }, m_saveWorkerCount{ 0 }, m_fingerprintWorkerCount{ 0 }, m_tagPaddingSize{ 16384 }, m_albumArtCacheSize{ 64 }, m_fingerprintLength{ 120 }
 {
     if(!std::filesystem::exists(m_configDir))
     {
@@ -24,9 +24,22 @@ Configuration::Configuration() : m_configDir{ std::string(g_get_user_config_dir(
         m_preserveModificationTimeStamp = json.get("PreserveModificationTimeStamp", false).asBool();
         m_overwriteTagWithMusicBrainz = json.get("OverwriteTagWithMusicBrainz", true).asBool();
         m_acoustIdUserAPIKey = json.get("AcoustIdUserAPIKey", "").asString();
+        m_writeBehind = json.get("WriteBehind", false).asBool();
+        m_writeBehindDelay = json.get("WriteBehindDelay", 2000).asUInt();
+        m_scanWorkerCount = json.get("ScanWorkerCount", 0).asUInt();
+        m_saveWorkerCount = json.get("SaveWorkerCount", 0).asUInt();
+        m_fingerprintWorkerCount = json.get("FingerprintWorkerCount", 0).asUInt();
+        m_tagPaddingSize = json.get("TagPaddingSize", 16384).asUInt();
+        m_albumArtCacheSize = json.get("AlbumArtCacheSize", 64).asUInt();
+        m_fingerprintLength = json.get("FingerprintLength", 120).asUInt();
     }
 }
 
+const std::string& Configuration::getConfigDir() const
+{
+    return m_configDir;
+}
+
 Theme Configuration::getTheme() const
 {
     return m_theme;
@@ -98,6 +111,86 @@ void Configuration::setAcoustIdUserAPIKey(const std::string& acoustIdUserAPIKey)
     m_acoustIdUserAPIKey = acoustIdUserAPIKey;
 }
 
+bool Configuration::getWriteBehind() const
+{
+    return m_writeBehind;
+}
+
+void Configuration::setWriteBehind(bool writeBehind)
+{
+    m_writeBehind = writeBehind;
+}
+
+unsigned int Configuration::getWriteBehindDelay() const
+{
+    return m_writeBehindDelay;
+}
+
+void Configuration::setWriteBehindDelay(unsigned int writeBehindDelay)
+{
+    m_writeBehindDelay = writeBehindDelay;
+}
+
+unsigned int Configuration::getScanWorkerCount() const
+{
+    return m_scanWorkerCount;
+}
+
+void Configuration::setScanWorkerCount(unsigned int scanWorkerCount)
+{
+    m_scanWorkerCount = scanWorkerCount;
+}
+
+unsigned int Configuration::getSaveWorkerCount() const
+{
+    return m_saveWorkerCount;
+}
+
+void Configuration::setSaveWorkerCount(unsigned int saveWorkerCount)
+{
+    m_saveWorkerCount = saveWorkerCount;
+}
+
+unsigned int Configuration::getFingerprintWorkerCount() const
+{
+    return m_fingerprintWorkerCount;
+}
+
+void Configuration::setFingerprintWorkerCount(unsigned int fingerprintWorkerCount)
+{
+    m_fingerprintWorkerCount = fingerprintWorkerCount;
+}
+
+unsigned int Configuration::getTagPaddingSize() const
+{
+    return m_tagPaddingSize;
+}
+
+void Configuration::setTagPaddingSize(unsigned int tagPaddingSize)
+{
+    m_tagPaddingSize = tagPaddingSize;
+}
+
+unsigned int Configuration::getAlbumArtCacheSize() const
+{
+    return m_albumArtCacheSize;
+}
+
+void Configuration::setAlbumArtCacheSize(unsigned int albumArtCacheSize)
+{
+    m_albumArtCacheSize = albumArtCacheSize;
+}
+
+unsigned int Configuration::getFingerprintLength() const
+{
+    return m_fingerprintLength;
+}
+
+void Configuration::setFingerprintLength(unsigned int fingerprintLength)
+{
+    m_fingerprintLength = fingerprintLength;
+}
+
 void Configuration::save() const
 {
     std::ofstream configFile{ m_configDir + "config.json" };
@@ -111,6 +204,14 @@ void Configuration::save() const
         json["PreserveModificationTimeStamp"] = m_preserveModificationTimeStamp;
         json["OverwriteTagWithMusicBrainz"] = m_overwriteTagWithMusicBrainz;
         json["AcoustIdUserAPIKey"] = m_acoustIdUserAPIKey;
+        json["WriteBehind"] = m_writeBehind;
+        json["WriteBehindDelay"] = m_writeBehindDelay;
+        json["ScanWorkerCount"] = m_scanWorkerCount;
+        json["SaveWorkerCount"] = m_saveWorkerCount;
+        json["FingerprintWorkerCount"] = m_fingerprintWorkerCount;
+        json["TagPaddingSize"] = m_tagPaddingSize;
+        json["AlbumArtCacheSize"] = m_albumArtCacheSize;
+        json["FingerprintLength"] = m_fingerprintLength;
         configFile << json;
     }
 }
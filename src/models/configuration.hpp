@@ -24,6 +24,12 @@ namespace NickvisionTagger::Models
     	 * Constructs a Configuration (loading the configuraton from disk)
     	 */
     	Configuration();
+    	/**
+    	 * Gets the directory where the application's configuration and data files are stored
+    	 *
+    	 * @returns The configuration directory (ends with a path separator)
+    	 */
+    	const std::string& getConfigDir() const;
     	/**
     	 * Gets the requested theme
     	 *
@@ -108,6 +114,102 @@ namespace NickvisionTagger::Models
     	 * @param acoustIdUserAPIKey The new AcoustId User API Key
     	 */
     	void setAcoustIdUserAPIKey(const std::string& acoustIdUserAPIKey);
+    	/**
+    	 * Gets whether or not to save changes to music files automatically in the background
+    	 *
+    	 * @returns True to save changes automatically, else false to save them with Apply
+    	 */
+    	bool getWriteBehind() const;
+    	/**
+    	 * Sets whether or not to save changes to music files automatically in the background
+    	 *
+    	 * @param writeBehind True to save changes automatically, else false to save them with Apply
+    	 */
+    	void setWriteBehind(bool writeBehind);
+    	/**
+    	 * Gets how long edits must pause before changes are saved automatically
+    	 *
+    	 * @returns The delay in milliseconds
+    	 */
+    	unsigned int getWriteBehindDelay() const;
+    	/**
+    	 * Sets how long edits must pause before changes are saved automatically
+    	 *
+    	 * @param writeBehindDelay The new delay in milliseconds
+    	 */
+    	void setWriteBehindDelay(unsigned int writeBehindDelay);
+    	/**
+    	 * Gets the number of worker threads to use when scanning a music folder
+    	 *
+    	 * @returns The number of worker threads (0 to use one per hardware thread)
+    	 */
+    	unsigned int getScanWorkerCount() const;
+    	/**
+    	 * Sets the number of worker threads to use when scanning a music folder
+    	 *
+    	 * @param scanWorkerCount The new number of worker threads (0 to use one per hardware thread)
+    	 */
+    	void setScanWorkerCount(unsigned int scanWorkerCount);
+    	/**
+    	 * Gets the number of worker threads to use when saving tags
+    	 *
+    	 * @returns The number of worker threads (0 to use one per hardware thread)
+    	 */
+    	unsigned int getSaveWorkerCount() const;
+    	/**
+    	 * Sets the number of worker threads to use when saving tags
+    	 *
+    	 * @param saveWorkerCount The new number of worker threads (0 to use one per hardware thread)
+    	 */
+    	void setSaveWorkerCount(unsigned int saveWorkerCount);
+    	/**
+    	 * Gets the number of worker threads to use when fingerprinting all music files
+    	 *
+    	 * @returns The number of worker threads (0 to use one per hardware thread)
+    	 */
+    	unsigned int getFingerprintWorkerCount() const;
+    	/**
+    	 * Sets the number of worker threads to use when fingerprinting all music files
+    	 *
+    	 * @param fingerprintWorkerCount The new number of worker threads (0 to use one per hardware thread)
+    	 */
+    	void setFingerprintWorkerCount(unsigned int fingerprintWorkerCount);
+    	/**
+    	 * Gets the padding to reserve in a tag that outgrows its space, so later saves can rewrite the tag in place
+    	 *
+    	 * @returns The padding size in bytes
+    	 */
+    	unsigned int getTagPaddingSize() const;
+    	/**
+    	 * Sets the padding to reserve in a tag that outgrows its space, so later saves can rewrite the tag in place
+    	 *
+    	 * @param tagPaddingSize The new padding size in bytes
+    	 */
+    	void setTagPaddingSize(unsigned int tagPaddingSize);
+    	/**
+    	 * Gets the maximum amount of album art to keep in memory
+    	 *
+    	 * @returns The album art cache size in megabytes
+    	 */
+    	unsigned int getAlbumArtCacheSize() const;
+    	/**
+    	 * Sets the maximum amount of album art to keep in memory
+    	 *
+    	 * @param albumArtCacheSize The new album art cache size in megabytes
+    	 */
+    	void setAlbumArtCacheSize(unsigned int albumArtCacheSize);
+    	/**
+    	 * Gets the length of audio fingerprinted from the start of each music file
+    	 *
+    	 * @returns The fingerprint length in seconds (0 for whole files)
+    	 */
+    	unsigned int getFingerprintLength() const;
+    	/**
+    	 * Sets the length of audio fingerprinted from the start of each music file
+    	 *
+    	 * @param fingerprintLength The new fingerprint length in seconds (0 for whole files)
+    	 */
+    	void setFingerprintLength(unsigned int fingerprintLength);
     	/**
     	 * Saves the configuration to disk
     	 */
@@ -122,5 +224,13 @@ namespace NickvisionTagger::Models
     	bool m_preserveModificationTimeStamp;
     	bool m_overwriteTagWithMusicBrainz;
     	std::string m_acoustIdUserAPIKey;
+    	bool m_writeBehind;
+    	unsigned int m_writeBehindDelay;
+    	unsigned int m_scanWorkerCount;
+    	unsigned int m_saveWorkerCount;
+    	unsigned int m_fingerprintWorkerCount;
+    	unsigned int m_tagPaddingSize;
+    	unsigned int m_albumArtCacheSize;
+    	unsigned int m_fingerprintLength;
     };
 }
\ No newline at end of file
@@ -0,0 +1,388 @@
+#include "directoryscanner.hpp"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <system_error>
+#include <vector>
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#define HAS_IO_URING
+#endif
+#endif
+
+using namespace NickvisionTagger::Models;
+
+#ifdef __linux__
+//How many files of a directory are stat'ed (and reported) at once
+static const unsigned int STAT_BATCH_SIZE{ 64 };
+static const unsigned int STATX_FIELDS{ STATX_SIZE | STATX_MTIME | STATX_INO };
+
+/**
+ * Converts the result of a statx call to a FileStat
+ *
+ * @param result The result of the statx call
+ * @returns The FileStat
+ */
+static FileStat toFileStat(const struct statx& result)
+{
+    FileStat stat;
+    stat.size = result.stx_size;
+    stat.modificationTime = std::chrono::file_clock::from_sys(std::chrono::sys_time<std::chrono::nanoseconds>{ std::chrono::seconds{ result.stx_mtime.tv_sec } + std::chrono::nanoseconds{ result.stx_mtime.tv_nsec } });
+    stat.inode = result.stx_ino;
+    return stat;
+}
+
+/**
+ * Stats a file with a statx call
+ *
+ * @param dirFd The file descriptor of the directory the name is relative to (or AT_FDCWD)
+ * @param name The name of the file
+ * @returns The metadata of the file, or std::nullopt if it could not be stat'ed
+ */
+static std::optional<FileStat> statFile(int dirFd, const char* name)
+{
+    struct statx result;
+    if(statx(dirFd, name, 0, STATX_FIELDS, &result) != 0)
+    {
+        return std::nullopt;
+    }
+    return toFileStat(result);
+}
+
+#ifdef HAS_IO_URING
+/**
+ * A minimal io_uring instance used to submit batches of statx calls. The kernel runs the calls of a batch concurrently, which overlaps their round trips on network filesystems
+ */
+class StatxRing
+{
+public:
+    /**
+     * Constructs a StatxRing
+     *
+     * @param entries The number of statx calls that can be submitted at once
+     */
+    StatxRing(unsigned int entries) : m_fd{ -1 }, m_sqRing{ MAP_FAILED }, m_cqRing{ MAP_FAILED }, m_sqRingSize{ 0 }, m_cqRingSize{ 0 }, m_sqes{ static_cast<io_uring_sqe*>(MAP_FAILED) }, m_sqesSize{ 0 }
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        //Fails in sandboxes and on kernels where io_uring is disabled, in which case batches are stat'ed one call at a time
+        m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if(m_fd < 0)
+        {
+            m_fd = -1;
+            return;
+        }
+        m_entries = params.sq_entries;
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if(params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            m_sqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+        }
+        m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        if(m_sqRing != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP))
+        {
+            m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        }
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES));
+        char* cqRing{ static_cast<char*>(params.features & IORING_FEAT_SINGLE_MMAP ? m_sqRing : m_cqRing) };
+        if(m_sqRing == MAP_FAILED || cqRing == MAP_FAILED || m_sqes == MAP_FAILED)
+        {
+            release();
+            return;
+        }
+        m_sqTail = reinterpret_cast<unsigned int*>(static_cast<char*>(m_sqRing) + params.sq_off.tail);
+        m_sqMask = reinterpret_cast<unsigned int*>(static_cast<char*>(m_sqRing) + params.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned int*>(static_cast<char*>(m_sqRing) + params.sq_off.array);
+        m_cqHead = reinterpret_cast<unsigned int*>(cqRing + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned int*>(cqRing + params.cq_off.tail);
+        m_cqMask = reinterpret_cast<unsigned int*>(cqRing + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+        m_results.resize(m_entries);
+    }
+
+    /**
+     * Destructs a StatxRing
+     */
+    ~StatxRing()
+    {
+        release();
+    }
+
+    StatxRing(const StatxRing&) = delete;
+    StatxRing& operator=(const StatxRing&) = delete;
+
+    /**
+     * Gets whether or not io_uring is available
+     *
+     * @returns True if available, else false
+     */
+    bool isAvailable() const
+    {
+        return m_fd != -1;
+    }
+
+    /**
+     * Stats a batch of files in a directory. Files the ring could not stat are left as std::nullopt
+     *
+     * @param dirFd The file descriptor of the directory the names are relative to
+     * @param names The names of the files (at most the number of entries of the ring)
+     * @param stats The list to fill with the metadata of each file
+     * @returns True if the batch completed, else false if the ring failed (and is no longer available)
+     */
+    bool stat(int dirFd, const std::vector<std::string>& names, std::vector<std::optional<FileStat>>& stats)
+    {
+        unsigned int count{ static_cast<unsigned int>(std::min<std::size_t>(names.size(), m_entries)) };
+        unsigned int tail{ *m_sqTail };
+        for(unsigned int i = 0; i < count; i++)
+        {
+            unsigned int index{ (tail + i) & *m_sqMask };
+            io_uring_sqe& sqe{ m_sqes[index] };
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_STATX;
+            sqe.fd = dirFd;
+            sqe.addr = reinterpret_cast<std::uint64_t>(names[i].c_str());
+            sqe.len = STATX_FIELDS;
+            sqe.off = reinterpret_cast<std::uint64_t>(&m_results[i]);
+            sqe.user_data = i;
+            m_sqArray[index] = index;
+        }
+        __atomic_store_n(m_sqTail, tail + count, __ATOMIC_RELEASE);
+        unsigned int toSubmit{ count };
+        unsigned int completed{ 0 };
+        while(completed < count)
+        {
+            int entered{ static_cast<int>(syscall(__NR_io_uring_enter, m_fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0)) };
+            if(entered < 0)
+            {
+                if(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                {
+                    continue;
+                }
+                //Calls already submitted may still write to the results, so the ring is abandoned rather than reused
+                close(m_fd);
+                m_fd = -1;
+                return false;
+            }
+            toSubmit -= std::min(static_cast<unsigned int>(entered), toSubmit);
+            unsigned int head{ *m_cqHead };
+            unsigned int cqTail{ __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE) };
+            for(; head != cqTail; head++)
+            {
+                const io_uring_cqe& cqe{ m_cqes[head & *m_cqMask] };
+                std::size_t i{ static_cast<std::size_t>(cqe.user_data) };
+                if(cqe.res == 0)
+                {
+                    stats[i] = toFileStat(m_results[i]);
+                }
+                else if(cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP)
+                {
+                    //Kernels older than 5.6 have io_uring without IORING_OP_STATX
+                    stats[i] = statFile(dirFd, names[i].c_str());
+                }
+                completed++;
+            }
+            __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+private:
+    /**
+     * Unmaps the rings and closes the io_uring instance
+     */
+    void release()
+    {
+        if(m_sqes != MAP_FAILED)
+        {
+            munmap(m_sqes, m_sqesSize);
+            m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        }
+        if(m_cqRing != MAP_FAILED)
+        {
+            munmap(m_cqRing, m_cqRingSize);
+            m_cqRing = MAP_FAILED;
+        }
+        if(m_sqRing != MAP_FAILED)
+        {
+            munmap(m_sqRing, m_sqRingSize);
+            m_sqRing = MAP_FAILED;
+        }
+        if(m_fd != -1)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    int m_fd;
+    unsigned int m_entries;
+    void* m_sqRing;
+    void* m_cqRing;
+    std::size_t m_sqRingSize;
+    std::size_t m_cqRingSize;
+    io_uring_sqe* m_sqes;
+    std::size_t m_sqesSize;
+    unsigned int* m_sqTail;
+    unsigned int* m_sqMask;
+    unsigned int* m_sqArray;
+    unsigned int* m_cqHead;
+    unsigned int* m_cqTail;
+    unsigned int* m_cqMask;
+    io_uring_cqe* m_cqes;
+    std::vector<struct statx> m_results;
+};
+#endif
+#endif
+
+DirectoryScanner::DirectoryScanner(const std::filesystem::path& folderPath, bool includeSubfolders, const std::function<bool(const std::filesystem::path&)>& filter) : m_folderPath{ folderPath }, m_includeSubfolders{ includeSubfolders }, m_filter{ filter }
+{
+
+}
+
+std::optional<FileStat> DirectoryScanner::stat(const std::filesystem::path& path)
+{
+#ifdef __linux__
+    return statFile(AT_FDCWD, path.c_str());
+#else
+    std::error_code sizeError;
+    std::error_code timeError;
+    FileStat stat;
+    stat.size = std::filesystem::file_size(path, sizeError);
+    stat.modificationTime = std::filesystem::last_write_time(path, timeError);
+    if(sizeError || timeError)
+    {
+        return std::nullopt;
+    }
+    return stat;
+#endif
+}
+
+void DirectoryScanner::scan(const std::function<bool(const ScannedFile&)>& callback) const
+{
+#ifdef __linux__
+#ifdef HAS_IO_URING
+    StatxRing ring{ STAT_BATCH_SIZE };
+#endif
+    std::vector<std::filesystem::path> folders{ m_folderPath };
+    std::vector<std::uint64_t> buffer(4096);
+    std::vector<std::string> names;
+    std::vector<std::string> batchNames;
+    std::vector<std::optional<FileStat>> batchStats;
+    while(!folders.empty())
+    {
+        std::filesystem::path folder{ std::move(folders.back()) };
+        folders.pop_back();
+        int dirFd{ open(folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) };
+        if(dirFd == -1)
+        {
+            if(folder == m_folderPath)
+            {
+                throw std::filesystem::filesystem_error("Unable to open folder", folder, std::error_code(errno, std::generic_category()));
+            }
+            continue;
+        }
+        //Read all entries of the directory first, d_type tells files from subfolders without a stat in most filesystems
+        names.clear();
+        ssize_t bytesRead;
+        while((bytesRead = getdents64(dirFd, buffer.data(), buffer.size() * sizeof(std::uint64_t))) > 0)
+        {
+            for(ssize_t offset = 0; offset < bytesRead;)
+            {
+                const struct dirent64* entry{ reinterpret_cast<const struct dirent64*>(reinterpret_cast<const char*>(buffer.data()) + offset) };
+                offset += entry->d_reclen;
+                if(std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0)
+                {
+                    continue;
+                }
+                unsigned char type{ entry->d_type };
+                if(type == DT_UNKNOWN)
+                {
+                    struct stat result;
+                    if(fstatat(dirFd, entry->d_name, &result, AT_SYMLINK_NOFOLLOW) != 0)
+                    {
+                        continue;
+                    }
+                    type = S_ISDIR(result.st_mode) ? DT_DIR : S_ISLNK(result.st_mode) ? DT_LNK : S_ISREG(result.st_mode) ? DT_REG : DT_UNKNOWN;
+                }
+                if(type == DT_DIR)
+                {
+                    if(m_includeSubfolders)
+                    {
+                        folders.push_back(folder / entry->d_name);
+                    }
+                }
+                else if((type == DT_REG || type == DT_LNK) && m_filter(folder / entry->d_name))
+                {
+                    names.push_back(entry->d_name);
+                }
+            }
+        }
+        //Stat the files in batches relative to the directory, reporting each batch before the next one so loading can start early in large directories
+        for(std::size_t first = 0; first < names.size(); first += STAT_BATCH_SIZE)
+        {
+            batchNames.assign(names.begin() + first, names.begin() + std::min<std::size_t>(first + STAT_BATCH_SIZE, names.size()));
+            batchStats.assign(batchNames.size(), std::nullopt);
+#ifdef HAS_IO_URING
+            bool isStated{ ring.isAvailable() && ring.stat(dirFd, batchNames, batchStats) };
+#else
+            bool isStated{ false };
+#endif
+            if(!isStated)
+            {
+                for(std::size_t i = 0; i < batchNames.size(); i++)
+                {
+                    if(!batchStats[i])
+                    {
+                        batchStats[i] = statFile(dirFd, batchNames[i].c_str());
+                    }
+                }
+            }
+            for(std::size_t i = 0; i < batchNames.size(); i++)
+            {
+                if(!callback({ folder / batchNames[i], batchStats[i] }))
+                {
+                    close(dirFd);
+                    return;
+                }
+            }
+        }
+        close(dirFd);
+    }
+#else
+    std::function<bool(const std::filesystem::path&)> report{ [&](const std::filesystem::path& path)
+    {
+        return !m_filter(path) || callback({ path, stat(path) });
+    } };
+    if(m_includeSubfolders)
+    {
+        for(const std::filesystem::path& path : std::filesystem::recursive_directory_iterator(m_folderPath, std::filesystem::directory_options::skip_permission_denied))
+        {
+            if(!report(path))
+            {
+                return;
+            }
+        }
+    }
+    else
+    {
+        for(const std::filesystem::path& path : std::filesystem::directory_iterator(m_folderPath))
+        {
+            if(!report(path))
+            {
+                return;
+            }
+        }
+    }
+#endif
+}
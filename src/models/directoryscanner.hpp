@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * The metadata of a file on disk, as collected by a single stat. Kept as a compact record so a copy can be held by every music file
+     */
+    struct FileStat
+    {
+    	std::uintmax_t size{ 0 };
+    	std::filesystem::file_time_type modificationTime;
+    	std::uint64_t inode{ 0 };
+    	/**
+    	 * Compares this to toCompare via equals
+    	 *
+    	 * @param toCompare The FileStat to compare
+    	 * @returns True if the size, modification time and inode are all equal, else false
+    	 */
+    	bool operator==(const FileStat& toCompare) const = default;
+    };
+
+    /**
+     * A file found by a DirectoryScanner
+     */
+    struct ScannedFile
+    {
+    	std::filesystem::path path;
+    	std::optional<FileStat> stat;
+    };
+
+    /**
+     * A model of a walk over the files of a folder that collects the metadata of each matching file as it goes
+     *
+     * On Linux, directories are read with getdents64 and the files of each directory are stat'ed in batches with statx, submitted through io_uring when the kernel allows it so the round trips of network filesystems overlap
+     */
+    class DirectoryScanner
+    {
+    public:
+    	/**
+    	 * Constructs a DirectoryScanner
+    	 *
+    	 * @param folderPath The path of the folder to scan
+    	 * @param includeSubfolders True to scan subfolders as well, else false
+    	 * @param filter A bool(const std::filesystem::path&) function returning true for file paths that should be reported
+    	 */
+    	DirectoryScanner(const std::filesystem::path& folderPath, bool includeSubfolders, const std::function<bool(const std::filesystem::path&)>& filter);
+    	/**
+    	 * Stats a single file
+    	 *
+    	 * @param path The path of the file
+    	 * @returns The metadata of the file, or std::nullopt if it could not be stat'ed
+    	 */
+    	static std::optional<FileStat> stat(const std::filesystem::path& path);
+    	/**
+    	 * Walks the folder, reporting each file that passes the filter along with its metadata. Subfolders that cannot be read are skipped
+    	 *
+    	 * @param callback A bool(const ScannedFile&) function receiving each file, returning false to stop the walk
+    	 * @throws std::filesystem::filesystem_error Thrown when the folder itself cannot be read
+    	 */
+    	void scan(const std::function<bool(const ScannedFile&)>& callback) const;
+
+    private:
+    	std::filesystem::path m_folderPath;
+    	bool m_includeSubfolders;
+    	std::function<bool(const std::filesystem::path&)> m_filter;
+    };
+}
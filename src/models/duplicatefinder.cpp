@@ -0,0 +1,195 @@
+#include "duplicatefinder.hpp"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include "../helpers/bithelpers.hpp"
+
+using namespace NickvisionTagger::Helpers;
+using namespace NickvisionTagger::Models;
+
+//One item in eight is indexed. Items are picked by value, not position, so the same item is picked in every copy of a recording however it is shifted
+static const std::uint32_t INDEX_SAMPLE_BITS{ 3 };
+//Items shared by more fingerprints than this (e.g. silence) say nothing about which recordings match and are left out of the index
+static const std::size_t MAX_BUCKET_SIZE{ 64 };
+//How many indexed items a pair of fingerprints must share to be scored
+static const std::size_t MIN_SHARED_ITEMS{ 2 };
+//How far (in items of about 0.124 seconds) fingerprints are shifted against each other when aligning them
+static const int MAX_OFFSET{ 16 };
+//How much of the longer fingerprint must overlap the other at an offset, so a short clip never matches a whole track
+static const double MIN_OVERLAP_RATIO{ 0.8 };
+static const std::size_t MIN_OVERLAP_ITEMS{ 40 };
+//The fraction of differing bits below which two fingerprints hold the same recording. Re-encodes of a recording stay well under it, unrelated audio sits around 0.5
+static const double MAX_BIT_ERROR_RATE{ 0.2 };
+//How many candidate pairs a worker thread scores at a time
+static const std::size_t SCORE_CHUNK_SIZE{ 256 };
+
+/**
+ * Gets whether or not a fingerprint item is put in the index
+ *
+ * @param item The fingerprint item
+ * @returns True if indexed, else false
+ */
+static bool isIndexed(std::uint32_t item)
+{
+    return ((item * 0x9e3779b1u) >> (32 - INDEX_SAMPLE_BITS)) == 0;
+}
+
+/**
+ * Finds the representative of the group of an index, flattening the path to it
+ *
+ * @param parents The parent of each index
+ * @param index The index
+ * @returns The index representing its group
+ */
+static std::size_t findGroup(std::vector<std::size_t>& parents, std::size_t index)
+{
+    while(parents[index] != index)
+    {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+DuplicateFinder::DuplicateFinder(const std::vector<std::vector<std::uint32_t>>& fingerprints, unsigned int workerCount) : m_fingerprints{ fingerprints }, m_workerCount{ workerCount }
+{
+
+}
+
+double DuplicateFinder::compare(const std::vector<std::uint32_t>& first, const std::vector<std::uint32_t>& second)
+{
+    double best{ 1.0 };
+    std::size_t longerSize{ std::max(first.size(), second.size()) };
+    for(int offset = -MAX_OFFSET; offset <= MAX_OFFSET; offset++)
+    {
+        std::size_t firstStart{ offset > 0 ? static_cast<std::size_t>(offset) : 0 };
+        std::size_t secondStart{ offset < 0 ? static_cast<std::size_t>(-offset) : 0 };
+        if(firstStart >= first.size() || secondStart >= second.size())
+        {
+            continue;
+        }
+        std::size_t overlap{ std::min(first.size() - firstStart, second.size() - secondStart) };
+        if(overlap < MIN_OVERLAP_ITEMS || overlap < MIN_OVERLAP_RATIO * longerSize)
+        {
+            continue;
+        }
+        double bitErrorRate{ static_cast<double>(BitHelpers::hammingDistance(first.data() + firstStart, second.data() + secondStart, overlap)) / (32.0 * overlap) };
+        best = std::min(best, bitErrorRate);
+    }
+    return best;
+}
+
+std::vector<std::vector<std::size_t>> DuplicateFinder::find() const
+{
+    std::vector<std::uint64_t> candidates{ findCandidates() };
+    std::vector<char> isMatch(candidates.size(), false);
+    std::atomic<std::size_t> nextChunk{ 0 };
+    unsigned int workerCount{ m_workerCount > 0 ? m_workerCount : std::max(std::thread::hardware_concurrency(), 1u) };
+    workerCount = static_cast<unsigned int>(std::min<std::size_t>(workerCount, (candidates.size() + SCORE_CHUNK_SIZE - 1) / SCORE_CHUNK_SIZE));
+    std::vector<std::future<void>> workers;
+    for(unsigned int i = 0; i < workerCount; i++)
+    {
+        workers.push_back(std::async(std::launch::async, [&]()
+        {
+            for(std::size_t start{ nextChunk++ * SCORE_CHUNK_SIZE }; start < candidates.size(); start = nextChunk++ * SCORE_CHUNK_SIZE)
+            {
+                for(std::size_t j = start; j < std::min(start + SCORE_CHUNK_SIZE, candidates.size()); j++)
+                {
+                    isMatch[j] = compare(m_fingerprints[candidates[j] >> 32], m_fingerprints[candidates[j] & 0xffffffffu]) <= MAX_BIT_ERROR_RATE;
+                }
+            }
+        }));
+    }
+    for(std::future<void>& worker : workers)
+    {
+        worker.wait();
+    }
+    //Matches are joined transitively, so copies in three formats form one group even if only two of the pairs were candidates
+    std::vector<std::size_t> parents(m_fingerprints.size());
+    std::iota(parents.begin(), parents.end(), 0);
+    for(std::size_t i = 0; i < candidates.size(); i++)
+    {
+        if(isMatch[i])
+        {
+            parents[findGroup(parents, candidates[i] >> 32)] = findGroup(parents, candidates[i] & 0xffffffffu);
+        }
+    }
+    std::unordered_map<std::size_t, std::vector<std::size_t>> groupsByParent;
+    for(std::size_t i = 0; i < parents.size(); i++)
+    {
+        groupsByParent[findGroup(parents, i)].push_back(i);
+    }
+    std::vector<std::vector<std::size_t>> groups;
+    for(std::pair<const std::size_t, std::vector<std::size_t>>& pair : groupsByParent)
+    {
+        if(pair.second.size() > 1)
+        {
+            groups.push_back(std::move(pair.second));
+        }
+    }
+    std::sort(groups.begin(), groups.end());
+    return groups;
+}
+
+std::vector<std::uint64_t> DuplicateFinder::findCandidates() const
+{
+    //Postings hold the item in the high 32 bits and the index of its fingerprint in the low 32 bits, so sorting them builds the inverted index in one flat array
+    std::vector<std::uint64_t> postings;
+    std::vector<std::uint32_t> items;
+    for(std::size_t i = 0; i < m_fingerprints.size(); i++)
+    {
+        items.clear();
+        for(std::uint32_t item : m_fingerprints[i])
+        {
+            if(isIndexed(item))
+            {
+                items.push_back(item);
+            }
+        }
+        std::sort(items.begin(), items.end());
+        items.erase(std::unique(items.begin(), items.end()), items.end());
+        for(std::uint32_t item : items)
+        {
+            postings.push_back((static_cast<std::uint64_t>(item) << 32) | i);
+        }
+    }
+    std::sort(postings.begin(), postings.end());
+    std::vector<std::uint64_t> pairs;
+    for(std::size_t start = 0, end = 0; start < postings.size(); start = end)
+    {
+        end = start + 1;
+        while(end < postings.size() && (postings[end] >> 32) == (postings[start] >> 32))
+        {
+            end++;
+        }
+        if(end - start < 2 || end - start > MAX_BUCKET_SIZE)
+        {
+            continue;
+        }
+        for(std::size_t first = start; first < end; first++)
+        {
+            for(std::size_t second = first + 1; second < end; second++)
+            {
+                pairs.push_back(((postings[first] & 0xffffffffu) << 32) | (postings[second] & 0xffffffffu));
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    std::vector<std::uint64_t> candidates;
+    for(std::size_t start = 0, end = 0; start < pairs.size(); start = end)
+    {
+        end = start + 1;
+        while(end < pairs.size() && pairs[end] == pairs[start])
+        {
+            end++;
+        }
+        if(end - start >= MIN_SHARED_ITEMS)
+        {
+            candidates.push_back(pairs[start]);
+        }
+    }
+    return candidates;
+}
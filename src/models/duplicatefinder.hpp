@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * A model of a search for music files holding the same recording (e.g. an MP3 and a FLAC copy) by the similarity of their raw chromaprint fingerprints
+     *
+     * Fingerprints are not compared all against all. An inverted index of a consistent sample of fingerprint items (LSH over the items) finds the pairs that share items, and only those pairs are aligned and scored by the Hamming distance of their items
+     */
+    class DuplicateFinder
+    {
+    public:
+    	/**
+    	 * Constructs a DuplicateFinder
+    	 *
+    	 * @param fingerprints The raw fingerprints to search, as decoded by Fingerprinter::decode (empty fingerprints are never reported)
+    	 * @param workerCount The number of worker threads to score pairs with (0 to use one per hardware thread)
+    	 */
+    	DuplicateFinder(const std::vector<std::vector<std::uint32_t>>& fingerprints, unsigned int workerCount = 0);
+    	/**
+    	 * Compares two raw fingerprints, trying small offsets between them so that differing leading silence or encoder delay does not matter
+    	 *
+    	 * @param first The first raw fingerprint
+    	 * @param second The second raw fingerprint
+    	 * @returns The fraction of bits that differ at the best offset (0 for identical audio, about 0.5 for unrelated audio), or 1 if the fingerprints do not overlap enough to compare
+    	 */
+    	static double compare(const std::vector<std::uint32_t>& first, const std::vector<std::uint32_t>& second);
+    	/**
+    	 * Finds the groups of fingerprints of the same recording
+    	 *
+    	 * @returns The groups of indexes into the fingerprints, each holding at least two indexes in ascending order
+    	 */
+    	std::vector<std::vector<std::size_t>> find() const;
+
+    private:
+    	/**
+    	 * Finds the pairs of fingerprints that share enough indexed items to be worth scoring
+    	 *
+    	 * @returns The candidate pairs, as the index of the first fingerprint in the high 32 bits and of the second in the low 32 bits
+    	 */
+    	std::vector<std::uint64_t> findCandidates() const;
+    	const std::vector<std::vector<std::uint32_t>>& m_fingerprints;
+    	unsigned int m_workerCount;
+    };
+}
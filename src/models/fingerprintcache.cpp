@@ -0,0 +1,160 @@
+#include "fingerprintcache.hpp"
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <json/json.h>
+#include "directoryscanner.hpp"
+#include "fingerprinter.hpp"
+#include "../helpers/filehelpers.hpp"
+
+using namespace NickvisionTagger::Helpers;
+using namespace NickvisionTagger::Models;
+
+//Bump when the audio hash or the layout of the index changes so that stale caches are discarded instead of misread
+static const int FINGERPRINT_CACHE_VERSION{ 1 };
+
+FingerprintCache::FingerprintCache(const std::filesystem::path& folder) : m_folder{ folder }, m_indexPath{ folder / "index.json" }, m_isDirty{ false }
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_folder, error);
+    std::ifstream indexFile{ m_indexPath };
+    if(indexFile.is_open())
+    {
+        Json::Value json;
+        try
+        {
+            indexFile >> json;
+        }
+        catch(...)
+        {
+            return;
+        }
+        if(json.get("Version", 0).asInt() != FINGERPRINT_CACHE_VERSION)
+        {
+            return;
+        }
+        const Json::Value& files{ json["Files"] };
+        for(Json::Value::const_iterator it = files.begin(); it != files.end(); it++)
+        {
+            IndexEntry entry;
+            entry.fileSize = (*it).get("FileSize", 0).asUInt64();
+            entry.modificationTime = (*it).get("ModificationTime", 0).asInt64();
+            entry.audioHash = (*it).get("AudioHash", 0).asUInt64();
+            m_index.insert({ it.name(), entry });
+        }
+    }
+}
+
+std::string FingerprintCache::getFingerprint(const std::filesystem::path& path, const std::function<bool()>& isCancelled)
+{
+    std::optional<FileStat> stat{ DirectoryScanner::stat(path) };
+    if(!stat)
+    {
+        return "";
+    }
+    std::int64_t modificationTime{ stat->modificationTime.time_since_epoch().count() };
+    Fingerprinter& fingerprinter{ Fingerprinter::getInstance() };
+    unsigned int length{ Fingerprinter::getLength() };
+    std::optional<std::uint64_t> audioHash;
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        std::unordered_map<std::string, IndexEntry>::const_iterator it{ m_index.find(path.string()) };
+        if(it != m_index.end() && it->second.fileSize == stat->size && it->second.modificationTime == modificationTime)
+        {
+            audioHash = it->second.audioHash;
+        }
+    }
+    //A renamed or retagged file is rehashed, which only reads its audio packets, and finds its fingerprint again under the same hash
+    if(!audioHash)
+    {
+        audioHash = fingerprinter.hashAudio(path, isCancelled);
+        if(!audioHash)
+        {
+            return "";
+        }
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_index.insert_or_assign(path.string(), IndexEntry{ stat->size, modificationTime, *audioHash });
+        m_isDirty = true;
+    }
+    std::filesystem::path fingerprintPath{ getFingerprintPath(*audioHash, length) };
+    std::string fingerprint;
+    std::ifstream fingerprintFile{ fingerprintPath };
+    if(fingerprintFile.is_open() && std::getline(fingerprintFile, fingerprint) && !fingerprint.empty())
+    {
+        return fingerprint;
+    }
+    fingerprint = fingerprinter.fingerprint(path, isCancelled);
+    if(fingerprint.empty())
+    {
+        return "";
+    }
+    //Written to a file of the calling thread and renamed into place, so a reader never sees a partial fingerprint even when duplicates are fingerprinted at once
+    std::error_code error;
+    std::filesystem::create_directories(fingerprintPath.parent_path(), error);
+    std::filesystem::path tempPath{ fingerprintPath.string() + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp" };
+    try
+    {
+        FileHelpers::writeFile(tempPath, fingerprint.c_str(), fingerprint.size(), false, false);
+        std::filesystem::rename(tempPath, fingerprintPath);
+    }
+    catch(...)
+    {
+        std::filesystem::remove(tempPath, error);
+    }
+    return fingerprint;
+}
+
+void FingerprintCache::save()
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    if(!m_isDirty)
+    {
+        return;
+    }
+    Json::Value json;
+    json["Version"] = FINGERPRINT_CACHE_VERSION;
+    Json::Value& files{ json["Files"] };
+    for(const std::pair<const std::string, IndexEntry>& pair : m_index)
+    {
+        Json::Value& value{ files[pair.first] };
+        value["FileSize"] = Json::UInt64(pair.second.fileSize);
+        value["ModificationTime"] = Json::Int64(pair.second.modificationTime);
+        value["AudioHash"] = Json::UInt64(pair.second.audioHash);
+    }
+    //Write compactly to a temporary file and rename it over the index so a crash never leaves a truncated index behind
+    std::filesystem::path tempPath{ m_indexPath.string() + ".tmp" };
+    std::ofstream indexFile{ tempPath };
+    if(indexFile.is_open())
+    {
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        std::unique_ptr<Json::StreamWriter> writer{ builder.newStreamWriter() };
+        writer->write(json, &indexFile);
+        indexFile.close();
+        std::error_code ec;
+        //A write that failed part way (e.g. the disk is full) leaves a truncated temporary file, which must not replace the old one
+        if(!indexFile)
+        {
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+        std::filesystem::rename(tempPath, m_indexPath, ec);
+        if(!ec)
+        {
+            m_isDirty = false;
+        }
+    }
+}
+
+std::filesystem::path FingerprintCache::getFingerprintPath(std::uint64_t audioHash, unsigned int length) const
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << audioHash;
+    std::string hash{ name.str() };
+    //Fingerprints are spread over 256 subfolders so no single folder holds a whole library
+    return m_folder / hash.substr(0, 2) / (hash + "-" + std::to_string(length));
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * A persistent cache of chromaprint fingerprints, keyed by a hash of the audio of each music file and the fingerprint length
+     *
+     * The audio hash covers only the audio packets, so a fingerprint survives renames and tag edits. An index of paths, validated by file size and modification time, spares rehashing the audio of files that did not change
+     */
+    class FingerprintCache
+    {
+    public:
+    	/**
+    	 * Constructs a FingerprintCache (loading the index from disk)
+    	 *
+    	 * @param folder The path of the folder to keep the cache in (created if it does not exist)
+    	 */
+    	FingerprintCache(const std::filesystem::path& folder);
+    	/**
+    	 * Gets the chromaprint fingerprint of a music file from the cache, computing and caching it if not yet known. Safe to call from several threads at once
+    	 *
+    	 * @param path The path of the music file
+    	 * @param isCancelled A function polled while computing that returns true to stop early (empty to never stop)
+    	 * @returns The chromaprint fingerprint, or an empty string if it could not be computed or was cancelled
+    	 */
+    	std::string getFingerprint(const std::filesystem::path& path, const std::function<bool()>& isCancelled = {});
+    	/**
+    	 * Saves the index to disk if it was changed
+    	 */
+    	void save();
+
+    private:
+    	/**
+    	 * The audio hash of a music file as stored in the index
+    	 */
+    	struct IndexEntry
+    	{
+    		std::uintmax_t fileSize{ 0 };
+    		std::int64_t modificationTime{ 0 };
+    		std::uint64_t audioHash{ 0 };
+    	};
+    	/**
+    	 * Gets the path of the file a fingerprint is kept in
+    	 *
+    	 * @param audioHash The hash of the audio of the music file
+    	 * @param length The fingerprint length in seconds
+    	 * @returns The path of the fingerprint file
+    	 */
+    	std::filesystem::path getFingerprintPath(std::uint64_t audioHash, unsigned int length) const;
+    	std::filesystem::path m_folder;
+    	std::filesystem::path m_indexPath;
+    	std::unordered_map<std::string, IndexEntry> m_index;
+    	bool m_isDirty;
+    	mutable std::mutex m_mutex;
+    };
+}
@@ -0,0 +1,278 @@
+#include "fingerprinter.hpp"
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include "../helpers/hashhelpers.hpp"
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/log.h>
+#include <libavutil/mathematics.h>
+#include <libswresample/swresample.h>
+}
+
+using namespace NickvisionTagger::Helpers;
+using namespace NickvisionTagger::Models;
+
+std::atomic<unsigned int> Fingerprinter::m_length{ 120 };
+
+/**
+ * Closes an opened FFmpeg input
+ *
+ * @param format The input
+ */
+static void closeInput(AVFormatContext* format)
+{
+    avformat_close_input(&format);
+}
+
+/**
+ * Frees an FFmpeg decoder
+ *
+ * @param decoder The decoder
+ */
+static void freeDecoder(AVCodecContext* decoder)
+{
+    avcodec_free_context(&decoder);
+}
+
+/**
+ * Opens a music file and finds its audio stream, discarding every other stream
+ *
+ * @param path The path of the music file
+ * @param streamIndex Set to the index of the audio stream
+ * @param codec Set to the decoder of the audio stream
+ * @returns The opened input, or an empty pointer if the file has no readable audio
+ */
+static std::unique_ptr<AVFormatContext, decltype(&closeInput)> openAudioStream(const std::filesystem::path& path, int& streamIndex, const AVCodec*& codec)
+{
+    //The path is handed to FFmpeg as is, so no character of it needs quoting
+    AVFormatContext* openedFormat{ nullptr };
+    if(avformat_open_input(&openedFormat, path.c_str(), nullptr, nullptr) != 0)
+    {
+        return { nullptr, &closeInput };
+    }
+    std::unique_ptr<AVFormatContext, decltype(&closeInput)> format{ openedFormat, &closeInput };
+    if(avformat_find_stream_info(format.get(), nullptr) < 0)
+    {
+        return { nullptr, &closeInput };
+    }
+    codec = nullptr;
+    streamIndex = av_find_best_stream(format.get(), AVMEDIA_TYPE_AUDIO, -1, -1, &codec, 0);
+    if(streamIndex < 0 || !codec)
+    {
+        return { nullptr, &closeInput };
+    }
+    for(unsigned int i = 0; i < format->nb_streams; i++)
+    {
+        format->streams[i]->discard = static_cast<int>(i) == streamIndex ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+    return format;
+}
+
+Fingerprinter& Fingerprinter::getInstance()
+{
+    thread_local Fingerprinter instance;
+    return instance;
+}
+
+unsigned int Fingerprinter::getLength()
+{
+    return m_length;
+}
+
+void Fingerprinter::setLength(unsigned int length)
+{
+    m_length = length;
+}
+
+std::vector<std::uint32_t> Fingerprinter::decode(const std::string& fingerprint)
+{
+    std::uint32_t* items{ nullptr };
+    int size{ 0 };
+    int algorithm{ 0 };
+    if(fingerprint.empty() || !chromaprint_decode_fingerprint(fingerprint.c_str(), static_cast<int>(fingerprint.size()), &items, &size, &algorithm, 1) || !items)
+    {
+        return {};
+    }
+    std::vector<std::uint32_t> result(items, items + size);
+    chromaprint_dealloc(items);
+    return result;
+}
+
+Fingerprinter::Fingerprinter() : m_chromaprint{ chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT) }, m_packet{ av_packet_alloc() }, m_frame{ av_frame_alloc() }, m_resampler{ nullptr }
+{
+    //Undecodable files are reported by an empty fingerprint, not by FFmpeg writing to stderr
+    av_log_set_level(AV_LOG_QUIET);
+}
+
+Fingerprinter::~Fingerprinter()
+{
+    swr_free(&m_resampler);
+    av_frame_free(&m_frame);
+    av_packet_free(&m_packet);
+    chromaprint_free(m_chromaprint);
+}
+
+std::optional<std::uint64_t> Fingerprinter::hashAudio(const std::filesystem::path& path, const std::function<bool()>& isCancelled)
+{
+    if(!m_packet)
+    {
+        return std::nullopt;
+    }
+    int streamIndex{ -1 };
+    const AVCodec* codec{ nullptr };
+    std::unique_ptr<AVFormatContext, decltype(&closeInput)> format{ openAudioStream(path, streamIndex, codec) };
+    if(!format)
+    {
+        return std::nullopt;
+    }
+    //Only the packets starting within the fingerprinted length are hashed, the same audio the fingerprint is computed from
+    const AVStream* stream{ format->streams[streamIndex] };
+    unsigned int length{ m_length };
+    std::int64_t endTimestamp{ std::numeric_limits<std::int64_t>::max() };
+    if(length > 0)
+    {
+        endTimestamp = av_rescale_q(length, AVRational{ 1, 1 }, stream->time_base) + (stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0);
+    }
+    std::uint64_t hash{ static_cast<std::uint64_t>(stream->codecpar->codec_id) };
+    bool isHashed{ false };
+    while(av_read_frame(format.get(), m_packet) >= 0)
+    {
+        if(isCancelled && isCancelled())
+        {
+            av_packet_unref(m_packet);
+            return std::nullopt;
+        }
+        if(m_packet->stream_index == streamIndex)
+        {
+            if(m_packet->pts != AV_NOPTS_VALUE && m_packet->pts >= endTimestamp)
+            {
+                av_packet_unref(m_packet);
+                break;
+            }
+            hash = HashHelpers::hash64(m_packet->data, m_packet->size, hash);
+            isHashed = true;
+        }
+        av_packet_unref(m_packet);
+    }
+    if(!isHashed)
+    {
+        return std::nullopt;
+    }
+    return hash;
+}
+
+std::string Fingerprinter::fingerprint(const std::filesystem::path& path, const std::function<bool()>& isCancelled)
+{
+    if(!m_chromaprint || !m_packet || !m_frame)
+    {
+        return "";
+    }
+    int streamIndex{ -1 };
+    const AVCodec* codec{ nullptr };
+    std::unique_ptr<AVFormatContext, decltype(&closeInput)> format{ openAudioStream(path, streamIndex, codec) };
+    if(!format)
+    {
+        return "";
+    }
+    //Decoders are opened for the codec parameters of each file, so only the objects around the decoder are reused
+    std::unique_ptr<AVCodecContext, decltype(&freeDecoder)> decoder{ avcodec_alloc_context3(codec), &freeDecoder };
+    if(!decoder || avcodec_parameters_to_context(decoder.get(), format->streams[streamIndex]->codecpar) < 0 || avcodec_open2(decoder.get(), codec, nullptr) < 0)
+    {
+        return "";
+    }
+    int sampleRate{ decoder->sample_rate };
+    int channels{ decoder->ch_layout.nb_channels };
+    if(sampleRate <= 0 || channels <= 0)
+    {
+        return "";
+    }
+    //Samples are converted to interleaved 16-bit integers at their own rate, which chromaprint resamples and downmixes itself
+    AVChannelLayout inputLayout;
+    AVChannelLayout outputLayout;
+    if(decoder->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC)
+    {
+        av_channel_layout_default(&inputLayout, channels);
+    }
+    else
+    {
+        av_channel_layout_copy(&inputLayout, &decoder->ch_layout);
+    }
+    av_channel_layout_default(&outputLayout, channels);
+    int resamplerResult{ swr_alloc_set_opts2(&m_resampler, &outputLayout, AV_SAMPLE_FMT_S16, sampleRate, &inputLayout, decoder->sample_fmt, sampleRate, 0, nullptr) };
+    av_channel_layout_uninit(&inputLayout);
+    av_channel_layout_uninit(&outputLayout);
+    if(resamplerResult < 0 || swr_init(m_resampler) < 0)
+    {
+        return "";
+    }
+    if(!chromaprint_start(m_chromaprint, sampleRate, channels))
+    {
+        return "";
+    }
+    unsigned int length{ m_length };
+    std::uint64_t remainingSamples{ length == 0 ? std::numeric_limits<std::uint64_t>::max() : static_cast<std::uint64_t>(length) * sampleRate };
+    bool failed{ false };
+    //Receives the frames decoded so far and feeds them to chromaprint
+    auto feedDecodedFrames{ [&]()
+    {
+        while(remainingSamples > 0 && avcodec_receive_frame(decoder.get(), m_frame) == 0)
+        {
+            int maxSamples{ swr_get_out_samples(m_resampler, m_frame->nb_samples) };
+            if(maxSamples < 0)
+            {
+                failed = true;
+                av_frame_unref(m_frame);
+                return;
+            }
+            if(m_samples.size() < static_cast<std::size_t>(maxSamples) * channels)
+            {
+                m_samples.resize(static_cast<std::size_t>(maxSamples) * channels);
+            }
+            std::uint8_t* output{ reinterpret_cast<std::uint8_t*>(m_samples.data()) };
+            int samples{ swr_convert(m_resampler, &output, maxSamples, const_cast<const std::uint8_t**>(m_frame->extended_data), m_frame->nb_samples) };
+            av_frame_unref(m_frame);
+            if(samples < 0)
+            {
+                failed = true;
+                return;
+            }
+            int fedSamples{ static_cast<int>(std::min<std::uint64_t>(samples, remainingSamples)) };
+            if(fedSamples > 0 && !chromaprint_feed(m_chromaprint, m_samples.data(), fedSamples * channels))
+            {
+                failed = true;
+                return;
+            }
+            remainingSamples -= fedSamples;
+        }
+    } };
+    while(!failed && remainingSamples > 0 && av_read_frame(format.get(), m_packet) >= 0)
+    {
+        if(isCancelled && isCancelled())
+        {
+            av_packet_unref(m_packet);
+            return "";
+        }
+        //A packet the decoder rejects (e.g. a corrupt one) is skipped, as fpcalc does
+        if(m_packet->stream_index == streamIndex && avcodec_send_packet(decoder.get(), m_packet) == 0)
+        {
+            feedDecodedFrames();
+        }
+        av_packet_unref(m_packet);
+    }
+    if(!failed && remainingSamples > 0 && avcodec_send_packet(decoder.get(), nullptr) == 0)
+    {
+        feedDecodedFrames();
+    }
+    char* fingerprint{ nullptr };
+    if(failed || !chromaprint_finish(m_chromaprint) || !chromaprint_get_fingerprint(m_chromaprint, &fingerprint) || !fingerprint)
+    {
+        return "";
+    }
+    std::string result{ fingerprint };
+    chromaprint_dealloc(fingerprint);
+    return result;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+#include <chromaprint.h>
+
+struct AVFrame;
+struct AVPacket;
+struct SwrContext;
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * A model of an in-process chromaprint fingerprinting engine. Audio is decoded with FFmpeg and fed to libchromaprint directly, without spawning fpcalc
+     *
+     * Each thread uses its own Fingerprinter, which keeps its chromaprint context, packet, frame, resampler and sample buffer across files
+     */
+    class Fingerprinter
+    {
+    public:
+    	/**
+    	 * Gets the Fingerprinter of the calling thread
+    	 *
+    	 * @returns The Fingerprinter
+    	 */
+    	static Fingerprinter& getInstance();
+    	/**
+    	 * Gets the length of audio fingerprinted from the start of each file, shared by all Fingerprinters
+    	 *
+    	 * @returns The length in seconds
+    	 */
+    	static unsigned int getLength();
+    	/**
+    	 * Sets the length of audio fingerprinted from the start of each file, shared by all Fingerprinters
+    	 *
+    	 * @param length The new length in seconds (0 to fingerprint whole files)
+    	 */
+    	static void setLength(unsigned int length);
+    	/**
+    	 * Decodes a chromaprint fingerprint into its raw items, one 32-bit word per frame of audio (about 0.124 seconds)
+    	 *
+    	 * @param fingerprint The chromaprint fingerprint as computed by fingerprint
+    	 * @returns The raw fingerprint, or an empty vector if the fingerprint could not be decoded
+    	 */
+    	static std::vector<std::uint32_t> decode(const std::string& fingerprint);
+    	Fingerprinter(const Fingerprinter&) = delete;
+    	Fingerprinter& operator=(const Fingerprinter&) = delete;
+    	/**
+    	 * Destructs a Fingerprinter
+    	 */
+    	~Fingerprinter();
+    	/**
+    	 * Computes a hash of the audio packets of a music file that the fingerprint covers, without decoding them. Tags are not part of the audio packets, so the hash is unchanged by tag edits
+    	 *
+    	 * @param path The path of the music file
+    	 * @param isCancelled A function polled between packets that returns true to stop early (empty to never stop)
+    	 * @returns The hash of the audio, or std::nullopt if the file has no readable audio or hashing was cancelled
+    	 */
+    	std::optional<std::uint64_t> hashAudio(const std::filesystem::path& path, const std::function<bool()>& isCancelled = {});
+    	/**
+    	 * Computes the chromaprint fingerprint of a music file by decoding its audio
+    	 *
+    	 * @param path The path of the music file
+    	 * @param isCancelled A function polled between packets that returns true to stop early (empty to never stop)
+    	 * @returns The chromaprint fingerprint, or an empty string if it could not be computed or was cancelled
+    	 */
+    	std::string fingerprint(const std::filesystem::path& path, const std::function<bool()>& isCancelled = {});
+
+    private:
+    	/**
+    	 * Constructs a Fingerprinter
+    	 */
+    	Fingerprinter();
+    	static std::atomic<unsigned int> m_length;
+    	ChromaprintContext* m_chromaprint;
+    	AVPacket* m_packet;
+    	AVFrame* m_frame;
+    	SwrContext* m_resampler;
+    	std::vector<std::int16_t> m_samples;
+    };
+}
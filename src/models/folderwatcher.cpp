@@ -0,0 +1,235 @@
+#include "folderwatcher.hpp"
+#ifdef __linux__
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace NickvisionTagger::Models;
+
+FolderWatcher::FolderWatcher(const std::filesystem::path& folderPath, bool includeSubfolders, const std::function<bool(const std::filesystem::path&)>& filter) : m_folderPath{ folderPath }, m_includeSubfolders{ includeSubfolders }, m_filter{ filter }, m_inotifyFd{ -1 }, m_stopFd{ -1 }, m_overflowed{ false }
+{
+#ifdef __linux__
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_inotifyFd == -1)
+    {
+        return;
+    }
+    m_stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(m_stopFd == -1)
+    {
+        close(m_inotifyFd);
+        m_inotifyFd = -1;
+        return;
+    }
+    addWatches(m_folderPath, false);
+    m_thread = std::thread(&FolderWatcher::watch, this);
+#endif
+}
+
+FolderWatcher::~FolderWatcher()
+{
+#ifdef __linux__
+    if(m_thread.joinable())
+    {
+        std::uint64_t stop{ 1 };
+        [[maybe_unused]] ssize_t written{ write(m_stopFd, &stop, sizeof(stop)) };
+        m_thread.join();
+    }
+    if(m_stopFd != -1)
+    {
+        close(m_stopFd);
+    }
+    if(m_inotifyFd != -1)
+    {
+        close(m_inotifyFd);
+    }
+#endif
+}
+
+bool FolderWatcher::getIsWatching() const
+{
+    return m_thread.joinable();
+}
+
+std::vector<FolderChange> FolderWatcher::takeChanges(std::chrono::milliseconds quietPeriod)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    std::vector<FolderChange> changes;
+    //If the kernel dropped events, individual changes can no longer be trusted and the whole folder must be rescanned
+    if(m_overflowed)
+    {
+        m_overflowed = false;
+        m_pendingChanges.clear();
+        changes.push_back({ FolderChangeType::Overflow, m_folderPath });
+        return changes;
+    }
+    std::chrono::steady_clock::time_point now{ std::chrono::steady_clock::now() };
+    for(std::unordered_map<std::string, PendingChange>::iterator it = m_pendingChanges.begin(); it != m_pendingChanges.end();)
+    {
+        if(now - it->second.lastEventTime >= quietPeriod)
+        {
+            changes.push_back({ it->second.type, it->first });
+            it = m_pendingChanges.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+    return changes;
+}
+
+void FolderWatcher::addWatches(const std::filesystem::path& directory, bool reportFiles)
+{
+#ifdef __linux__
+    int wd{ inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR) };
+    if(wd == -1)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_watches.insert_or_assign(wd, directory);
+    }
+    std::error_code ec;
+    for(std::filesystem::directory_iterator it{ directory, std::filesystem::directory_options::skip_permission_denied, ec }; !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+    {
+        std::error_code typeEc;
+        if(it->is_directory(typeEc))
+        {
+            if(m_includeSubfolders && !it->is_symlink(typeEc))
+            {
+                addWatches(it->path(), reportFiles);
+            }
+        }
+        else if(reportFiles && m_filter(it->path()))
+        {
+            recordChange(FolderChangeType::Added, it->path());
+        }
+    }
+#endif
+}
+
+void FolderWatcher::recordChange(FolderChangeType type, const std::filesystem::path& path)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    std::chrono::steady_clock::time_point now{ std::chrono::steady_clock::now() };
+    std::unordered_map<std::string, PendingChange>::iterator it{ m_pendingChanges.find(path.string()) };
+    if(it == m_pendingChanges.end())
+    {
+        m_pendingChanges.insert({ path.string(), { type, now } });
+        return;
+    }
+    //Fold the new event into the unreported one so that consumers only see the net effect
+    FolderChangeType previous{ it->second.type };
+    if(previous == FolderChangeType::Added && type == FolderChangeType::Removed)
+    {
+        m_pendingChanges.erase(it);
+        return;
+    }
+    if(previous == FolderChangeType::Added && type == FolderChangeType::Changed)
+    {
+        type = FolderChangeType::Added;
+    }
+    else if(previous == FolderChangeType::Removed && type == FolderChangeType::Added)
+    {
+        type = FolderChangeType::Changed;
+    }
+    it->second = { type, now };
+}
+
+void FolderWatcher::watch()
+{
+#ifdef __linux__
+    alignas(inotify_event) char buffer[64 * 1024];
+    pollfd fds[2]{ { m_inotifyFd, POLLIN, 0 }, { m_stopFd, POLLIN, 0 } };
+    while(true)
+    {
+        if(poll(fds, 2, -1) == -1)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if(fds[1].revents & POLLIN)
+        {
+            break;
+        }
+        ssize_t length{ read(m_inotifyFd, buffer, sizeof(buffer)) };
+        if(length <= 0)
+        {
+            continue;
+        }
+        for(char* ptr = buffer; ptr < buffer + length;)
+        {
+            const inotify_event* event{ reinterpret_cast<const inotify_event*>(ptr) };
+            ptr += sizeof(inotify_event) + event->len;
+            if(event->mask & IN_Q_OVERFLOW)
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_overflowed = true;
+                continue;
+            }
+            std::filesystem::path directory;
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                std::unordered_map<int, std::filesystem::path>::iterator it{ m_watches.find(event->wd) };
+                if(it == m_watches.end())
+                {
+                    continue;
+                }
+                if(event->mask & IN_IGNORED)
+                {
+                    m_watches.erase(it);
+                    continue;
+                }
+                directory = it->second;
+            }
+            if(event->mask & IN_DELETE_SELF || event->len == 0)
+            {
+                continue;
+            }
+            std::filesystem::path path{ directory / event->name };
+            if(event->mask & IN_ISDIR)
+            {
+                //Directories are reported as removed as a whole, consumers drop every file under the path
+                if(!m_includeSubfolders)
+                {
+                    continue;
+                }
+                if(event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    addWatches(path, true);
+                }
+                else if(event->mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    recordChange(FolderChangeType::Removed, path);
+                }
+                continue;
+            }
+            if(!m_filter(path))
+            {
+                continue;
+            }
+            if(event->mask & (IN_CREATE | IN_MOVED_TO))
+            {
+                recordChange(FolderChangeType::Added, path);
+            }
+            else if(event->mask & (IN_DELETE | IN_MOVED_FROM))
+            {
+                recordChange(FolderChangeType::Removed, path);
+            }
+            else if(event->mask & (IN_CLOSE_WRITE | IN_ATTRIB))
+            {
+                recordChange(FolderChangeType::Changed, path);
+            }
+        }
+    }
+#endif
+}
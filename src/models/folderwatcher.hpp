@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * Kinds of changes reported by a FolderWatcher
+     */
+    enum class FolderChangeType
+    {
+    	Added = 0,
+    	Removed,
+    	Changed,
+    	Overflow
+    };
+
+    /**
+     * A change to a path inside a watched folder
+     */
+    struct FolderChange
+    {
+    	FolderChangeType type;
+    	std::filesystem::path path;
+    };
+
+    /**
+     * A model of a watcher that reports changes to files inside a folder (backed by inotify on Linux)
+     */
+    class FolderWatcher
+    {
+    public:
+    	/**
+    	 * Constructs a FolderWatcher and starts watching the folder
+    	 *
+    	 * @param folderPath The path of the folder to watch
+    	 * @param includeSubfolders True to watch subfolders as well, else false
+    	 * @param filter A bool(const std::filesystem::path&) function returning true for file paths that should be reported
+    	 */
+    	FolderWatcher(const std::filesystem::path& folderPath, bool includeSubfolders, const std::function<bool(const std::filesystem::path&)>& filter);
+    	/**
+    	 * Destructs a FolderWatcher, stopping the watch
+    	 */
+    	~FolderWatcher();
+    	FolderWatcher(const FolderWatcher&) = delete;
+    	FolderWatcher& operator=(const FolderWatcher&) = delete;
+    	/**
+    	 * Gets whether or not the folder is being watched
+    	 *
+    	 * @returns True if watching, else false (e.g. unsupported platform or no inotify instances left)
+    	 */
+    	bool getIsWatching() const;
+    	/**
+    	 * Takes the changes that have settled since the last call. Repeated events for the same path are coalesced into one change, and a change is only reported once no new events arrived for it within the quiet period
+    	 *
+    	 * @param quietPeriod How long a path must go without new events before its change is reported
+    	 * @returns The list of settled changes
+    	 */
+    	std::vector<FolderChange> takeChanges(std::chrono::milliseconds quietPeriod = std::chrono::milliseconds(500));
+
+    private:
+    	struct PendingChange
+    	{
+    		FolderChangeType type;
+    		std::chrono::steady_clock::time_point lastEventTime;
+    	};
+    	std::filesystem::path m_folderPath;
+    	bool m_includeSubfolders;
+    	std::function<bool(const std::filesystem::path&)> m_filter;
+    	int m_inotifyFd;
+    	int m_stopFd;
+    	std::unordered_map<int, std::filesystem::path> m_watches;
+    	std::mutex m_mutex;
+    	std::unordered_map<std::string, PendingChange> m_pendingChanges;
+    	bool m_overflowed;
+    	std::thread m_thread;
+    	/**
+    	 * Adds watches for a directory (and its subdirectories if includeSubfolders is true)
+    	 *
+    	 * @param directory The directory to watch
+    	 * @param reportFiles True to report files already inside the directory as added, else false
+    	 */
+    	void addWatches(const std::filesystem::path& directory, bool reportFiles);
+    	/**
+    	 * Records a change for a path, coalescing it with any unreported change for the same path
+    	 *
+    	 * @param type The type of change
+    	 * @param path The path that changed
+    	 */
+    	void recordChange(FolderChangeType type, const std::filesystem::path& path);
+    	/**
+    	 * Reads inotify events until the watcher is stopped
+    	 */
+    	void watch();
+    };
+}
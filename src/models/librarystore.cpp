@@ -0,0 +1,83 @@
+#include "librarystore.hpp"
+#include <stdexcept>
+
+using namespace NickvisionTagger::Models;
+
+LibraryStore& LibraryStore::getInstance()
+{
+    static LibraryStore instance;
+    return instance;
+}
+
+LibraryStore::LibraryStore() : m_chunkCount{ 0 }, m_nextRow{ 0 }
+{
+
+}
+
+LibraryColumns& LibraryStore::getColumns()
+{
+    return m_columns;
+}
+
+std::uint32_t LibraryStore::allocate()
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    if(!m_freeRows.empty())
+    {
+        std::uint32_t row{ m_freeRows.back() };
+        m_freeRows.pop_back();
+        return row;
+    }
+    if(m_nextRow == m_chunkCount * LibraryColumn<std::string>::CHUNK_SIZE)
+    {
+        if(m_chunkCount == LibraryColumn<std::string>::MAX_CHUNKS)
+        {
+            throw std::length_error("The library store is full.");
+        }
+        m_columns.titles.addChunk(m_chunkCount);
+        m_columns.artists.addChunk(m_chunkCount);
+        m_columns.albums.addChunk(m_chunkCount);
+        m_columns.years.addChunk(m_chunkCount);
+        m_columns.tracks.addChunk(m_chunkCount);
+        m_columns.albumArtists.addChunk(m_chunkCount);
+        m_columns.genres.addChunk(m_chunkCount);
+        m_columns.comments.addChunk(m_chunkCount);
+        m_columns.properties.addChunk(m_chunkCount);
+        m_columns.durations.addChunk(m_chunkCount);
+        m_columns.fileSizes.addChunk(m_chunkCount);
+        m_columns.modificationTimes.addChunk(m_chunkCount);
+        m_columns.inodes.addChunk(m_chunkCount);
+        m_columns.albumArtHashes.addChunk(m_chunkCount);
+        m_columns.albumArtSizes.addChunk(m_chunkCount);
+        m_chunkCount++;
+    }
+    return m_nextRow++;
+}
+
+void LibraryStore::release(std::uint32_t row)
+{
+    //Reset outside of the lock, no other music file uses the row until it is back on the free list
+    m_columns.titles[row] = std::string();
+    m_columns.artists[row] = InternedString();
+    m_columns.albums[row] = InternedString();
+    m_columns.years[row] = 0;
+    m_columns.tracks[row] = 0;
+    m_columns.albumArtists[row] = InternedString();
+    m_columns.genres[row] = InternedString();
+    m_columns.comments[row] = std::string();
+    m_columns.properties[row] = PropertyTable();
+    m_columns.durations[row] = 0;
+    m_columns.fileSizes[row] = 0;
+    m_columns.modificationTimes[row] = {};
+    m_columns.inodes[row] = 0;
+    m_columns.albumArtHashes[row] = 0;
+    m_columns.albumArtSizes[row] = 0;
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    m_freeRows.push_back(row);
+}
+
+std::size_t LibraryStore::getRowCount() const
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    return m_nextRow - m_freeRows.size();
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "propertytable.hpp"
+#include "stringpool.hpp"
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * A column of the LibraryStore, holding one field for every row. Rows are stored in contiguous chunks that never move once allocated, so a row can be read while other rows are being added
+     */
+    template<typename T>
+    class LibraryColumn
+    {
+    public:
+    	/**
+    	 * The number of rows in a chunk
+    	 */
+    	static constexpr std::size_t CHUNK_SIZE{ 8192 };
+    	/**
+    	 * The maximum number of chunks in a column
+    	 */
+    	static constexpr std::size_t MAX_CHUNKS{ 2048 };
+    	/**
+    	 * Gets the value of a row
+    	 *
+    	 * @param row The row
+    	 * @returns The value of the row
+    	 */
+    	T& operator[](std::uint32_t row)
+    	{
+    	    return m_chunks[row / CHUNK_SIZE][row % CHUNK_SIZE];
+    	}
+    	/**
+    	 * Gets the value of a row
+    	 *
+    	 * @param row The row
+    	 * @returns The value of the row
+    	 */
+    	const T& operator[](std::uint32_t row) const
+    	{
+    	    return m_chunks[row / CHUNK_SIZE][row % CHUNK_SIZE];
+    	}
+    	/**
+    	 * Allocates a chunk of rows
+    	 *
+    	 * @param index The index of the chunk
+    	 */
+    	void addChunk(std::size_t index)
+    	{
+    	    m_chunks[index] = std::make_unique<T[]>(CHUNK_SIZE);
+    	}
+
+    private:
+    	std::array<std::unique_ptr<T[]>, MAX_CHUNKS> m_chunks;
+    };
+
+    /**
+     * The columns of the LibraryStore, one per field of a music file
+     */
+    struct LibraryColumns
+    {
+    	LibraryColumn<std::string> titles;
+    	LibraryColumn<InternedString> artists;
+    	LibraryColumn<InternedString> albums;
+    	LibraryColumn<std::uint32_t> years;
+    	LibraryColumn<std::uint32_t> tracks;
+    	LibraryColumn<InternedString> albumArtists;
+    	LibraryColumn<InternedString> genres;
+    	LibraryColumn<std::string> comments;
+    	LibraryColumn<PropertyTable> properties;
+    	LibraryColumn<std::int32_t> durations;
+    	LibraryColumn<std::uint64_t> fileSizes;
+    	LibraryColumn<std::filesystem::file_time_type> modificationTimes;
+    	LibraryColumn<std::uint64_t> inodes;
+    	LibraryColumn<std::uint64_t> albumArtHashes;
+    	LibraryColumn<std::uint32_t> albumArtSizes;
+    };
+
+    /**
+     * A column-oriented store of the metadata of all music files. Each music file is a row, and each field is a column, so loops over a field of many music files read packed arrays instead of chasing pointers through music file objects
+     *
+     * Rows are allocated by music files when they are constructed and released when they are destructed. Rows of the same chunk may be written by different threads, as long as each row is only used by one music file
+     */
+    class LibraryStore
+    {
+    public:
+    	/**
+    	 * Gets the LibraryStore shared by all music files
+    	 *
+    	 * @returns The LibraryStore
+    	 */
+    	static LibraryStore& getInstance();
+    	LibraryStore(const LibraryStore&) = delete;
+    	LibraryStore& operator=(const LibraryStore&) = delete;
+    	/**
+    	 * Gets the columns of the store
+    	 *
+    	 * @returns The columns of the store
+    	 */
+    	LibraryColumns& getColumns();
+    	/**
+    	 * Allocates a row with default values
+    	 *
+    	 * @returns The row
+    	 * @throws std::length_error Thrown when the store is full
+    	 */
+    	std::uint32_t allocate();
+    	/**
+    	 * Releases a row, resetting it to default values for reuse
+    	 *
+    	 * @param row The row
+    	 */
+    	void release(std::uint32_t row);
+    	/**
+    	 * Gets the number of rows in use
+    	 *
+    	 * @returns The number of rows in use
+    	 */
+    	std::size_t getRowCount() const;
+
+    private:
+    	/**
+    	 * Constructs a LibraryStore
+    	 */
+    	LibraryStore();
+    	LibraryColumns m_columns;
+    	std::size_t m_chunkCount;
+    	std::uint32_t m_nextRow;
+    	std::vector<std::uint32_t> m_freeRows;
+    	mutable std::mutex m_mutex;
+    };
+}
@@ -1,275 +1,222 @@
 #include "musicfile.hpp"
-#include <array>
-#include <cstdio>
+#include <memory>
+#include <optional>
 #include <stdexcept>
-#include <taglib/asffile.h>
-#include <taglib/flacfile.h>
-#include <taglib/mp4file.h>
-#include <taglib/mpegfile.h>
-#include <taglib/oggflacfile.h>
-#include <taglib/opusfile.h>
-#include <taglib/textidentificationframe.h>
+#include <vector>
 #include <taglib/tstring.h>
-#include <taglib/wavfile.h>
-#include <taglib/vorbisfile.h>
 #include "acoustidquery.hpp"
+#include "albumartstore.hpp"
 #include "acoustidsubmission.hpp"
+#include "fingerprinter.hpp"
+#include "librarystore.hpp"
 #include "musicbrainzrecordingquery.hpp"
+#include "musicformat.hpp"
 #include "tagmap.hpp"
+#include "../helpers/filehelpers.hpp"
 #include "../helpers/mediahelpers.hpp"
 
 using namespace NickvisionTagger::Helpers;
 using namespace NickvisionTagger::Models;
 
-MusicFile::MusicFile(const std::filesystem::path& path) : m_path{ path }, m_filename{ m_path.filename().string() }, m_dotExtension{ m_path.extension() }, m_modificationTimeStamp{ std::filesystem::last_write_time(m_path) }, m_fingerprint{ "" }
+static_assert(TAG_FIELD_COUNT <= 32, "Changed tag fields are tracked as bits of a 32-bit mask");
+
+/**
+ * Gets whether or not a tag field is among changes taken from a music file
+ *
+ * @param changes The changes taken from the music file
+ * @param index The index of the tag field
+ * @returns True if changed, else false
+ */
+static bool isFieldChanged(const TagChanges& changes, std::size_t index)
 {
-    loadFromDisk();
+    return (changes.changedFields >> index) & 1u;
 }
 
-const std::filesystem::path& MusicFile::getPath() const
+/**
+ * Reads only the album art of a music file from disk
+ *
+ * @param path The path of the music file
+ * @returns The album art, or an empty ByteVector if the file has none
+ */
+static TagLib::ByteVector readAlbumArt(const std::filesystem::path& path)
 {
-    return m_path;
+    try
+    {
+        OpenedMusicFile file{ MusicFormatRegistry::getInstance().open(path, false) };
+        return file.format->tagHandler->getAlbumArt(file.tag);
+    }
+    catch(...)
+    {
+        return {};
+    }
 }
 
-void MusicFile::loadFromDisk()
+/**
+ * A piece of a filename format string: either literal text or a %name% placeholder of a tag field
+ */
+struct FormatPiece
 {
-    if(m_dotExtension == ".mp3")
+    std::string text;
+    std::optional<std::size_t> fieldIndex;
+};
+
+/**
+ * Splits a filename format string (e.g. "%artist%- %title%") into literal text and tag field placeholders
+ *
+ * @param formatString The format string
+ * @returns The pieces of the format string, or std::nullopt if a placeholder is not closed or names no tag field
+ */
+static std::optional<std::vector<FormatPiece>> parseFormatString(const std::string& formatString)
+{
+    std::vector<FormatPiece> pieces;
+    std::size_t position{ 0 };
+    while(position < formatString.size())
     {
-        TagLib::MPEG::File file{ m_path.c_str() };
-        m_title = file.ID3v2Tag(true)->title().to8Bit(true);
-        m_artist = file.ID3v2Tag(true)->artist().to8Bit(true);
-        m_album = file.ID3v2Tag(true)->album().to8Bit(true);
-        m_year = file.ID3v2Tag(true)->year();
-        m_track = file.ID3v2Tag(true)->track();
-        const TagLib::ID3v2::FrameList& frameAlbumArtist{ file.ID3v2Tag(true)->frameList("TPE2") };
-        if (!frameAlbumArtist.isEmpty())
+        std::size_t start{ formatString.find('%', position) };
+        if(start == std::string::npos)
         {
-            m_albumArtist = frameAlbumArtist.front()->toString().to8Bit(true);
+            pieces.push_back({ formatString.substr(position), std::nullopt });
+            break;
         }
-        m_genre = file.ID3v2Tag(true)->genre().to8Bit(true);
-        m_comment = file.ID3v2Tag(true)->comment().to8Bit(true);
-        const TagLib::ID3v2::FrameList& frameAlbumArt{ file.ID3v2Tag(true)->frameList("APIC") };
-        if (!frameAlbumArt.isEmpty())
+        if(start > position)
         {
-            m_albumArt = ((TagLib::ID3v2::AttachedPictureFrame*)frameAlbumArt.front())->picture();
+            pieces.push_back({ formatString.substr(position, start - position), std::nullopt });
         }
-        m_duration = file.audioProperties()->lengthInSeconds();
-    }
-    else if(m_dotExtension == ".m4a")
-    {
-        TagLib::MP4::File file{ m_path.c_str() };
-        m_title = file.tag()->title().to8Bit(true);
-        m_artist = file.tag()->artist().to8Bit(true);
-        m_album = file.tag()->album().to8Bit(true);
-        m_year = file.tag()->year();
-        m_track = file.tag()->track();
-        if(file.tag()->item("aART").isValid())
+        std::size_t end{ formatString.find('%', start + 1) };
+        if(end == std::string::npos)
         {
-            m_albumArtist = file.tag()->item("aART").toStringList()[0].to8Bit(true);
+            return std::nullopt;
         }
-        m_genre = file.tag()->genre().to8Bit(true);
-        m_comment = file.tag()->comment().to8Bit(true);
-        if(file.tag()->item("covr").isValid())
+        std::optional<std::size_t> fieldIndex{ findTagField(std::string_view(formatString).substr(start + 1, end - start - 1)) };
+        if(!fieldIndex)
         {
-            m_albumArt = file.tag()->item("covr").toCoverArtList()[0].data();
+            return std::nullopt;
         }
-        m_duration = file.audioProperties()->lengthInSeconds();
+        pieces.push_back({ "", fieldIndex });
+        position = end + 1;
     }
-    else if(m_dotExtension == ".ogg")
+    return pieces;
+}
+
+MusicFile::MusicFile(const std::filesystem::path& path) : MusicFile(path, DirectoryScanner::stat(path).value_or(FileStat{}))
+{
+
+}
+
+MusicFile::MusicFile(const std::filesystem::path& path, const FileStat& fileStat) : m_path{ path }, m_filename{ m_path.filename().string() }, m_dotExtension{ m_path.extension() }, m_columns{ LibraryStore::getInstance().getColumns() }, m_row{ LibraryStore::getInstance().allocate() }, m_isAlbumArtChanged{ false }, m_changedFields{ 0 }, m_fingerprint{ "" }
+{
+    setFileStat(fileStat);
+    m_columns.durations[m_row] = -1;
+    try
     {
-        try
-        {
-            TagLib::Ogg::Vorbis::File file{ m_path.c_str() };
-            m_title = file.tag()->title().to8Bit(true);
-            m_artist = file.tag()->artist().to8Bit(true);
-            m_album = file.tag()->album().to8Bit(true);
-            m_year = file.tag()->year();
-            m_track = file.tag()->track();
-            const TagLib::Ogg::FieldListMap& fieldAlbumArtist{ file.tag()->fieldListMap() };
-            if (fieldAlbumArtist.contains("ALBUMARTIST"))
-            {
-                const TagLib::StringList& listAlbumArtist{ fieldAlbumArtist["ALBUMARTIST"] };
-                if (!listAlbumArtist.isEmpty())
-                {
-                    m_albumArtist = listAlbumArtist[0].to8Bit(true);
-                }
-            }
-            m_genre = file.tag()->genre().to8Bit(true);
-            m_comment = file.tag()->comment().to8Bit(true);
-            const TagLib::List<TagLib::FLAC::Picture*>& listAlbumArt{ file.tag()->pictureList() };
-            if (!listAlbumArt.isEmpty())
-            {
-                m_albumArt = listAlbumArt[0]->data();
-            }
-            m_duration = file.audioProperties()->lengthInSeconds();
-        }
-        catch(...)
-        {
-            try
-            {
-                TagLib::Ogg::Opus::File file{ m_path.c_str() };
-                m_title = file.tag()->title().to8Bit(true);
-                m_artist = file.tag()->artist().to8Bit(true);
-                m_album = file.tag()->album().to8Bit(true);
-                m_year = file.tag()->year();
-                m_track = file.tag()->track();
-                const TagLib::Ogg::FieldListMap& fieldAlbumArtist{ file.tag()->fieldListMap() };
-                if (fieldAlbumArtist.contains("ALBUMARTIST"))
-                {
-                    const TagLib::StringList& listAlbumArtist{ fieldAlbumArtist["ALBUMARTIST"] };
-                    if (!listAlbumArtist.isEmpty())
-                    {
-                        m_albumArtist = listAlbumArtist[0].to8Bit(true);
-                    }
-                }
-                m_genre = file.tag()->genre().to8Bit(true);
-                m_comment = file.tag()->comment().to8Bit(true);
-                const TagLib::List<TagLib::FLAC::Picture*>& listAlbumArt{ file.tag()->pictureList() };
-                if (!listAlbumArt.isEmpty())
-                {
-                    m_albumArt = listAlbumArt[0]->data();
-                }
-                m_duration = file.audioProperties()->lengthInSeconds();
-            }
-            catch(...)
-            {
-                throw std::invalid_argument("Invalid ogg/opus file.");
-            }
-        }
+        loadTag();
     }
-    else if(m_dotExtension == ".opus")
+    catch(...)
     {
-        TagLib::Ogg::Opus::File file{ m_path.c_str() };
-        m_title = file.tag()->title().to8Bit(true);
-        m_artist = file.tag()->artist().to8Bit(true);
-        m_album = file.tag()->album().to8Bit(true);
-        m_year = file.tag()->year();
-        m_track = file.tag()->track();
-        const TagLib::Ogg::FieldListMap& fieldAlbumArtist{ file.tag()->fieldListMap() };
-        if (fieldAlbumArtist.contains("ALBUMARTIST"))
-        {
-            const TagLib::StringList& listAlbumArtist{ fieldAlbumArtist["ALBUMARTIST"] };
-            if (!listAlbumArtist.isEmpty())
-            {
-                m_albumArtist = listAlbumArtist[0].to8Bit(true);
-            }
-        }
-        m_genre = file.tag()->genre().to8Bit(true);
-        m_comment = file.tag()->comment().to8Bit(true);
-        const TagLib::List<TagLib::FLAC::Picture*>& listAlbumArt{ file.tag()->pictureList() };
-        if (!listAlbumArt.isEmpty())
-        {
-            m_albumArt = listAlbumArt[0]->data();
-        }
-        m_duration = file.audioProperties()->lengthInSeconds();
-    }
-    else if(m_dotExtension == ".oga")
-    {
-        TagLib::Ogg::FLAC::File file{ m_path.c_str() };
-        m_title = file.tag()->title().to8Bit(true);
-        m_artist = file.tag()->artist().to8Bit(true);
-        m_album = file.tag()->album().to8Bit(true);
-        m_year = file.tag()->year();
-        m_track = file.tag()->track();
-        const TagLib::Ogg::FieldListMap& fieldAlbumArtist{ file.tag()->fieldListMap() };
-        if (fieldAlbumArtist.contains("ALBUMARTIST"))
-        {
-            const TagLib::StringList& listAlbumArtist{ fieldAlbumArtist["ALBUMARTIST"] };
-            if (!listAlbumArtist.isEmpty())
-            {
-                m_albumArtist = listAlbumArtist[0].to8Bit(true);
-            }
-        }
-        m_genre = file.tag()->genre().to8Bit(true);
-        m_comment = file.tag()->comment().to8Bit(true);
-        const TagLib::List<TagLib::FLAC::Picture*>& listAlbumArt{ file.tag()->pictureList() };
-        if (!listAlbumArt.isEmpty())
-        {
-            m_albumArt = listAlbumArt[0]->data();
-        }
-        m_duration = file.audioProperties()->lengthInSeconds();
-    }
-    else if(m_dotExtension == ".flac")
-    {
-        TagLib::FLAC::File file{ m_path.c_str() };
-        m_title = file.xiphComment(true)->title().to8Bit(true);
-        m_artist = file.xiphComment(true)->artist().to8Bit(true);
-        m_album = file.xiphComment(true)->album().to8Bit(true);
-        m_year = file.xiphComment(true)->year();
-        m_track = file.xiphComment(true)->track();
-        const TagLib::Ogg::FieldListMap& fieldAlbumArtist{ file.xiphComment(true)->fieldListMap() };
-        if (fieldAlbumArtist.contains("ALBUMARTIST"))
-        {
-            const TagLib::StringList& listAlbumArtist{ fieldAlbumArtist["ALBUMARTIST"] };
-            if (!listAlbumArtist.isEmpty())
-            {
-                m_albumArtist = listAlbumArtist[0].to8Bit(true);
-            }
-        }
-        m_genre = file.xiphComment(true)->genre().to8Bit(true);
-        m_comment = file.xiphComment(true)->comment().to8Bit(true);
-        const TagLib::List<TagLib::FLAC::Picture*>& listAlbumArt{ file.xiphComment(true)->pictureList() };
-        if (!listAlbumArt.isEmpty())
-        {
-            m_albumArt = listAlbumArt[0]->data();
-        }
-        m_duration = file.audioProperties()->lengthInSeconds();
-    }
-    else if(m_dotExtension == ".wma")
-    {
-        TagLib::ASF::File file{ m_path.c_str() };
-        m_title = file.tag()->title().to8Bit(true);
-        m_artist = file.tag()->artist().to8Bit(true);
-        m_album = file.tag()->album().to8Bit(true);
-        m_year = file.tag()->year();
-        m_track = file.tag()->track();
-        const TagLib::ASF::AttributeListMap& attributeListMap{ file.tag()->attributeListMap() };
-        if (attributeListMap.contains("ALBUMARTIST"))
-        {
-            const TagLib::ASF::AttributeList& attributeList{ attributeListMap["ALBUMARTIST"] };
-            if (!attributeList.isEmpty())
-            {
-                m_albumArtist = attributeList[0].toString().to8Bit(true);
-            }
-        }
-        m_genre = file.tag()->genre().to8Bit(true);
-        m_comment = file.tag()->comment().to8Bit(true);
-        if (attributeListMap.contains("WM/Picture"))
-        {
-            const TagLib::ASF::AttributeList& attributeList{ attributeListMap["WM/Picture"] };
-            if (!attributeList.isEmpty())
-            {
-                m_albumArt = attributeList[0].toPicture().picture();
-            }
-        }
-        m_duration = file.audioProperties()->lengthInSeconds();
-    }
-    else if(m_dotExtension == ".wav")
-    {
-        TagLib::RIFF::WAV::File file{ m_path.c_str() };
-        m_title = file.ID3v2Tag()->title().to8Bit(true);
-        m_artist = file.ID3v2Tag()->artist().to8Bit(true);
-        m_album = file.ID3v2Tag()->album().to8Bit(true);
-        m_year = file.ID3v2Tag()->year();
-        m_track = file.ID3v2Tag()->track();
-        const TagLib::ID3v2::FrameList& frameAlbumArtist{ file.ID3v2Tag()->frameList("TPE2") };
-        if (!frameAlbumArtist.isEmpty())
-        {
-            m_albumArtist = frameAlbumArtist.front()->toString().to8Bit(true);
-        }
-        m_genre = file.ID3v2Tag()->genre().to8Bit(true);
-        m_comment = file.ID3v2Tag()->comment().to8Bit(true);
-        const TagLib::ID3v2::FrameList& frameAlbumArt{ file.ID3v2Tag()->frameList("APIC") };
-        if (!frameAlbumArt.isEmpty())
+        //The destructor does not run for a constructor that throws, so the row is released here
+        LibraryStore::getInstance().release(m_row);
+        throw;
+    }
+}
+
+MusicFile::MusicFile(const std::filesystem::path& path, const FileStat& fileStat, const TagCacheEntry& cacheEntry) : m_path{ path }, m_filename{ m_path.filename().string() }, m_dotExtension{ m_path.extension() }, m_columns{ LibraryStore::getInstance().getColumns() }, m_row{ LibraryStore::getInstance().allocate() }, m_isAlbumArtChanged{ false }, m_changedFields{ 0 }, m_fingerprint{ "" }
+{
+    setFileStat(fileStat);
+    forEachTagField([&](const auto& field)
+    {
+        if constexpr(!std::decay_t<decltype(field)>::isSparse)
         {
-            m_albumArt = ((TagLib::ID3v2::AttachedPictureFrame*)frameAlbumArt.front())->picture();
+            setField(field, typename std::decay_t<decltype(field)>::ValueType(cacheEntry.*field.cacheField));
         }
-        m_duration = file.audioProperties()->lengthInSeconds();
+    });
+    m_columns.properties[m_row] = cacheEntry.properties;
+    m_changedFields = 0;
+    m_columns.albumArtHashes[m_row] = cacheEntry.hasAlbumArt ? cacheEntry.albumArtHash : 0;
+    m_columns.albumArtSizes[m_row] = cacheEntry.hasAlbumArt ? cacheEntry.albumArtSize : 0;
+    m_columns.durations[m_row] = cacheEntry.duration;
+}
+
+MusicFile::~MusicFile()
+{
+    LibraryStore::getInstance().release(m_row);
+}
+
+int MusicFile::readDuration(const std::filesystem::path& path)
+{
+    try
+    {
+        OpenedMusicFile file{ MusicFormatRegistry::getInstance().open(path, true, TagLib::AudioProperties::Accurate) };
+        return file.file->audioProperties() ? file.file->audioProperties()->lengthInSeconds() : 0;
+    }
+    catch(...)
+    {
+        return 0;
+    }
+}
+
+const std::filesystem::path& MusicFile::getPath() const
+{
+    return m_path;
+}
+
+void MusicFile::loadFromDisk()
+{
+    refreshFileStat();
+    loadTag();
+}
+
+FileStat MusicFile::getFileStat() const
+{
+    FileStat fileStat;
+    fileStat.size = m_columns.fileSizes[m_row];
+    fileStat.modificationTime = m_columns.modificationTimes[m_row];
+    fileStat.inode = m_columns.inodes[m_row];
+    return fileStat;
+}
+
+std::uint32_t MusicFile::getRow() const
+{
+    return m_row;
+}
+
+bool MusicFile::refreshFileStat()
+{
+    std::optional<FileStat> fileStat{ DirectoryScanner::stat(m_path) };
+    if(!fileStat || *fileStat == getFileStat())
+    {
+        return false;
     }
-    else
+    //Tags alone change the modification time too, but the audio is only re-read in the background, so the duration is kept unless the file changed
+    if(fileStat->modificationTime != m_columns.modificationTimes[m_row] || fileStat->inode != m_columns.inodes[m_row])
     {
-        throw std::invalid_argument("Invalid Path. The path is not a valid music file.");
+        m_columns.durations[m_row] = -1;
     }
+    setFileStat(*fileStat);
+    return true;
+}
+
+void MusicFile::setFileStat(const FileStat& fileStat)
+{
+    m_columns.fileSizes[m_row] = fileStat.size;
+    m_columns.modificationTimes[m_row] = fileStat.modificationTime;
+    m_columns.inodes[m_row] = fileStat.inode;
+}
+
+void MusicFile::loadTag()
+{
+    OpenedMusicFile file{ MusicFormatRegistry::getInstance().open(m_path, false) };
+    TagFields fields;
+    file.format->tagHandler->read(file.tag, fields);
+    forEachTagField([&](const auto& field)
+    {
+        setField(field, typename std::decay_t<decltype(field)>::ValueType(tagFieldFromTagValue(fields.*field.tagField)));
+    });
+    //Only the presence and size of album art are kept, the art itself is read again on demand by getAlbumArt
+    m_albumArt = nullptr;
+    m_isAlbumArtChanged = false;
+    m_changedFields = 0;
+    m_columns.albumArtHashes[m_row] = fields.albumArt.isEmpty() ? 0 : AlbumArtStore::hash(fields.albumArt);
+    m_columns.albumArtSizes[m_row] = fields.albumArt.size();
 }
 
 std::string MusicFile::getFilename() const
@@ -294,107 +241,180 @@ bool MusicFile::setFilename(const std::string& filename)
 
 const std::string& MusicFile::getTitle() const
 {
-    return m_title;
+    return m_columns.titles[m_row];
 }
 
 void MusicFile::setTitle(const std::string& title)
 {
-    m_title = title;
+    setField(TITLE_FIELD, title);
 }
 
 const std::string& MusicFile::getArtist() const
 {
-    return m_artist;
+    return m_columns.artists[m_row].get();
+}
+
+std::uint32_t MusicFile::getArtistId() const
+{
+    return m_columns.artists[m_row].getId();
 }
 
 void MusicFile::setArtist(const std::string& artist)
 {
-    m_artist = artist;
+    setField(ARTIST_FIELD, InternedString(artist));
 }
 
 const std::string& MusicFile::getAlbum() const
 {
-    return m_album;
+    return m_columns.albums[m_row].get();
+}
+
+std::uint32_t MusicFile::getAlbumId() const
+{
+    return m_columns.albums[m_row].getId();
 }
 
 void MusicFile::setAlbum(const std::string& album)
 {
-    m_album = album;
+    setField(ALBUM_FIELD, InternedString(album));
 }
 
 unsigned int MusicFile::getYear() const
 {
-    return m_year;
+    return m_columns.years[m_row];
 }
 
 void MusicFile::setYear(unsigned int year)
 {
-    m_year = year;
+    setField(YEAR_FIELD, static_cast<std::uint32_t>(year));
 }
 
 unsigned int MusicFile::getTrack() const
 {
-    return m_track;
+    return m_columns.tracks[m_row];
 }
 
 void MusicFile::setTrack(unsigned int track)
 {
-    m_track = track;
+    setField(TRACK_FIELD, static_cast<std::uint32_t>(track));
 }
 
 const std::string& MusicFile::getAlbumArtist() const
 {
-    return m_albumArtist;
+    return m_columns.albumArtists[m_row].get();
+}
+
+std::uint32_t MusicFile::getAlbumArtistId() const
+{
+    return m_columns.albumArtists[m_row].getId();
 }
 
 void MusicFile::setAlbumArtist(const std::string& albumArtist)
 {
-    m_albumArtist = albumArtist;
+    setField(ALBUM_ARTIST_FIELD, InternedString(albumArtist));
 }
 
 const std::string& MusicFile::getGenre() const
 {
-    return m_genre;
+    return m_columns.genres[m_row].get();
+}
+
+std::uint32_t MusicFile::getGenreId() const
+{
+    return m_columns.genres[m_row].getId();
 }
 
 void MusicFile::setGenre(const std::string& genre)
 {
-    m_genre = genre;
+    setField(GENRE_FIELD, InternedString(genre));
 }
 
 const std::string& MusicFile::getComment() const
 {
-    return m_comment;
+    return m_columns.comments[m_row];
 }
 
 void MusicFile::setComment(const std::string& comment)
 {
-    m_comment = comment;
+    setField(COMMENT_FIELD, comment);
 }
 
-const TagLib::ByteVector& MusicFile::getAlbumArt() const
+TagLib::ByteVector MusicFile::getAlbumArt() const
 {
-    return m_albumArt;
+    //Changed album art is held until it is saved, which may still be in progress after the changes were taken
+    if(m_albumArt)
+    {
+        return m_albumArt->data;
+    }
+    if(m_isAlbumArtChanged || !getHasAlbumArt())
+    {
+        return {};
+    }
+    if(std::shared_ptr<const AlbumArt> albumArt{ AlbumArtStore::getInstance().get(m_columns.albumArtHashes[m_row], m_columns.albumArtSizes[m_row]) })
+    {
+        return albumArt->data;
+    }
+    TagLib::ByteVector albumArt{ readAlbumArt(m_path) };
+    AlbumArtStore::getInstance().insert(albumArt);
+    return albumArt;
 }
 
 void MusicFile::setAlbumArt(const TagLib::ByteVector& albumArt)
 {
+    setAlbumArt(AlbumArtStore::getInstance().insert(albumArt));
+}
+
+void MusicFile::setAlbumArt(const std::shared_ptr<const AlbumArt>& albumArt)
+{
+    //Setting the album art the file already has is not a change, so its frames are left alone on save
+    if((albumArt ? albumArt->hash : 0) == m_columns.albumArtHashes[m_row] && (albumArt ? albumArt->data.size() : 0) == m_columns.albumArtSizes[m_row])
+    {
+        return;
+    }
     m_albumArt = albumArt;
+    m_isAlbumArtChanged = true;
+    m_columns.albumArtHashes[m_row] = m_albumArt ? m_albumArt->hash : 0;
+    m_columns.albumArtSizes[m_row] = m_albumArt ? m_albumArt->data.size() : 0;
+}
+
+bool MusicFile::getHasUnsavedChanges() const
+{
+    return m_changedFields != 0 || m_isAlbumArtChanged || m_path.filename() != m_filename;
+}
+
+bool MusicFile::getHasAlbumArt() const
+{
+    return m_columns.albumArtSizes[m_row] > 0;
+}
+
+std::uint64_t MusicFile::getAlbumArtHash() const
+{
+    return m_columns.albumArtHashes[m_row];
+}
+
+std::uintmax_t MusicFile::getAlbumArtSize() const
+{
+    return m_columns.albumArtSizes[m_row];
 }
 
 int MusicFile::getDuration() const
 {
-    return m_duration;
+    return m_columns.durations[m_row];
+}
+
+void MusicFile::setDuration(int duration)
+{
+    m_columns.durations[m_row] = duration;
 }
 
 std::string MusicFile::getDurationAsString() const
 {
-    return MediaHelpers::durationToString(m_duration);
+    return m_columns.durations[m_row] < 0 ? "" : MediaHelpers::durationToString(m_columns.durations[m_row]);
 }
 
 std::uintmax_t MusicFile::getFileSize() const
 {
-    return std::filesystem::file_size(m_path);
+    return m_columns.fileSizes[m_row];
 }
 
 std::string MusicFile::getFileSizeAsString() const
@@ -402,379 +422,404 @@ std::string MusicFile::getFileSizeAsString() const
     return MediaHelpers::fileSizeToString(getFileSize());
 }
 
+std::string MusicFile::readChromaprintFingerprint(const std::filesystem::path& path, const std::function<bool()>& isCancelled)
+{
+    return Fingerprinter::getInstance().fingerprint(path, isCancelled);
+}
+
 const std::string& MusicFile::getChromaprintFingerprint()
 {
-    if(m_fingerprint.empty() || m_fingerprint == "ERROR")
+    if(m_fingerprint.empty())
+    {
+        m_fingerprint = readChromaprintFingerprint(m_path);
+    }
+    return m_fingerprint;
+}
+
+bool MusicFile::getHasChromaprintFingerprint() const
+{
+    return !m_fingerprint.empty();
+}
+
+void MusicFile::setChromaprintFingerprint(const std::string& fingerprint)
+{
+    m_fingerprint = fingerprint;
+}
+
+TagCacheEntry MusicFile::getTagCacheEntry() const
+{
+    TagCacheEntry entry;
+    entry.fileSize = m_columns.fileSizes[m_row];
+    entry.modificationTime = m_columns.modificationTimes[m_row].time_since_epoch().count();
+    forEachTagField([&](const auto& field)
     {
-        std::string cmd{ "fpcalc \"" + m_path.string() + "\"" };
-        std::string output{ "" };
-        std::array<char, 128> buffer;
-        FILE* pipe{ popen(cmd.c_str(), "r") };
-        if(pipe)
+        if constexpr(!std::decay_t<decltype(field)>::isSparse)
         {
-            while(!feof(pipe))
-            {
-                if(fgets(buffer.data(), 128, pipe) != nullptr)
-                {
-                    output += buffer.data();
-                }
-            }
-            int resultCode{ pclose(pipe) };
-            m_fingerprint = resultCode == EXIT_SUCCESS ? output.substr(output.find("FINGERPRINT=") + 12) : "CMD ERROR ";
-            m_fingerprint.pop_back();
+            entry.*field.cacheField = getField(field);
         }
-        else
+    });
+    entry.properties = m_columns.properties[m_row];
+    entry.duration = m_columns.durations[m_row];
+    entry.hasAlbumArt = getHasAlbumArt();
+    entry.albumArtHash = m_columns.albumArtHashes[m_row];
+    entry.albumArtSize = m_columns.albumArtSizes[m_row];
+    return entry;
+}
+
+bool MusicFile::saveTag(bool preserveModificationTimeStamp, unsigned int paddingSize)
+{
+    if(!getHasUnsavedChanges())
+    {
+        return false;
+    }
+    TagChanges changes{ takeChanges() };
+    try
+    {
+        writeChanges(changes, preserveModificationTimeStamp, paddingSize);
+    }
+    catch(...)
+    {
+        finishSave(changes, false);
+        throw;
+    }
+    finishSave(changes, true);
+    return changes.rewritten;
+}
+
+TagChanges MusicFile::takeChanges()
+{
+    TagChanges changes;
+    changes.path = m_path;
+    changes.filename = m_filename;
+    changes.changedFields = m_changedFields;
+    forEachTagField([&](const auto& field)
+    {
+        if(isFieldChanged(changes, field.index))
         {
-            m_fingerprint = "PIPE ERROR";
+            changes.fields.*field.tagField = tagFieldToTagValue(getField(field));
         }
+    });
+    //Positions are written as pairs, so the other half of a changed pair is needed too
+    changes.fields.track = getField(TRACK_FIELD);
+    changes.fields.totalTracks = getField(TOTAL_TRACKS_FIELD);
+    changes.fields.discNumber = getField(DISC_NUMBER_FIELD);
+    changes.fields.totalDiscs = getField(TOTAL_DISCS_FIELD);
+    changes.isAlbumArtChanged = m_isAlbumArtChanged;
+    if(m_isAlbumArtChanged)
+    {
+        changes.fields.albumArt = getAlbumArt();
     }
-    return m_fingerprint;
+    changes.modificationTime = m_columns.modificationTimes[m_row];
+    m_changedFields = 0;
+    m_isAlbumArtChanged = false;
+    return changes;
 }
 
-void MusicFile::saveTag(bool preserveModificationTimeStamp)
+void MusicFile::writeChanges(TagChanges& changes, bool preserveModificationTimeStamp, unsigned int paddingSize)
 {
-    if(m_path.filename() != m_filename)
+    bool isRenamed{ false };
+    if(changes.path.filename() != changes.filename)
     {
-        std::string newPath{ m_path.parent_path().string() + "/" + m_filename };
-        std::filesystem::rename(m_path, newPath);
-        m_path = newPath;
+        std::filesystem::path newPath{ changes.path.parent_path() / changes.filename };
+        std::filesystem::rename(changes.path, newPath);
+        changes.path = newPath;
+        isRenamed = true;
     }
-    if (m_dotExtension == ".mp3")
+    bool isWritten{ changes.changedFields != 0 || changes.isAlbumArtChanged };
+    if(isWritten)
     {
-        TagLib::MPEG::File file{ m_path.c_str() };
-        file.ID3v2Tag(true)->setTitle({ m_title, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag(true)->setArtist({ m_artist, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag(true)->setAlbum({ m_album, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag(true)->setYear(m_year);
-        file.ID3v2Tag(true)->setTrack(m_track);
-        file.ID3v2Tag(true)->removeFrames("TPE2");
-        TagLib::ID3v2::TextIdentificationFrame* frameAlbumArtist{ new TagLib::ID3v2::TextIdentificationFrame("TPE2", TagLib::String::UTF8) };
-        frameAlbumArtist->setText({ m_albumArtist, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag(true)->addFrame(frameAlbumArtist);
-        file.ID3v2Tag(true)->setGenre({ m_genre, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag(true)->setComment({ m_comment, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag(true)->removeFrames("APIC");
-        if (!m_albumArt.isEmpty())
+        const MusicFormat* format{ MusicFormatRegistry::getInstance().getFormat(changes.path) };
+        if(!format)
         {
-            TagLib::ID3v2::AttachedPictureFrame* frameAlbumArt{ new TagLib::ID3v2::AttachedPictureFrame };
-            frameAlbumArt->setType(TagLib::ID3v2::AttachedPictureFrame::Type::FrontCover);
-            frameAlbumArt->setPicture(m_albumArt);
-            file.ID3v2Tag(true)->addFrame(frameAlbumArt);
+            throw std::invalid_argument("Invalid Path. The path is not a valid music file.");
+        }
+        //Formats whose start cannot be rendered here are saved by TagLib, on a copy that is renamed over the file when the filesystem makes the copy free
+        std::optional<std::filesystem::path> copyPath{ std::nullopt };
+        if(format->tagPlacement == TagPlacement::Start && !format->renderHeader)
+        {
+            copyPath = FileHelpers::reflinkToTemporaryFile(changes.path);
         }
-        file.save(TagLib::MPEG::File::TagTypes::ID3v2);
-    }
-    else if (m_dotExtension == ".m4a")
-    {
-        TagLib::MP4::File file{ m_path.c_str() };
-        file.tag()->setTitle({ m_title, TagLib::String::Type::UTF8 });
-        file.tag()->setArtist({ m_artist, TagLib::String::Type::UTF8 });
-        file.tag()->setAlbum({ m_album, TagLib::String::Type::UTF8 });
-        file.tag()->setYear(m_year);
-        file.tag()->setTrack(m_track);
-        file.tag()->removeItem("aART");
-        file.tag()->setItem("aART", { TagLib::StringList({ m_albumArtist, TagLib::String::Type::UTF8 }) });
-        file.tag()->setGenre({ m_genre, TagLib::String::Type::UTF8 });
-        file.tag()->setComment({ m_comment, TagLib::String::Type::UTF8 });
-        file.tag()->removeItem("covr");
-        TagLib::MP4::CoverArtList coverArtList;
-        coverArtList.append({ TagLib::MP4::CoverArt::Format::Unknown, m_albumArt });
-        file.tag()->setItem("covr", { coverArtList });
-        file.save();
-    }
-    else if (m_dotExtension == ".ogg")
-    {
         try
         {
-            TagLib::Ogg::Vorbis::File file{ m_path.c_str() };
-            file.tag()->setTitle({ m_title, TagLib::String::Type::UTF8 });
-            file.tag()->setArtist({ m_artist, TagLib::String::Type::UTF8 });
-            file.tag()->setAlbum({ m_album, TagLib::String::Type::UTF8 });
-            file.tag()->setYear(m_year);
-            file.tag()->setTrack(m_track);
-            file.tag()->addField("ALBUMARTIST", { m_albumArtist, TagLib::String::Type::UTF8 });
-            file.tag()->setGenre({ m_genre, TagLib::String::Type::UTF8 });
-            file.tag()->setComment({ m_comment, TagLib::String::Type::UTF8 });
-            file.tag()->removeAllPictures();
-            if (!m_albumArt.isEmpty())
+            changes.rewritten = writeTag(changes, *format, copyPath.value_or(changes.path), paddingSize);
+            if(copyPath)
             {
-                TagLib::FLAC::Picture* picture{ new TagLib::FLAC::Picture() };
-                picture->setType(TagLib::FLAC::Picture::Type::FrontCover);
-                picture->setData(m_albumArt);
-                file.tag()->addPicture(picture);
+                FileHelpers::commitTemporaryFile(*copyPath, changes.path);
             }
-            file.save();
         }
         catch(...)
         {
-            TagLib::Ogg::Opus::File file{ m_path.c_str() };
-            file.tag()->setTitle({ m_title, TagLib::String::Type::UTF8 });
-            file.tag()->setArtist({ m_artist, TagLib::String::Type::UTF8 });
-            file.tag()->setAlbum({ m_album, TagLib::String::Type::UTF8 });
-            file.tag()->setYear(m_year);
-            file.tag()->setTrack(m_track);
-            file.tag()->addField("ALBUMARTIST", { m_albumArtist, TagLib::String::Type::UTF8 });
-            file.tag()->setGenre({ m_genre, TagLib::String::Type::UTF8 });
-            file.tag()->setComment({ m_comment, TagLib::String::Type::UTF8 });
-            file.tag()->removeAllPictures();
-            if (!m_albumArt.isEmpty())
+            if(copyPath)
             {
-                TagLib::FLAC::Picture* picture{ new TagLib::FLAC::Picture() };
-                picture->setType(TagLib::FLAC::Picture::Type::FrontCover);
-                picture->setData(m_albumArt);
-                file.tag()->addPicture(picture);
+                std::error_code removeError;
+                std::filesystem::remove(*copyPath, removeError);
             }
-            file.save();
+            throw;
         }
+        if (preserveModificationTimeStamp)
+        {
+            std::filesystem::last_write_time(changes.path, changes.modificationTime);
+        }
+    }
+    //Tags written in place by TagLib, restored time stamps and renames are not durable on their own, so they are synced before the save journal counts the save as finished
+    if(isRenamed || isWritten)
+    {
+        FileHelpers::syncFile(changes.path, isRenamed);
+    }
+    changes.fileStat = DirectoryScanner::stat(changes.path);
+}
+
+void MusicFile::finishSave(const TagChanges& changes, bool success)
+{
+    //The file keeps its new name even if writing the tag afterwards failed
+    m_path = changes.path;
+    if(!success)
+    {
+        m_changedFields |= changes.changedFields;
+        m_isAlbumArtChanged = m_isAlbumArtChanged || changes.isAlbumArtChanged;
+        return;
     }
-    else if (m_dotExtension == ".opus")
-    {
-        TagLib::Ogg::Opus::File file{ m_path.c_str() };
-        file.tag()->setTitle({ m_title, TagLib::String::Type::UTF8 });
-        file.tag()->setArtist({ m_artist, TagLib::String::Type::UTF8 });
-        file.tag()->setAlbum({ m_album, TagLib::String::Type::UTF8 });
-        file.tag()->setYear(m_year);
-        file.tag()->setTrack(m_track);
-        file.tag()->addField("ALBUMARTIST", { m_albumArtist, TagLib::String::Type::UTF8 });
-        file.tag()->setGenre({ m_genre, TagLib::String::Type::UTF8 });
-        file.tag()->setComment({ m_comment, TagLib::String::Type::UTF8 });
-        file.tag()->removeAllPictures();
-        if (!m_albumArt.isEmpty())
+    if(changes.fileStat)
+    {
+        setFileStat(*changes.fileStat);
+    }
+    //The saved album art can be read back from disk, so the music file no longer needs to hold it unless it was changed again since
+    if(!m_isAlbumArtChanged)
+    {
+        m_albumArt = nullptr;
+    }
+}
+
+bool MusicFile::writeTag(const TagChanges& changes, const MusicFormat& format, const std::filesystem::path& path, unsigned int paddingSize)
+{
+    OpenedMusicFile file{ MusicFormatRegistry::getInstance().open(path, format, false) };
+    //Frames of unchanged fields (album art included) are left as they were read, only changed fields are replaced
+    forEachTagField([&](const auto& field)
+    {
+        if(isPositionField(field.index) || !isFieldChanged(changes, field.index))
         {
-            TagLib::FLAC::Picture* picture{ new TagLib::FLAC::Picture() };
-            picture->setType(TagLib::FLAC::Picture::Type::FrontCover);
-            picture->setData(m_albumArt);
-            file.tag()->addPicture(picture);
+            return;
         }
-        file.save();
-    }
-    else if (m_dotExtension == ".oga")
-    {
-        TagLib::Ogg::FLAC::File file{ m_path.c_str() };
-        file.tag()->setTitle({ m_title, TagLib::String::Type::UTF8 });
-        file.tag()->setArtist({ m_artist, TagLib::String::Type::UTF8 });
-        file.tag()->setAlbum({ m_album, TagLib::String::Type::UTF8 });
-        file.tag()->setYear(m_year);
-        file.tag()->setTrack(m_track);
-        file.tag()->addField("ALBUMARTIST", { m_albumArtist, TagLib::String::Type::UTF8 });
-        file.tag()->setGenre({ m_genre, TagLib::String::Type::UTF8 });
-        file.tag()->setComment({ m_comment, TagLib::String::Type::UTF8 });
-        file.tag()->removeAllPictures();
-        if (!m_albumArt.isEmpty())
+        if(field.setTagValue)
         {
-            TagLib::FLAC::Picture* picture{ new TagLib::FLAC::Picture() };
-            picture->setType(TagLib::FLAC::Picture::Type::FrontCover);
-            picture->setData(m_albumArt);
-            file.tag()->addPicture(picture);
+            (file.tag->*field.setTagValue)(changes.fields.*field.tagField);
         }
-        file.save();
-    }
-    else if (m_dotExtension == ".flac")
-    {
-        TagLib::FLAC::File file{ m_path.c_str() };
-        file.xiphComment(true)->setTitle({ m_title, TagLib::String::Type::UTF8 });
-        file.xiphComment(true)->setArtist({ m_artist, TagLib::String::Type::UTF8 });
-        file.xiphComment(true)->setAlbum({ m_album, TagLib::String::Type::UTF8 });
-        file.xiphComment(true)->setYear(m_year);
-        file.xiphComment(true)->setTrack(m_track);
-        file.xiphComment(true)->addField("ALBUMARTIST", { m_albumArtist, TagLib::String::Type::UTF8 });
-        file.xiphComment(true)->setGenre({ m_genre, TagLib::String::Type::UTF8 });
-        file.xiphComment(true)->setComment({ m_comment, TagLib::String::Type::UTF8 });
-        file.xiphComment(true)->removeAllPictures();
-        if (!m_albumArt.isEmpty())
+        else if constexpr(std::decay_t<decltype(field)>::isNumber)
         {
-            TagLib::FLAC::Picture* picture{ new TagLib::FLAC::Picture() };
-            picture->setType(TagLib::FLAC::Picture::Type::FrontCover);
-            picture->setData(m_albumArt);
-            file.xiphComment(true)->addPicture(picture);
+            format.tagHandler->setText(file.tag, field.keys, tagFieldToText(static_cast<std::uint32_t>(changes.fields.*field.tagField)));
         }
-        file.save();
-    }
-    else if (m_dotExtension == ".wma")
-    {
-        TagLib::ASF::File file{ m_path.c_str() };
-        file.tag()->setTitle({ m_title, TagLib::String::Type::UTF8 });
-        file.tag()->setArtist({ m_artist, TagLib::String::Type::UTF8 });
-        file.tag()->setAlbum({ m_album, TagLib::String::Type::UTF8 });
-        file.tag()->setYear(m_year);
-        file.tag()->setTrack(m_track);
-        file.tag()->removeItem("ALBUMARTIST");
-        file.tag()->addAttribute("ALBUMARTIST", { { m_albumArtist, TagLib::String::Type::UTF8 } });
-        file.tag()->setGenre({ m_genre, TagLib::String::Type::UTF8 });
-        file.tag()->setComment({ m_comment, TagLib::String::Type::UTF8 });
-        file.tag()->removeItem("WM/Picture");
-        file.tag()->addAttribute("WM/Picture", { m_albumArt });
-        file.save();
-    }
-    else if (m_dotExtension == ".wav")
-    {
-        TagLib::RIFF::WAV::File file{ m_path.c_str() };
-        file.ID3v2Tag()->setTitle({ m_title, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag()->setArtist({ m_artist, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag()->setAlbum({ m_album, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag()->setYear(m_year);
-        file.ID3v2Tag()->setTrack(m_track);
-        file.ID3v2Tag()->removeFrames("TPE2");
-        TagLib::ID3v2::TextIdentificationFrame* frameAlbumArtist{ new TagLib::ID3v2::TextIdentificationFrame("TPE2", TagLib::String::UTF8) };
-        frameAlbumArtist->setText({ m_albumArtist, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag()->addFrame(frameAlbumArtist);
-        file.ID3v2Tag()->setGenre({ m_genre, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag()->setComment({ m_comment, TagLib::String::Type::UTF8 });
-        file.ID3v2Tag()->removeFrames("APIC");
-        if (!m_albumArt.isEmpty())
+        else
         {
-            TagLib::ID3v2::AttachedPictureFrame* frameAlbumArt{ new TagLib::ID3v2::AttachedPictureFrame };
-            frameAlbumArt->setType(TagLib::ID3v2::AttachedPictureFrame::Type::FrontCover);
-            frameAlbumArt->setPicture(m_albumArt);
-            file.ID3v2Tag()->addFrame(frameAlbumArt);
+            format.tagHandler->setText(file.tag, field.keys, changes.fields.*field.tagField);
         }
-        file.save(TagLib::RIFF::WAV::File::TagTypes::ID3v2);
+    });
+    if(isFieldChanged(changes, TRACK_FIELD.index) || isFieldChanged(changes, TOTAL_TRACKS_FIELD.index))
+    {
+        format.tagHandler->setPosition(file.tag, TRACK_FIELD.keys, TOTAL_TRACKS_FIELD.keys, changes.fields.track, changes.fields.totalTracks);
     }
-    if (preserveModificationTimeStamp)
+    if(isFieldChanged(changes, DISC_NUMBER_FIELD.index) || isFieldChanged(changes, TOTAL_DISCS_FIELD.index))
     {
-        std::filesystem::last_write_time(m_path, m_modificationTimeStamp);
+        format.tagHandler->setPosition(file.tag, DISC_NUMBER_FIELD.keys, TOTAL_DISCS_FIELD.keys, changes.fields.discNumber, changes.fields.totalDiscs);
     }
-    else
+    if(changes.isAlbumArtChanged)
     {
-        m_modificationTimeStamp = std::filesystem::last_write_time(m_path);
+        format.tagHandler->setAlbumArt(file.tag, changes.fields.albumArt);
     }
+    if(format.renderHeader)
+    {
+        if(std::optional<RenderedHeader> header{ format.renderHeader(*file.file, file.tag, paddingSize) })
+        {
+            if(file.file->readOnly())
+            {
+                throw std::runtime_error("Unable to write the tag to the file.");
+            }
+            //A tag that fits its old space is written over it in place, else the file is rebuilt next to the old one with the audio copied by the kernel
+            if(header->data.size() == header->replacedSize)
+            {
+                file.file.reset();
+                FileHelpers::writeFileAt(path, header->data.data(), header->data.size(), 0);
+                return false;
+            }
+            //A file with hard links or an owner that cannot be kept on a new file is saved in place by TagLib instead
+            if(FileHelpers::replaceFileStart(path, header->data, header->replacedSize))
+            {
+                return true;
+            }
+        }
+    }
+    if(format.tagHandler->reservePadding)
+    {
+        format.tagHandler->reservePadding(*file.file, file.tag, paddingSize);
+    }
+    //A tag that still fits its space is written over the old one in place, only a change of size means the data after it was moved
+    long originalLength{ file.file->length() };
+    if(!format.save(*file.file))
+    {
+        throw std::runtime_error("Unable to write the tag to the file.");
+    }
+    return format.tagPlacement == TagPlacement::Start && file.file->length() != originalLength;
 }
 
 void MusicFile::removeTag()
 {
-    m_title = "";
-    m_artist = "";
-    m_album = "";
-    m_year = 0;
-    m_track = 0;
-    m_albumArtist = "";
-    m_genre = "";
-    m_comment = "";
-    m_albumArt = TagLib::ByteVector();
+    forEachTagField([&](const auto& field)
+    {
+        setField(field, typename std::decay_t<decltype(field)>::ValueType{});
+    });
+    setAlbumArt(TagLib::ByteVector());
 }
 
 bool MusicFile::filenameToTag(const std::string& formatString)
 {
-    if (formatString == "%artist%- %title%")
+    std::optional<std::vector<FormatPiece>> pieces{ parseFormatString(formatString) };
+    if(!pieces)
     {
-        std::size_t dashIndex{ getFilename().find("- ") };
-        if (dashIndex == std::string::npos)
-        {
-            return false;
-        }
-        m_artist = getFilename().substr(0, dashIndex);
-        m_title = getFilename().substr(dashIndex + 2, getFilename().find(m_path.extension().string()) - (getArtist().size() + 2));
+        return false;
     }
-    else if (formatString == "%title%- %artist%")
+    std::string name{ getFilename().substr(0, getFilename().find(m_path.extension().string())) };
+    std::vector<std::pair<std::size_t, std::string>> values;
+    std::size_t position{ 0 };
+    for(std::vector<FormatPiece>::const_iterator it{ pieces->begin() }; it != pieces->end(); it++)
     {
-        std::size_t dashIndex{ getFilename().find("- ") };
-        if (dashIndex == std::string::npos)
+        if(!it->fieldIndex)
         {
-            return false;
+            if(name.compare(position, it->text.size(), it->text) != 0)
+            {
+                return false;
+            }
+            position += it->text.size();
+            continue;
         }
-        m_title = getFilename().substr(0, dashIndex);
-        m_artist = getFilename().substr(dashIndex + 2, getFilename().find(m_path.extension().string()) - (getTitle().size() + 2));
-    }
-    else if (formatString == "%track%- %title%")
-    {
-        std::size_t dashIndex{ getFilename().find("- ") };
-        if (dashIndex == std::string::npos)
+        //A field runs until the literal text that follows it, or to the end of the filename for the last piece
+        std::vector<FormatPiece>::const_iterator next{ it + 1 };
+        if(next == pieces->end())
         {
-            return false;
+            values.push_back({ *it->fieldIndex, name.substr(position) });
+            position = name.size();
         }
-        std::string track{ getFilename().substr(0, dashIndex) };
-        try
+        else if(next->fieldIndex)
         {
-            m_track = MediaHelpers::stoui(track);
+            return false;
         }
-        catch (...)
+        else
         {
-            setTrack(0);
+            std::size_t end{ name.find(next->text, position) };
+            if(end == std::string::npos)
+            {
+                return false;
+            }
+            values.push_back({ *it->fieldIndex, name.substr(position, end - position) });
+            position = end;
         }
-        m_title = getFilename().substr(dashIndex + 2, getFilename().find(m_path.extension().string()) - (track.size() + 2));
     }
-    else if (formatString == "%title%")
+    if(values.empty() || position != name.size())
     {
-        m_title = getFilename().substr(0, getFilename().find(m_path.extension().string()));
+        return false;
     }
-    else
+    for(const std::pair<std::size_t, std::string>& value : values)
     {
-        return false;
+        forEachTagField([&](const auto& field)
+        {
+            if(field.index != value.first)
+            {
+                return;
+            }
+            if constexpr(std::decay_t<decltype(field)>::isNumber)
+            {
+                try
+                {
+                    setField(field, static_cast<std::uint32_t>(MediaHelpers::stoui(value.second)));
+                }
+                catch(...)
+                {
+                    setField(field, std::uint32_t{ 0 });
+                }
+            }
+            else
+            {
+                setField(field, typename std::decay_t<decltype(field)>::ValueType(value.second));
+            }
+        });
     }
     return true;
 }
 
 bool MusicFile::tagToFilename(const std::string& formatString)
 {
-    if (formatString == "%artist%- %title%")
+    std::optional<std::vector<FormatPiece>> pieces{ parseFormatString(formatString) };
+    if(!pieces)
     {
-        if (m_artist.empty() || m_title.empty())
-        {
-            return false;
-        }
-        return setFilename(m_artist + "- " + m_title + m_path.extension().string());
+        return false;
     }
-    else if (formatString == "%title%- %artist%")
+    std::string filename;
+    bool hasEmptyField{ false };
+    for(const FormatPiece& piece : *pieces)
     {
-        if (m_title.empty() || m_artist.empty())
+        if(!piece.fieldIndex)
         {
-            return false;
+            filename += piece.text;
+            continue;
         }
-        return setFilename(m_title + "- " + m_artist + m_path.extension().string());
-    }
-    else if (formatString == "%track%- %title%")
-    {
-        if (m_title.empty())
+        forEachTagField([&](const auto& field)
         {
-            return false;
-        }
-        return setFilename(std::to_string(m_track) + "- " + m_title + m_path.extension().string());
+            if(field.index != *piece.fieldIndex)
+            {
+                return;
+            }
+            const auto& value{ getField(field) };
+            if constexpr(!std::decay_t<decltype(field)>::isNumber)
+            {
+                hasEmptyField = hasEmptyField || value.empty();
+            }
+            filename += tagFieldToString(value);
+        });
     }
-    else if (formatString == "%title%")
+    if(hasEmptyField)
     {
-        if (m_title.empty())
-        {
-            return false;
-        }
-        return setFilename(m_title + m_path.extension().string());
+        return false;
     }
-    return false;
+    return setFilename(filename + m_path.extension().string());
 }
 
 bool MusicFile::downloadMusicBrainzMetadata(const std::string& acoustIdClientKey, bool overwriteTagWithMusicBrainz)
 {
+    if(m_columns.durations[m_row] < 0)
+    {
+        m_columns.durations[m_row] = readDuration(m_path);
+    }
     AcoustIdQuery acoustIdQuery{ acoustIdClientKey, getDuration(), getChromaprintFingerprint() };
     if(acoustIdQuery.lookup())
     {
         MusicBrainzRecordingQuery musicBrainzQuery{ acoustIdQuery.getRecordingId() };
         if(musicBrainzQuery.lookup())
         {
-            if(overwriteTagWithMusicBrainz || m_title.empty())
+            if(overwriteTagWithMusicBrainz || m_columns.titles[m_row].empty())
             {
-                m_title = musicBrainzQuery.getTitle();
+                setTitle(musicBrainzQuery.getTitle());
             }
-            if(overwriteTagWithMusicBrainz || m_artist.empty())
+            if(overwriteTagWithMusicBrainz || m_columns.artists[m_row].empty())
             {
-                m_artist = musicBrainzQuery.getArtist();
+                setArtist(musicBrainzQuery.getArtist());
             }
-            if(overwriteTagWithMusicBrainz || m_album.empty())
+            if(overwriteTagWithMusicBrainz || m_columns.albums[m_row].empty())
             {
-                m_album = musicBrainzQuery.getAlbum();
+                setAlbum(musicBrainzQuery.getAlbum());
             }
-            if(overwriteTagWithMusicBrainz || m_year == 0)
+            if(overwriteTagWithMusicBrainz || m_columns.years[m_row] == 0)
             {
-                m_year = musicBrainzQuery.getYear();
+                setYear(musicBrainzQuery.getYear());
             }
-            if(overwriteTagWithMusicBrainz || m_albumArtist.empty())
+            if(overwriteTagWithMusicBrainz || m_columns.albumArtists[m_row].empty())
             {
-                m_albumArtist = musicBrainzQuery.getAlbumArtist();
+                setAlbumArtist(musicBrainzQuery.getAlbumArtist());
             }
-            if(overwriteTagWithMusicBrainz || m_genre.empty())
+            if(overwriteTagWithMusicBrainz || m_columns.genres[m_row].empty())
             {
-                m_genre = musicBrainzQuery.getGenre();
+                setGenre(musicBrainzQuery.getGenre());
             }
-            if(overwriteTagWithMusicBrainz || m_albumArt.isEmpty())
+            if(overwriteTagWithMusicBrainz || !getHasAlbumArt())
             {
-                m_albumArt = musicBrainzQuery.getAlbumArt();
+                setAlbumArt(musicBrainzQuery.getAlbumArt());
             }
             return true;
         }
@@ -784,16 +829,20 @@ bool MusicFile::downloadMusicBrainzMetadata(const std::string& acoustIdClientKey
 
 bool MusicFile::submitToAcoustId(const std::string& acoustIdClientAPIKey, const std::string& acoustIdUserAPIKey, const std::string& musicBrainzRecordingId)
 {
+    if(m_columns.durations[m_row] < 0)
+    {
+        m_columns.durations[m_row] = readDuration(m_path);
+    }
     AcoustIdSubmission submission{ acoustIdClientAPIKey, acoustIdUserAPIKey, getDuration(), getChromaprintFingerprint() };
     if(musicBrainzRecordingId.empty())
     {
         TagMap tagMap;
-        tagMap.setTitle(m_title);
-        tagMap.setArtist(m_artist);
-        tagMap.setAlbum(m_album);
-        tagMap.setYear(std::to_string(m_year));
-        tagMap.setTrack(std::to_string(m_track));
-        tagMap.setAlbumArtist(m_albumArtist);
+        tagMap.setTitle(m_columns.titles[m_row]);
+        tagMap.setArtist(m_columns.artists[m_row]);
+        tagMap.setAlbum(m_columns.albums[m_row]);
+        tagMap.setYear(std::to_string(m_columns.years[m_row]));
+        tagMap.setTrack(std::to_string(m_columns.tracks[m_row]));
+        tagMap.setAlbumArtist(m_columns.albumArtists[m_row]);
         return submission.submitTagMetadata(tagMap);
     }
     return submission.submitMusicBrainzRecordingId(musicBrainzRecordingId);
@@ -1,13 +1,44 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <taglib/tbytevector.h>
+#include "albumartstore.hpp"
+#include "directoryscanner.hpp"
+#include "librarystore.hpp"
+#include "musicformat.hpp"
+#include "tagcache.hpp"
+#include "tagfield.hpp"
 
 namespace NickvisionTagger::Models
 {
     /**
-     * A model of a music file
+     * The unsaved changes of a music file, copied out of the music file so they can be written to disk on another thread while the music file keeps being edited
+     */
+    struct TagChanges
+    {
+    	/**
+    	 * The path of the file on disk, updated by MusicFile::writeChanges once the file is renamed
+    	 */
+    	std::filesystem::path path;
+    	std::string filename;
+    	std::uint32_t changedFields{ 0 };
+    	TagFields fields;
+    	bool isAlbumArtChanged{ false };
+    	std::filesystem::file_time_type modificationTime;
+    	/**
+    	 * The stat record of the file after the changes were written
+    	 */
+    	std::optional<FileStat> fileStat;
+    	bool rewritten{ false };
+    };
+
+    /**
+     * A model of a music file. The tag metadata and stat record of the music file are held in a row of the LibraryStore, which the music file is a view into
      */
     class MusicFile
     {
@@ -19,6 +50,35 @@ namespace NickvisionTagger::Models
     	 * @throws std::invalid_argument Thrown when the path is an invalid music file
     	 */
     	MusicFile(const std::filesystem::path& path);
+    	/**
+    	 * Constructs a MusicFile from the metadata of the file collected while scanning, so the file is not stat'ed again
+    	 *
+    	 * @param path The path of the music file
+    	 * @param fileStat The metadata of the file on disk
+    	 * @throws std::invalid_argument Thrown when the path is an invalid music file
+    	 */
+    	MusicFile(const std::filesystem::path& path, const FileStat& fileStat);
+    	/**
+    	 * Constructs a MusicFile from cached tag metadata without reading the file on disk
+    	 *
+    	 * @param path The path of the music file
+    	 * @param fileStat The metadata of the file on disk
+    	 * @param cacheEntry The cached tag metadata of the music file
+    	 */
+    	MusicFile(const std::filesystem::path& path, const FileStat& fileStat, const TagCacheEntry& cacheEntry);
+    	/**
+    	 * Destructs a MusicFile, releasing its row in the LibraryStore
+    	 */
+    	~MusicFile();
+    	MusicFile(const MusicFile&) = delete;
+    	MusicFile& operator=(const MusicFile&) = delete;
+    	/**
+    	 * Reads the duration of a music file from disk, scanning the audio accurately. This is slow for some formats (e.g. VBR MP3) and is meant to run in the background
+    	 *
+    	 * @param path The path of the music file
+    	 * @returns The duration of the music file (in seconds), or 0 if it could not be read
+    	 */
+    	static int readDuration(const std::filesystem::path& path);
     	/**
     	 * Gets the path of the music file
     	 *
@@ -26,9 +86,27 @@ namespace NickvisionTagger::Models
     	 */
     	const std::filesystem::path& getPath() const;
     	/**
-    	 * Loads the tag metadata from the file on disk (discarding any unapplied metadata)
+    	 * Loads the tag metadata from the file on disk (discarding any unapplied metadata), refreshing the stat record first. Audio properties are not read, and the duration becomes unknown if the file changed on disk
     	 */
     	void loadFromDisk();
+    	/**
+    	 * Gets the stat record of the music file. The record is taken when the music file is scanned or saved and only refreshed by loadFromDisk and refreshFileStat, so reading it never touches the filesystem
+    	 *
+    	 * @returns The size, modification time and inode of the file on disk
+    	 */
+    	FileStat getFileStat() const;
+    	/**
+    	 * Gets the row of the music file in the LibraryStore
+    	 *
+    	 * @returns The row of the music file
+    	 */
+    	std::uint32_t getRow() const;
+    	/**
+    	 * Stats the file on disk again and updates the stat record. Meant for explicit reloads and watcher events. The duration becomes unknown if the file changed
+    	 *
+    	 * @returns True if the file changed on disk since the record was taken, else false (including when the file could not be stat'ed)
+    	 */
+    	bool refreshFileStat();
 		/**
 		 * Gets the filename of the music file (includes the dot extension)
 		 *
@@ -42,6 +120,39 @@ namespace NickvisionTagger::Models
     	 * @returns True if the new filename is available, else false if already exists on disk
     	 */
     	bool setFilename(const std::string& filename);
+    	/**
+    	 * Gets the value of a tag field of the music file
+    	 *
+    	 * @param field The descriptor of the tag field
+    	 * @returns The value of the tag field
+    	 */
+    	template<typename Value, bool Sparse>
+    	const Value& getField(const TagFieldDescriptor<Value, Sparse>& field) const
+    	{
+    	    return getTagFieldValue(m_columns, m_row, field);
+    	}
+    	/**
+    	 * Sets the value of a tag field of the music file, marking the field as changed if the value differs
+    	 *
+    	 * @param field The descriptor of the tag field
+    	 * @param value The new value of the tag field
+    	 */
+    	template<typename Value, bool Sparse>
+    	void setField(const TagFieldDescriptor<Value, Sparse>& field, const Value& value)
+    	{
+    	    if(getField(field) == value)
+    	    {
+    	        return;
+    	    }
+    	    setTagFieldValue(m_columns, m_row, field, value);
+    	    m_changedFields |= 1u << field.index;
+    	}
+    	/**
+    	 * Gets whether or not the music file has changes (tag fields, album art or filename) that are not yet saved to disk
+    	 *
+    	 * @returns True if there are unsaved changes, else false
+    	 */
+    	bool getHasUnsavedChanges() const;
     	/**
     	 * Gets the title of the music file
     	 *
@@ -60,6 +171,12 @@ namespace NickvisionTagger::Models
 		 * @returns The artist of the music file
 		 */
     	const std::string& getArtist() const;
+    	/**
+    	 * Gets the ID of the artist of the music file in the StringPool
+    	 *
+    	 * @returns The ID of the artist of the music file
+    	 */
+    	std::uint32_t getArtistId() const;
     	/**
     	 * Sets the artist of the music file
     	 *
@@ -72,6 +189,12 @@ namespace NickvisionTagger::Models
     	 * @returns The album of the music file
     	 */
     	const std::string& getAlbum() const;
+    	/**
+    	 * Gets the ID of the album of the music file in the StringPool
+    	 *
+    	 * @returns The ID of the album of the music file
+    	 */
+    	std::uint32_t getAlbumId() const;
     	/**
     	 * Sets the album of the music file
     	 *
@@ -108,6 +231,12 @@ namespace NickvisionTagger::Models
     	 * @returns The album artist of the music file
     	 */
     	const std::string& getAlbumArtist() const;
+    	/**
+    	 * Gets the ID of the album artist of the music file in the StringPool
+    	 *
+    	 * @returns The ID of the album artist of the music file
+    	 */
+    	std::uint32_t getAlbumArtistId() const;
     	/**
     	 * Sets the album artist of the music file
     	 *
@@ -120,6 +249,12 @@ namespace NickvisionTagger::Models
     	 * @returns The genre of the music file
     	 */
     	const std::string& getGenre() const;
+    	/**
+    	 * Gets the ID of the genre of the music file in the StringPool
+    	 *
+    	 * @returns The ID of the genre of the music file
+    	 */
+    	std::uint32_t getGenreId() const;
     	/**
     	 * Sets the genre of the music file
     	 *
@@ -139,11 +274,11 @@ namespace NickvisionTagger::Models
     	 */
     	void setComment(const std::string& comment);
     	/**
-    	 * Gets the album art of the music file (as TagLib::ByteVector)
+    	 * Gets the album art of the music file (as TagLib::ByteVector). Album art that was not changed is read from disk on demand and shared through the AlbumArtStore
     	 *
     	 * @returns The album art of the music file
     	 */
-		const TagLib::ByteVector& getAlbumArt() const;
+		TagLib::ByteVector getAlbumArt() const;
 		/**
 		 * Sets the album art of the music file
 		 *
@@ -151,19 +286,49 @@ namespace NickvisionTagger::Models
 		 */
 		void setAlbumArt(const TagLib::ByteVector& albumArt);
 		/**
-		 * Gets the duration of the music file (in seconds)
+		 * Sets the album art of the music file to album art already held by the AlbumArtStore
+		 *
+		 * @param albumArt The new album art of the music file
+		 */
+		void setAlbumArt(const std::shared_ptr<const AlbumArt>& albumArt);
+		/**
+		 * Gets whether or not the music file has album art (without loading the album art)
+		 *
+		 * @returns True if the music file has album art, else false
+		 */
+		bool getHasAlbumArt() const;
+		/**
+		 * Gets the content hash of the album art of the music file (without loading the album art). Music files with identical album art have the same hash
+		 *
+		 * @returns The hash of the album art, or 0 if the music file has no album art
+		 */
+		std::uint64_t getAlbumArtHash() const;
+		/**
+		 * Gets the size of the album art of the music file (without loading the album art)
 		 *
-		 * @returns The duration of the music file
+		 * @returns The size of the album art in bytes
+		 */
+		std::uintmax_t getAlbumArtSize() const;
+		/**
+		 * Gets the duration of the music file (in seconds). Tags are loaded without audio properties, so the duration stays unknown until it is read by readDuration and set with setDuration
+		 *
+		 * @returns The duration of the music file, or -1 if not yet known
 		 */
 		int getDuration() const;
+		/**
+		 * Sets the duration of the music file as read by readDuration
+		 *
+		 * @param duration The duration of the music file (in seconds)
+		 */
+		void setDuration(int duration);
 		/**
 		 * Gets the duration of the music file as a human-readable string (hh::mm::ss)
 		 *
-		 * @returns The duration of the music file as a human-readable string
+		 * @returns The duration of the music file as a human-readable string, or an empty string if not yet known
 		 */
 		std::string getDurationAsString() const;
 		/**
-		 * Gets the file size of the music file (in bytes)
+		 * Gets the file size of the music file (in bytes) from the stat record
 		 *
 		 * @returns The file size of the music file
 		 */
@@ -175,17 +340,72 @@ namespace NickvisionTagger::Models
 		 */
 		std::string getFileSizeAsString() const;
 		/**
-		 * Gets the chromaprint fingerprint for the music file
+		 * Computes the chromaprint fingerprint of a music file by decoding its audio in process, up to the length set on the Fingerprinter. This takes a second or more and is meant to run in the background
+		 *
+		 * @param path The path of the music file
+		 * @param isCancelled A function polled while computing that returns true to stop early (empty to never stop)
+		 * @returns The chromaprint fingerprint, or an empty string if it could not be computed or was cancelled
+		 */
+		static std::string readChromaprintFingerprint(const std::filesystem::path& path, const std::function<bool()>& isCancelled = {});
+		/**
+		 * Gets the chromaprint fingerprint for the music file, computing it first if not yet known
 		 *
 		 * @returns The chromaprint fingerprint for the music file
 		 */
 		const std::string& getChromaprintFingerprint();
 		/**
-		 * Saves the tag of the music file
+		 * Gets whether or not the chromaprint fingerprint of the music file is known, so getChromaprintFingerprint returns without computing it
+		 *
+		 * @returns True if the fingerprint is known, else false
+		 */
+		bool getHasChromaprintFingerprint() const;
+		/**
+		 * Sets the chromaprint fingerprint of the music file as computed by readChromaprintFingerprint
 		 *
+		 * @param fingerprint The chromaprint fingerprint
+		 */
+		void setChromaprintFingerprint(const std::string& fingerprint);
+		/**
+		 * Gets the tag metadata of the music file in the form stored by the TagCache
+		 *
+		 * @returns The TagCacheEntry for the music file
+		 */
+		TagCacheEntry getTagCacheEntry() const;
+		/**
+		 * Saves the changes of the music file. Only the tag fields and album art that changed are written, and a music file without changes is not touched. A file that has to be rewritten is rebuilt next to the old one and renamed over it, so a crash never leaves a half-written file
+		 *
+		 * @param preserveModificationTimeStamp Set true to preserve the modification time stamp of the file, else false
+		 * @param paddingSize The padding to reserve (in bytes) when the tag outgrows its space, so later saves fit in place
+		 * @returns True if the tag outgrew its space and the whole file had to be rewritten, else false
+		 * @throws std::invalid_argument Thrown when the file can no longer be opened as a music file
+		 * @throws std::runtime_error Thrown when the tag could not be written to the file
+		 * @throws std::filesystem::filesystem_error Thrown when the file could not be renamed or rewritten
+		 */
+		bool saveTag(bool preserveModificationTimeStamp, unsigned int paddingSize);
+		/**
+		 * Takes the unsaved changes of the music file so they can be written with writeChanges. The music file has no unsaved changes afterwards until it is edited again, or finishSave gives back changes that failed to save
+		 *
+		 * @returns The unsaved changes of the music file
+		 */
+		TagChanges takeChanges();
+		/**
+		 * Writes changes taken from a music file to disk, syncing the file before returning. Only the file on disk and the changes are touched, so this can run on any thread
+		 *
+		 * @param changes The changes to write (the path, stat record and rewritten flag are updated)
 		 * @param preserveModificationTimeStamp Set true to preserve the modification time stamp of the file, else false
+		 * @param paddingSize The padding to reserve (in bytes) when the tag outgrows its space
+		 * @throws std::invalid_argument Thrown when the file can no longer be opened as a music file
+		 * @throws std::runtime_error Thrown when the tag could not be written to the file
+		 * @throws std::filesystem::filesystem_error Thrown when the file could not be renamed, rewritten or synced
 		 */
-		void saveTag(bool preserveModificationTimeStamp);
+		static void writeChanges(TagChanges& changes, bool preserveModificationTimeStamp, unsigned int paddingSize);
+		/**
+		 * Finishes saving changes taken with takeChanges, once writeChanges returned or threw
+		 *
+		 * @param changes The changes that were written
+		 * @param success True if the changes were written, else false to mark them as unsaved again
+		 */
+		void finishSave(const TagChanges& changes, bool success);
 		/**
 		 * Removes the tag of the music file
 		 */
@@ -251,20 +471,39 @@ namespace NickvisionTagger::Models
 		bool operator!=(const MusicFile& toCompare) const;
 
     private:
+		/**
+		 * Reads the tag metadata from the file on disk
+		 *
+		 * @throws std::invalid_argument Thrown when the path is an invalid music file
+		 */
+		void loadTag();
+		/**
+		 * Sets the stat record of the music file
+		 *
+		 * @param fileStat The metadata of the file on disk
+		 */
+		void setFileStat(const FileStat& fileStat);
+		/**
+		 * Writes changed tag fields and album art to a file
+		 *
+		 * @param changes The changes to write
+		 * @param format The format of the music file
+		 * @param path The path of the file to write (the music file itself or a copy of it)
+		 * @param paddingSize The padding to reserve (in bytes) when the tag outgrows its space
+		 * @returns True if the tag outgrew its space and the whole file had to be rewritten, else false
+		 * @throws std::invalid_argument Thrown when the file can no longer be opened as a music file
+		 * @throws std::runtime_error Thrown when the tag could not be written to the file
+		 * @throws std::filesystem::filesystem_error Thrown when the file could not be rewritten
+		 */
+		static bool writeTag(const TagChanges& changes, const MusicFormat& format, const std::filesystem::path& path, unsigned int paddingSize);
 		std::filesystem::path m_path;
 		std::string m_filename;
 		std::string m_dotExtension;
-        std::filesystem::file_time_type m_modificationTimeStamp;
-        std::string m_title;
-        std::string m_artist;
-        std::string m_album;
-        unsigned int m_year;
-        unsigned int m_track;
-        std::string m_albumArtist;
-        std::string m_genre;
-        std::string m_comment;
-        TagLib::ByteVector m_albumArt;
-        int m_duration;
+        LibraryColumns& m_columns;
+        std::uint32_t m_row;
+        std::shared_ptr<const AlbumArt> m_albumArt;
+        bool m_isAlbumArtChanged;
+        std::uint32_t m_changedFields;
         std::string m_fingerprint;
     };
 }
\ No newline at end of file
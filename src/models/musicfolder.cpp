@@ -1,9 +1,39 @@
 #include "musicfolder.hpp"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+#include "directoryscanner.hpp"
+#include "musicformat.hpp"
+#include "../helpers/boundedqueue.hpp"
 
+using namespace NickvisionTagger::Helpers;
 using namespace NickvisionTagger::Models;
 
-MusicFolder::MusicFolder() : m_parentPath{ "" }, m_includeSubfolders{ true }
+//Limits for how many loaded files or how much time a worker accumulates before handing a batch over
+static const std::size_t MAX_BATCH_SIZE{ 64 };
+static const std::chrono::milliseconds MAX_BATCH_DELAY{ 100 };
+
+//Files are ordered by filename, with ties broken by path to keep the order stable between scans
+static bool compareMusicFiles(const std::shared_ptr<MusicFile>& a, const std::shared_ptr<MusicFile>& b)
+{
+    if(*a < *b)
+    {
+        return true;
+    }
+    return !(*b < *a) && a->getPath() < b->getPath();
+}
+
+bool MusicFolder::isSupportedMusicFile(const std::filesystem::path& path)
+{
+    return MusicFormatRegistry::getInstance().isSupported(path);
+}
+
+MusicFolder::MusicFolder() : m_parentPath{ "" }, m_includeSubfolders{ true }, m_workerCount{ 0 }
 {
 
 }
@@ -28,48 +58,219 @@ void MusicFolder::setIncludeSubfolders(bool includeSubfolders)
     m_includeSubfolders = includeSubfolders;
 }
 
+unsigned int MusicFolder::getWorkerCount() const
+{
+    return m_workerCount;
+}
+
+void MusicFolder::setWorkerCount(unsigned int workerCount)
+{
+    m_workerCount = workerCount;
+}
+
+void MusicFolder::setTagCache(const std::shared_ptr<TagCache>& tagCache)
+{
+    m_tagCache = tagCache;
+}
+
 const std::vector<std::shared_ptr<MusicFile>>& MusicFolder::getMusicFiles() const
 {
     return m_files;
 }
 
-void MusicFolder::reloadMusicFiles()
+void MusicFolder::reloadMusicFiles(const std::function<bool(const std::vector<std::shared_ptr<MusicFile>>&)>& batchCallback)
 {
     m_files.clear();
     if (std::filesystem::exists(m_parentPath))
     {
-        std::vector<std::string> supportedDotFileExtensions{ ".mp3", ".m4a", ".ogg", ".opus", ".oga", ".flac", ".wma", ".wav" };
-        if (m_includeSubfolders)
+        unsigned int workerCount{ m_workerCount > 0 ? m_workerCount : std::max(std::thread::hardware_concurrency(), 1u) };
+        BoundedQueue<ScannedFile> scannedFiles{ workerCount * 64 };
+        std::mutex filesMutex;
+        std::atomic<bool> isCancelled{ false };
+        std::vector<std::thread> workers;
+        //Reserved up front so adding a started thread cannot throw, and a thread that fails to start stops the ones already running rather than leaving them joinable
+        workers.reserve(workerCount);
+        try
         {
-            for (const std::filesystem::path& path : std::filesystem::recursive_directory_iterator(m_parentPath, std::filesystem::directory_options::skip_permission_denied))
+            for(unsigned int i = 0; i < workerCount; i++)
             {
-                if(std::find(supportedDotFileExtensions.begin(), supportedDotFileExtensions.end(), path.extension()) != supportedDotFileExtensions.end())
+                workers.emplace_back([&]()
                 {
-                    try
+                    std::vector<std::shared_ptr<MusicFile>> batch;
+                    std::chrono::steady_clock::time_point lastFlush{ std::chrono::steady_clock::now() };
+                    //Hands the batch over to the files list (and the batch callback) so loaded files become visible before the scan completes
+                    std::function<void()> flush{ [&]()
                     {
-                        m_files.push_back(std::make_shared<MusicFile>(path));
+                        std::lock_guard<std::mutex> lock{ filesMutex };
+                        if(batchCallback && !isCancelled && !batchCallback(batch))
+                        {
+                            isCancelled = true;
+                            scannedFiles.close();
+                        }
+                        if(!isCancelled)
+                        {
+                            m_files.insert(m_files.end(), batch.begin(), batch.end());
+                        }
+                        batch.clear();
+                        lastFlush = std::chrono::steady_clock::now();
+                    } };
+                    while(std::optional<ScannedFile> scannedFile{ scannedFiles.pop() })
+                    {
+                        if(isCancelled)
+                        {
+                            continue;
+                        }
+                        try
+                        {
+                            const std::filesystem::path& path{ scannedFile->path };
+                            const std::optional<FileStat>& fileStat{ scannedFile->stat };
+                            std::optional<TagCacheEntry> cacheEntry{ std::nullopt };
+                            if(m_tagCache && fileStat)
+                            {
+                                cacheEntry = m_tagCache->lookup(path, fileStat->size, fileStat->modificationTime.time_since_epoch().count());
+                            }
+                            if(cacheEntry)
+                            {
+                                batch.push_back(std::make_shared<MusicFile>(path, *fileStat, *cacheEntry));
+                            }
+                            else
+                            {
+                                //The music file keeps the stat taken while walking, so its cache entry is keyed by the state before parsing and a file changed mid-parse is re-read next time
+                                std::shared_ptr<MusicFile> musicFile{ fileStat ? std::make_shared<MusicFile>(path, *fileStat) : std::make_shared<MusicFile>(path) };
+                                if(m_tagCache && fileStat)
+                                {
+                                    m_tagCache->update(path, musicFile->getTagCacheEntry());
+                                }
+                                batch.push_back(musicFile);
+                            }
+                        }
+                        catch(...) {  }
+                        if(batch.size() >= MAX_BATCH_SIZE || (!batch.empty() && std::chrono::steady_clock::now() - lastFlush >= MAX_BATCH_DELAY))
+                        {
+                            flush();
+                        }
                     }
-                    catch(...) {  }
-                }
+                    flush();
+                });
             }
         }
-        else
+        catch(...)
         {
-            for (const std::filesystem::path& path : std::filesystem::directory_iterator(m_parentPath))
+            scannedFiles.close();
+            for(std::thread& worker : workers)
             {
-                if(std::find(supportedDotFileExtensions.begin(), supportedDotFileExtensions.end(), path.extension()) != supportedDotFileExtensions.end())
-                {
-                    try
-                    {
-                        m_files.push_back(std::make_shared<MusicFile>(path));
-                    }
-                    catch(...) {  }
-                }
+                worker.join();
+            }
+            throw;
+        }
+        //Walk the folder on this thread while the workers load files
+        std::unordered_set<std::string> foundPaths;
+        std::exception_ptr walkException{ nullptr };
+        try
+        {
+            DirectoryScanner scanner{ m_parentPath, m_includeSubfolders, isSupportedMusicFile };
+            scanner.scan([&](const ScannedFile& scannedFile)
+            {
+                foundPaths.insert(scannedFile.path.string());
+                return scannedFiles.push(scannedFile);
+            });
+        }
+        catch(...)
+        {
+            walkException = std::current_exception();
+        }
+        scannedFiles.close();
+        for(std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        if(walkException)
+        {
+            m_files.clear();
+            std::rethrow_exception(walkException);
+        }
+        if(m_tagCache)
+        {
+            if(m_includeSubfolders && !isCancelled)
+            {
+                m_tagCache->prune(m_parentPath, foundPaths);
             }
+            m_tagCache->save();
         }
-        std::sort(m_files.begin(), m_files.end(), [](const std::shared_ptr<MusicFile>& a, const std::shared_ptr<MusicFile>& b)
+        //Workers finish in any order, so the list is only sorted once all have finished
+        std::sort(m_files.begin(), m_files.end(), compareMusicFiles);
+    }
+}
+
+std::optional<std::size_t> MusicFolder::getMusicFileIndex(const std::filesystem::path& path) const
+{
+    for(std::size_t i = 0; i < m_files.size(); i++)
+    {
+        if(m_files[i]->getPath() == path)
         {
-            return *a < *b;
-        });
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::size_t> MusicFolder::addMusicFile(const std::filesystem::path& path)
+{
+    if(getMusicFileIndex(path))
+    {
+        return std::nullopt;
+    }
+    std::shared_ptr<MusicFile> musicFile{ nullptr };
+    try
+    {
+        musicFile = std::make_shared<MusicFile>(path);
+    }
+    catch(...)
+    {
+        return std::nullopt;
+    }
+    if(m_tagCache)
+    {
+        m_tagCache->update(path, musicFile->getTagCacheEntry());
+    }
+    std::vector<std::shared_ptr<MusicFile>>::iterator it{ m_files.insert(std::upper_bound(m_files.begin(), m_files.end(), musicFile, compareMusicFiles), musicFile) };
+    return std::distance(m_files.begin(), it);
+}
+
+std::optional<std::size_t> MusicFolder::reloadMusicFile(const std::filesystem::path& path)
+{
+    std::optional<std::size_t> index{ getMusicFileIndex(path) };
+    if(!index || !m_files[*index]->refreshFileStat())
+    {
+        return std::nullopt;
+    }
+    try
+    {
+        m_files[*index]->loadFromDisk();
+    }
+    catch(...)
+    {
+        return std::nullopt;
+    }
+    if(m_tagCache)
+    {
+        m_tagCache->update(path, m_files[*index]->getTagCacheEntry());
+    }
+    return index;
+}
+
+std::vector<std::size_t> MusicFolder::removeMusicFiles(const std::filesystem::path& path)
+{
+    std::vector<std::size_t> indexes;
+    std::string folderPrefix{ path.string() + "/" };
+    for(std::size_t i = m_files.size(); i > 0; i--)
+    {
+        const std::string filePath{ m_files[i - 1]->getPath().string() };
+        if(filePath == path.string() || filePath.rfind(folderPrefix, 0) == 0)
+        {
+            m_files.erase(m_files.begin() + (i - 1));
+            indexes.push_back(i - 1);
+        }
     }
+    return indexes;
 }
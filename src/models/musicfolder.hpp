@@ -1,10 +1,13 @@
 #pragma once
 
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include "musicfile.hpp"
+#include "tagcache.hpp"
 
 namespace NickvisionTagger::Models
 {
@@ -18,6 +21,13 @@ namespace NickvisionTagger::Models
      	 * Constructs a MusicFolder
      	 */
     	MusicFolder();
+    	/**
+    	 * Gets whether or not a path has the extension of a music file supported by the MusicFolder
+    	 *
+    	 * @param path The path to check
+    	 * @returns True if supported, else false
+    	 */
+    	static bool isSupportedMusicFile(const std::filesystem::path& path);
     	/**
     	 * Gets the parent path of the music folder
     	 *
@@ -42,6 +52,24 @@ namespace NickvisionTagger::Models
     	 * @param includeSubfolders True to include subfolders, else false
     	 */
     	void setIncludeSubfolders(bool includeSubfolders);
+    	/**
+    	 * Gets the number of worker threads used to load music files during a scan
+    	 *
+    	 * @returns The number of worker threads (0 to use one per hardware thread)
+    	 */
+    	unsigned int getWorkerCount() const;
+    	/**
+    	 * Sets the number of worker threads used to load music files during a scan
+    	 *
+    	 * @param workerCount The new number of worker threads (0 to use one per hardware thread)
+    	 */
+    	void setWorkerCount(unsigned int workerCount);
+    	/**
+    	 * Sets the tag cache used to skip reading unchanged music files during a scan
+    	 *
+    	 * @param tagCache The TagCache to use, or nullptr to always read music files from disk
+    	 */
+    	void setTagCache(const std::shared_ptr<TagCache>& tagCache);
     	/**
     	 * Gets a list of MusicFile objects representing music files found in the music folder
     	 *
@@ -50,12 +78,49 @@ namespace NickvisionTagger::Models
     	const std::vector<std::shared_ptr<MusicFile>>& getMusicFiles() const;
     	/**
     	 * Scans the music folder for music files and populates the files list. If includeSubfolders is true, scans subfolders as well. If false, only the parent path
+    	 *
+    	 * Files found while walking the folder are fed through a bounded queue, along with the metadata the DirectoryScanner collected for them, to a pool of worker threads that load the music files concurrently. The files list is sorted once all workers have finished
+    	 * If a tag cache is set, files whose size and modification time match the cache are constructed from it instead of being read from disk
+    	 * If a batch callback is set, loaded files are also passed to it in batches while the scan is still running. The callback is called from the worker threads, one batch at a time
+    	 *
+    	 * @param batchCallback A bool(const std::vector<std::shared_ptr<MusicFile>>&) function receiving each batch of loaded files, returning false to cancel the scan
+    	 * @throws std::system_error Thrown when a worker thread could not be started (the workers already started are stopped first)
+    	 */
+    	void reloadMusicFiles(const std::function<bool(const std::vector<std::shared_ptr<MusicFile>>&)>& batchCallback = nullptr);
+    	/**
+    	 * Gets the index of a music file in the files list
+    	 *
+    	 * @param path The path of the music file
+    	 * @returns The index of the music file, or std::nullopt if it is not in the files list
+    	 */
+    	std::optional<std::size_t> getMusicFileIndex(const std::filesystem::path& path) const;
+    	/**
+    	 * Loads a music file and inserts it into the files list at its sorted position
+    	 *
+    	 * @param path The path of the music file
+    	 * @returns The index of the inserted music file, or std::nullopt if the file could not be loaded or is already in the files list
+    	 */
+    	std::optional<std::size_t> addMusicFile(const std::filesystem::path& path);
+    	/**
+    	 * Reloads a music file in the files list from disk if its stat record shows it was modified since it was last loaded or saved
+    	 *
+    	 * @param path The path of the music file
+    	 * @returns The index of the reloaded music file, or std::nullopt if the file is not in the files list or was not modified
+    	 */
+    	std::optional<std::size_t> reloadMusicFile(const std::filesystem::path& path);
+    	/**
+    	 * Removes a music file, or every music file inside a removed folder, from the files list
+    	 *
+    	 * @param path The path of the removed music file or folder
+    	 * @returns The indexes the removed music files had, in descending order
     	 */
-    	void reloadMusicFiles();
+    	std::vector<std::size_t> removeMusicFiles(const std::filesystem::path& path);
 
     private:
 		std::filesystem::path m_parentPath;
 		bool m_includeSubfolders;
+		unsigned int m_workerCount;
+		std::shared_ptr<TagCache> m_tagCache;
 		std::vector<std::shared_ptr<MusicFile>> m_files;
     };
 }
\ No newline at end of file
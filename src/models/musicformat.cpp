@@ -0,0 +1,1055 @@
+#include "musicformat.hpp"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <taglib/aifffile.h>
+#include <taglib/apefile.h>
+#include <taglib/apetag.h>
+#include <taglib/asffile.h>
+#include <taglib/attachedpictureframe.h>
+#include <taglib/commentsframe.h>
+#include <taglib/flacfile.h>
+#include <taglib/id3v1genres.h>
+#include <taglib/id3v2header.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/mp4file.h>
+#include <taglib/mpcfile.h>
+#include <taglib/mpegfile.h>
+#include <taglib/oggflacfile.h>
+#include <taglib/opusfile.h>
+#include <taglib/textidentificationframe.h>
+#include <taglib/uniquefileidentifierframe.h>
+#include <taglib/unsynchronizedlyricsframe.h>
+#include <taglib/vorbisfile.h>
+#include <taglib/wavfile.h>
+#include <taglib/wavpackfile.h>
+#include "tagfield.hpp"
+#include "../helpers/filehelpers.hpp"
+
+using namespace NickvisionTagger::Helpers;
+using namespace NickvisionTagger::Models;
+
+//Enough bytes to hold the identification header of every format, including the first packet of an Ogg stream
+static const unsigned int HEADER_SIZE{ 64 };
+//The padding TagLib gives an ID3v2 tag that outgrew its space, and the share of the file size above which it drops larger padding
+static const unsigned int ID3V2_MIN_PADDING{ 1024 };
+static const unsigned int ID3V2_MAX_PADDING{ 1024 * 1024 };
+
+/**
+ * Reads the first bytes of a music file, skipping a leading ID3v2 tag
+ *
+ * @param path The path of the music file
+ * @returns The header of the music file
+ */
+static TagLib::ByteVector readHeader(const std::filesystem::path& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    std::array<char, HEADER_SIZE> buffer;
+    file.read(buffer.data(), buffer.size());
+    TagLib::ByteVector header(buffer.data(), static_cast<unsigned int>(file.gcount()));
+    //MP3 and FLAC files may start with an ID3v2 tag, so sniff the container behind it instead
+    if(header.size() >= 10 && header.startsWith("ID3"))
+    {
+        std::streamoff tagSize{ 10 + ((header[6] & 0x7F) << 21 | (header[7] & 0x7F) << 14 | (header[8] & 0x7F) << 7 | (header[9] & 0x7F)) };
+        if(header[5] & 0x10)
+        {
+            tagSize += 10;
+        }
+        file.clear();
+        file.seekg(tagSize);
+        file.read(buffer.data(), buffer.size());
+        header = TagLib::ByteVector(buffer.data(), static_cast<unsigned int>(file.gcount()));
+    }
+    return header;
+}
+
+/**
+ * Checks whether the first packet of an Ogg stream starts with a codec identification
+ *
+ * @param header The header of the music file
+ * @param codecId The identification of the codec
+ * @returns True if the stream is of the codec, else false
+ */
+static bool sniffOgg(const TagLib::ByteVector& header, const TagLib::ByteVector& codecId)
+{
+    if(header.size() < 28 || !header.startsWith("OggS"))
+    {
+        return false;
+    }
+    unsigned int packetOffset{ 27u + static_cast<unsigned char>(header[26]) };
+    return header.containsAt(codecId, packetOffset);
+}
+
+/**
+ * Opens a music file whose TagLib file type provides its tag through tag()
+ *
+ * @param path The path of the music file
+ * @param readProperties True to read the audio properties, else false
+ * @param readStyle How accurately audio properties are read
+ * @returns The opened music file
+ */
+template<typename T>
+static OpenedMusicFile openFile(const std::filesystem::path& path, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle)
+{
+    T* file{ new T(path.c_str(), readProperties, readStyle) };
+    return { nullptr, std::unique_ptr<TagLib::File>(file), file->tag() };
+}
+
+/**
+ * Opens a music file whose tag is an APE tag
+ *
+ * @param path The path of the music file
+ * @param readProperties True to read the audio properties, else false
+ * @param readStyle How accurately audio properties are read
+ * @returns The opened music file
+ */
+template<typename T>
+static OpenedMusicFile openAPEFile(const std::filesystem::path& path, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle)
+{
+    T* file{ new T(path.c_str(), readProperties, readStyle) };
+    return { nullptr, std::unique_ptr<TagLib::File>(file), file->APETag(true) };
+}
+
+/**
+ * Saves a music file with its default tag types
+ *
+ * @param file The music file
+ * @returns True if saved, else false
+ */
+static bool saveFile(TagLib::File& file)
+{
+    return file.save();
+}
+
+/**
+ * Packs a four character ID3v2 frame id into an integer, so frames can be dispatched with a switch
+ *
+ * @param id The frame id
+ * @returns The packed frame id
+ */
+static constexpr unsigned int frameId(const char* id)
+{
+    return static_cast<unsigned int>(static_cast<unsigned char>(id[0])) << 24 | static_cast<unsigned int>(static_cast<unsigned char>(id[1])) << 16 | static_cast<unsigned int>(static_cast<unsigned char>(id[2])) << 8 | static_cast<unsigned int>(static_cast<unsigned char>(id[3]));
+}
+
+/**
+ * Stores the text of a tag item in the tag field whose key matches in the kind of tag, converting the text for number fields. The first item of a field wins
+ *
+ * @param fields The fields read from the tag
+ * @param keyType The kind of tag, as its member of TagFieldKeys
+ * @param key The key of the item
+ * @param value The text of the item
+ */
+static void readTextField(TagFields& fields, const char* TagFieldKeys::* keyType, const TagLib::String& key, const TagLib::String& value)
+{
+    forEachTagField([&](const auto& field)
+    {
+        const char* fieldKey{ field.keys.*keyType };
+        if(!fieldKey || key != fieldKey)
+        {
+            return;
+        }
+        if constexpr(std::decay_t<decltype(field)>::isNumber)
+        {
+            if(fields.*field.tagField == 0)
+            {
+                fields.*field.tagField = value.toInt();
+            }
+        }
+        else if((fields.*field.tagField).isEmpty())
+        {
+            fields.*field.tagField = value;
+        }
+    });
+}
+
+/**
+ * Parses a track or disc position of the form "number/total", where the total is optional
+ *
+ * @param value The position
+ * @returns The number and the total (0 if not given)
+ */
+static std::pair<unsigned int, unsigned int> parsePosition(const TagLib::String& value)
+{
+    int separator{ value.find("/") };
+    if(separator < 0)
+    {
+        return { value.toInt(), 0 };
+    }
+    return { value.substr(0, separator).toInt(), value.substr(separator + 1).toInt() };
+}
+
+/**
+ * Formats a track or disc position as "number/total", or "number" without a total
+ *
+ * @param number The track or disc number
+ * @param total The total number of tracks or discs
+ * @returns The position
+ */
+static TagLib::String formatPosition(unsigned int number, unsigned int total)
+{
+    TagLib::String position{ TagLib::String::number(number) };
+    if(total > 0)
+    {
+        position += "/" + TagLib::String::number(total);
+    }
+    return position;
+}
+
+/**
+ * Gets the genre of an ID3v2 TCON frame, resolving ID3v1 genre numbers to names
+ *
+ * @param frame The TCON frame
+ * @returns The genre
+ */
+static TagLib::String id3v2Genre(TagLib::ID3v2::Frame* frame)
+{
+    TagLib::ID3v2::TextIdentificationFrame* textFrame{ dynamic_cast<TagLib::ID3v2::TextIdentificationFrame*>(frame) };
+    if(!textFrame)
+    {
+        return frame->toString();
+    }
+    TagLib::StringList genres;
+    for(TagLib::String genre : textFrame->fieldList())
+    {
+        if(genre.isEmpty())
+        {
+            continue;
+        }
+        bool isNumber{ false };
+        int number{ genre.toInt(&isNumber) };
+        if(isNumber && number >= 0 && number <= 255)
+        {
+            genre = TagLib::ID3v1::genre(number);
+        }
+        if(!genres.contains(genre))
+        {
+            genres.append(genre);
+        }
+    }
+    return genres.toString();
+}
+
+static const TagHandler ID3V2_TAG_HANDLER
+{
+    [](TagLib::Tag* tag, TagFields& fields)
+    {
+        bool hasUndescribedComment{ false };
+        for(TagLib::ID3v2::Frame* frame : static_cast<TagLib::ID3v2::Tag*>(tag)->frameList())
+        {
+            switch(frame->frameID().toUInt())
+            {
+            case frameId(YEAR_FIELD.keys.id3v2):
+                if(fields.year == 0)
+                {
+                    fields.year = frame->toString().substr(0, 4).toInt();
+                }
+                break;
+            case frameId(TRACK_FIELD.keys.id3v2):
+                if(fields.track == 0)
+                {
+                    std::pair<unsigned int, unsigned int> position{ parsePosition(frame->toString()) };
+                    fields.track = position.first;
+                    fields.totalTracks = position.second;
+                }
+                break;
+            case frameId(DISC_NUMBER_FIELD.keys.id3v2):
+                if(fields.discNumber == 0)
+                {
+                    std::pair<unsigned int, unsigned int> position{ parsePosition(frame->toString()) };
+                    fields.discNumber = position.first;
+                    fields.totalDiscs = position.second;
+                }
+                break;
+            case frameId(GENRE_FIELD.keys.id3v2):
+                if(fields.genre.isEmpty())
+                {
+                    fields.genre = id3v2Genre(frame);
+                }
+                break;
+            case frameId(COMMENT_FIELD.keys.id3v2):
+            {
+                //Like TagLib, prefer the first comment without a description
+                TagLib::ID3v2::CommentsFrame* commentsFrame{ dynamic_cast<TagLib::ID3v2::CommentsFrame*>(frame) };
+                bool isUndescribed{ commentsFrame && commentsFrame->description().isEmpty() };
+                if(!hasUndescribedComment && (isUndescribed || fields.comment.isEmpty()))
+                {
+                    fields.comment = frame->toString();
+                    hasUndescribedComment = isUndescribed;
+                }
+                break;
+            }
+            case frameId("APIC"):
+                if(fields.albumArt.isEmpty())
+                {
+                    fields.albumArt = static_cast<TagLib::ID3v2::AttachedPictureFrame*>(frame)->picture();
+                }
+                break;
+            case frameId("TXXX"):
+                //User text frames are keyed by their description ("TXXX:description")
+                if(TagLib::ID3v2::UserTextIdentificationFrame* userFrame{ dynamic_cast<TagLib::ID3v2::UserTextIdentificationFrame*>(frame) })
+                {
+                    TagLib::StringList values{ userFrame->fieldList() };
+                    if(!values.isEmpty())
+                    {
+                        values.erase(values.begin());
+                    }
+                    readTextField(fields, &TagFieldKeys::id3v2, "TXXX:" + userFrame->description(), values.toString());
+                }
+                break;
+            case frameId("UFID"):
+                //Unique file identifiers are keyed by their owner ("UFID:owner")
+                if(TagLib::ID3v2::UniqueFileIdentifierFrame* ufidFrame{ dynamic_cast<TagLib::ID3v2::UniqueFileIdentifierFrame*>(frame) })
+                {
+                    readTextField(fields, &TagFieldKeys::id3v2, "UFID:" + ufidFrame->owner(), TagLib::String(ufidFrame->identifier()));
+                }
+                break;
+            default:
+                readTextField(fields, &TagFieldKeys::id3v2, TagLib::String(frame->frameID()), frame->toString());
+                break;
+            }
+        }
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& keys, const TagLib::String& value)
+    {
+        TagLib::ID3v2::Tag* id3v2Tag{ static_cast<TagLib::ID3v2::Tag*>(tag) };
+        std::string_view key{ keys.id3v2 };
+        if(key.starts_with("TXXX:"))
+        {
+            TagLib::String description{ keys.id3v2 + 5, TagLib::String::UTF8 };
+            while(TagLib::ID3v2::UserTextIdentificationFrame* frame{ TagLib::ID3v2::UserTextIdentificationFrame::find(id3v2Tag, description) })
+            {
+                id3v2Tag->removeFrame(frame);
+            }
+            if(!value.isEmpty())
+            {
+                TagLib::ID3v2::UserTextIdentificationFrame* frame{ new TagLib::ID3v2::UserTextIdentificationFrame(TagLib::String::UTF8) };
+                frame->setDescription(description);
+                frame->setText(value);
+                id3v2Tag->addFrame(frame);
+            }
+        }
+        else if(key.starts_with("UFID:"))
+        {
+            TagLib::String owner{ keys.id3v2 + 5, TagLib::String::UTF8 };
+            while(TagLib::ID3v2::UniqueFileIdentifierFrame* frame{ TagLib::ID3v2::UniqueFileIdentifierFrame::findByOwner(id3v2Tag, owner) })
+            {
+                id3v2Tag->removeFrame(frame);
+            }
+            if(!value.isEmpty())
+            {
+                id3v2Tag->addFrame(new TagLib::ID3v2::UniqueFileIdentifierFrame(owner, value.data(TagLib::String::UTF8)));
+            }
+        }
+        else if(key == "USLT")
+        {
+            id3v2Tag->removeFrames(keys.id3v2);
+            if(!value.isEmpty())
+            {
+                TagLib::ID3v2::UnsynchronizedLyricsFrame* frame{ new TagLib::ID3v2::UnsynchronizedLyricsFrame(TagLib::String::UTF8) };
+                frame->setText(value);
+                id3v2Tag->addFrame(frame);
+            }
+        }
+        else
+        {
+            id3v2Tag->removeFrames(keys.id3v2);
+            if(!value.isEmpty())
+            {
+                TagLib::ID3v2::TextIdentificationFrame* frame{ new TagLib::ID3v2::TextIdentificationFrame(keys.id3v2, TagLib::String::UTF8) };
+                frame->setText(value);
+                id3v2Tag->addFrame(frame);
+            }
+        }
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& numberKeys, const TagFieldKeys&, unsigned int number, unsigned int total)
+    {
+        //The total is stored in the frame of the number ("3/12")
+        TagLib::ID3v2::Tag* id3v2Tag{ static_cast<TagLib::ID3v2::Tag*>(tag) };
+        id3v2Tag->removeFrames(numberKeys.id3v2);
+        if(number > 0 || total > 0)
+        {
+            TagLib::ID3v2::TextIdentificationFrame* frame{ new TagLib::ID3v2::TextIdentificationFrame(numberKeys.id3v2, TagLib::String::UTF8) };
+            frame->setText(formatPosition(number, total));
+            id3v2Tag->addFrame(frame);
+        }
+    },
+    [](TagLib::Tag* tag) -> TagLib::ByteVector
+    {
+        const TagLib::ID3v2::FrameList& frames{ static_cast<TagLib::ID3v2::Tag*>(tag)->frameList("APIC") };
+        return frames.isEmpty() ? TagLib::ByteVector() : static_cast<TagLib::ID3v2::AttachedPictureFrame*>(frames.front())->picture();
+    },
+    [](TagLib::Tag* tag, const TagLib::ByteVector& albumArt)
+    {
+        TagLib::ID3v2::Tag* id3v2Tag{ static_cast<TagLib::ID3v2::Tag*>(tag) };
+        id3v2Tag->removeFrames("APIC");
+        if(!albumArt.isEmpty())
+        {
+            TagLib::ID3v2::AttachedPictureFrame* frame{ new TagLib::ID3v2::AttachedPictureFrame() };
+            frame->setType(TagLib::ID3v2::AttachedPictureFrame::Type::FrontCover);
+            frame->setPicture(albumArt);
+            id3v2Tag->addFrame(frame);
+        }
+    },
+    [](TagLib::File& file, TagLib::Tag* tag, unsigned int padding)
+    {
+        //TagLib sizes the padding of a tag from the size in its header, reusing the old padding when the tag fits and falling back to 1KB when it grows
+        TagLib::ID3v2::Tag* id3v2Tag{ static_cast<TagLib::ID3v2::Tag*>(tag) };
+        TagLib::ID3v2::Header* header{ id3v2Tag->header() };
+        unsigned int originalSize{ header->tagSize() };
+        if(originalSize == 0 || header->footerPresent())
+        {
+            return;
+        }
+        unsigned int renderedSize{ id3v2Tag->render().size() - TagLib::ID3v2::Header::size() };
+        if(renderedSize <= originalSize)
+        {
+            return;
+        }
+        //Padding above 1% of the file size (and 1MB) is dropped by TagLib, so it is capped to what will be kept
+        unsigned int contentSize{ renderedSize - ID3V2_MIN_PADDING };
+        unsigned int maxPadding{ std::min(std::max(static_cast<unsigned int>(file.length() / 100), ID3V2_MIN_PADDING), ID3V2_MAX_PADDING) };
+        padding = std::max(padding, ID3V2_MIN_PADDING);
+        //Growing the tag by whole blocks lets a rewrite share the extents of the audio with the old file
+        unsigned int alignedPadding{ padding + static_cast<unsigned int>((FileHelpers::CLONE_BLOCK_SIZE - (contentSize + padding - originalSize) % FileHelpers::CLONE_BLOCK_SIZE) % FileHelpers::CLONE_BLOCK_SIZE) };
+        header->setTagSize(contentSize + std::min(alignedPadding <= maxPadding ? alignedPadding : padding, maxPadding));
+    }
+};
+
+static const TagHandler MP4_TAG_HANDLER
+{
+    [](TagLib::Tag* tag, TagFields& fields)
+    {
+        for(const std::pair<const TagLib::String, TagLib::MP4::Item>& pair : static_cast<TagLib::MP4::Tag*>(tag)->itemMap())
+        {
+            if(pair.first == YEAR_FIELD.keys.mp4)
+            {
+                fields.year = pair.second.toStringList().toString().toInt();
+            }
+            else if(pair.first == TRACK_FIELD.keys.mp4)
+            {
+                fields.track = pair.second.toIntPair().first;
+                fields.totalTracks = pair.second.toIntPair().second;
+            }
+            else if(pair.first == DISC_NUMBER_FIELD.keys.mp4)
+            {
+                fields.discNumber = pair.second.toIntPair().first;
+                fields.totalDiscs = pair.second.toIntPair().second;
+            }
+            else if(pair.first == BPM_FIELD.keys.mp4)
+            {
+                fields.bpm = pair.second.toInt();
+            }
+            else if(pair.first == "covr")
+            {
+                TagLib::MP4::CoverArtList coverArtList{ pair.second.toCoverArtList() };
+                fields.albumArt = coverArtList.isEmpty() ? TagLib::ByteVector() : coverArtList.front().data();
+            }
+            else
+            {
+                readTextField(fields, &TagFieldKeys::mp4, pair.first, pair.second.toStringList().toString(", "));
+            }
+        }
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& keys, const TagLib::String& value)
+    {
+        TagLib::MP4::Tag* mp4Tag{ static_cast<TagLib::MP4::Tag*>(tag) };
+        mp4Tag->removeItem(keys.mp4);
+        if(value.isEmpty())
+        {
+            return;
+        }
+        //The tempo is the only integer item written as text
+        if(std::string_view(keys.mp4) == BPM_FIELD.keys.mp4)
+        {
+            mp4Tag->setItem(keys.mp4, { value.toInt() });
+        }
+        else
+        {
+            mp4Tag->setItem(keys.mp4, { TagLib::StringList(value) });
+        }
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& numberKeys, const TagFieldKeys&, unsigned int number, unsigned int total)
+    {
+        TagLib::MP4::Tag* mp4Tag{ static_cast<TagLib::MP4::Tag*>(tag) };
+        mp4Tag->removeItem(numberKeys.mp4);
+        if(number > 0 || total > 0)
+        {
+            mp4Tag->setItem(numberKeys.mp4, { static_cast<int>(number), static_cast<int>(total) });
+        }
+    },
+    [](TagLib::Tag* tag) -> TagLib::ByteVector
+    {
+        TagLib::MP4::Item item{ static_cast<TagLib::MP4::Tag*>(tag)->item("covr") };
+        return item.isValid() && !item.toCoverArtList().isEmpty() ? item.toCoverArtList().front().data() : TagLib::ByteVector();
+    },
+    [](TagLib::Tag* tag, const TagLib::ByteVector& albumArt)
+    {
+        TagLib::MP4::Tag* mp4Tag{ static_cast<TagLib::MP4::Tag*>(tag) };
+        mp4Tag->removeItem("covr");
+        if(!albumArt.isEmpty())
+        {
+            TagLib::MP4::CoverArtList coverArtList;
+            coverArtList.append({ TagLib::MP4::CoverArt::Format::Unknown, albumArt });
+            mp4Tag->setItem("covr", { coverArtList });
+        }
+    },
+    nullptr
+};
+
+static const TagHandler XIPH_COMMENT_TAG_HANDLER
+{
+    [](TagLib::Tag* tag, TagFields& fields)
+    {
+        TagLib::Ogg::XiphComment* xiphComment{ static_cast<TagLib::Ogg::XiphComment*>(tag) };
+        //Fields with a fallback name are resolved after the walk, as the map gives no order guarantee between them
+        TagLib::String date;
+        TagLib::String year;
+        TagLib::String trackNumber;
+        TagLib::String track;
+        TagLib::String totalTracks;
+        TagLib::String discNumber;
+        TagLib::String totalDiscs;
+        TagLib::String comment;
+        for(const std::pair<const TagLib::String, TagLib::StringList>& pair : xiphComment->fieldListMap())
+        {
+            if(pair.second.isEmpty())
+            {
+                continue;
+            }
+            if(pair.first == YEAR_FIELD.keys.xiphComment)
+            {
+                date = pair.second.front();
+            }
+            else if(pair.first == "YEAR")
+            {
+                year = pair.second.front();
+            }
+            else if(pair.first == TRACK_FIELD.keys.xiphComment)
+            {
+                trackNumber = pair.second.front();
+            }
+            else if(pair.first == "TRACKNUM")
+            {
+                track = pair.second.front();
+            }
+            else if(pair.first == "TOTALTRACKS")
+            {
+                totalTracks = pair.second.front();
+            }
+            else if(pair.first == DISC_NUMBER_FIELD.keys.xiphComment)
+            {
+                discNumber = pair.second.front();
+            }
+            else if(pair.first == "TOTALDISCS")
+            {
+                totalDiscs = pair.second.front();
+            }
+            else if(pair.first == "COMMENT")
+            {
+                comment = pair.second.toString(" / ");
+            }
+            else
+            {
+                readTextField(fields, &TagFieldKeys::xiphComment, pair.first, pair.second.toString(" / "));
+            }
+        }
+        fields.year = (!date.isEmpty() ? date : year).toInt();
+        //Numbers may also carry their total ("3/12"), which is used when there is no total field
+        std::pair<unsigned int, unsigned int> trackPosition{ parsePosition(!trackNumber.isEmpty() ? trackNumber : track) };
+        fields.track = trackPosition.first;
+        if(fields.totalTracks == 0)
+        {
+            fields.totalTracks = trackPosition.second > 0 ? trackPosition.second : totalTracks.toInt();
+        }
+        std::pair<unsigned int, unsigned int> discPosition{ parsePosition(discNumber) };
+        fields.discNumber = discPosition.first;
+        if(fields.totalDiscs == 0)
+        {
+            fields.totalDiscs = discPosition.second > 0 ? discPosition.second : totalDiscs.toInt();
+        }
+        if(fields.comment.isEmpty())
+        {
+            fields.comment = comment;
+        }
+        const TagLib::List<TagLib::FLAC::Picture*>& pictures{ xiphComment->pictureList() };
+        fields.albumArt = pictures.isEmpty() ? TagLib::ByteVector() : pictures.front()->data();
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& keys, const TagLib::String& value)
+    {
+        static_cast<TagLib::Ogg::XiphComment*>(tag)->addField(keys.xiphComment, value);
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& numberKeys, const TagFieldKeys& totalKeys, unsigned int number, unsigned int total)
+    {
+        TagLib::Ogg::XiphComment* xiphComment{ static_cast<TagLib::Ogg::XiphComment*>(tag) };
+        xiphComment->addField(numberKeys.xiphComment, tagFieldToText(number));
+        xiphComment->addField(totalKeys.xiphComment, tagFieldToText(total));
+    },
+    [](TagLib::Tag* tag) -> TagLib::ByteVector
+    {
+        const TagLib::List<TagLib::FLAC::Picture*>& pictures{ static_cast<TagLib::Ogg::XiphComment*>(tag)->pictureList() };
+        return pictures.isEmpty() ? TagLib::ByteVector() : pictures.front()->data();
+    },
+    [](TagLib::Tag* tag, const TagLib::ByteVector& albumArt)
+    {
+        TagLib::Ogg::XiphComment* xiphComment{ static_cast<TagLib::Ogg::XiphComment*>(tag) };
+        xiphComment->removeAllPictures();
+        if(!albumArt.isEmpty())
+        {
+            TagLib::FLAC::Picture* picture{ new TagLib::FLAC::Picture() };
+            picture->setType(TagLib::FLAC::Picture::Type::FrontCover);
+            picture->setData(albumArt);
+            xiphComment->addPicture(picture);
+        }
+    },
+    nullptr
+};
+
+static const TagHandler ASF_TAG_HANDLER
+{
+    [](TagLib::Tag* tag, TagFields& fields)
+    {
+        TagLib::ASF::Tag* asfTag{ static_cast<TagLib::ASF::Tag*>(tag) };
+        //Title, artist and comment live in the content description object rather than in attributes
+        fields.title = asfTag->title();
+        fields.artist = asfTag->artist();
+        fields.comment = asfTag->comment();
+        bool hasTrackNumber{ false };
+        for(const std::pair<const TagLib::String, TagLib::ASF::AttributeList>& pair : asfTag->attributeListMap())
+        {
+            if(pair.second.isEmpty())
+            {
+                continue;
+            }
+            const TagLib::ASF::Attribute& attribute{ pair.second.front() };
+            if(pair.first == YEAR_FIELD.keys.asf)
+            {
+                fields.year = attribute.toString().toInt();
+            }
+            else if(pair.first == TRACK_FIELD.keys.asf)
+            {
+                fields.track = attribute.type() == TagLib::ASF::Attribute::DWordType ? attribute.toUInt() : attribute.toString().toInt();
+                hasTrackNumber = true;
+            }
+            else if(pair.first == "WM/Track" && !hasTrackNumber)
+            {
+                fields.track = attribute.toUInt() + 1;
+            }
+            else if(pair.first == DISC_NUMBER_FIELD.keys.asf)
+            {
+                std::pair<unsigned int, unsigned int> position{ parsePosition(attribute.toString()) };
+                fields.discNumber = position.first;
+                fields.totalDiscs = position.second;
+            }
+            else if(pair.first == "WM/Picture")
+            {
+                fields.albumArt = attribute.toPicture().picture();
+            }
+            else
+            {
+                readTextField(fields, &TagFieldKeys::asf, pair.first, attribute.toString());
+            }
+        }
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& keys, const TagLib::String& value)
+    {
+        if(!keys.asf)
+        {
+            return;
+        }
+        TagLib::ASF::Tag* asfTag{ static_cast<TagLib::ASF::Tag*>(tag) };
+        asfTag->removeItem(keys.asf);
+        if(!value.isEmpty())
+        {
+            asfTag->addAttribute(keys.asf, { value });
+        }
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& numberKeys, const TagFieldKeys&, unsigned int number, unsigned int total)
+    {
+        //WM/TrackNumber holds only the number (as TagLib writes it), and there is no track total attribute. WM/PartOfSet holds the disc position as text
+        TagLib::ASF::Tag* asfTag{ static_cast<TagLib::ASF::Tag*>(tag) };
+        asfTag->removeItem(numberKeys.asf);
+        if(std::string_view(numberKeys.asf) == TRACK_FIELD.keys.asf)
+        {
+            if(number > 0)
+            {
+                asfTag->addAttribute(numberKeys.asf, { number });
+            }
+        }
+        else if(number > 0 || total > 0)
+        {
+            asfTag->addAttribute(numberKeys.asf, { formatPosition(number, total) });
+        }
+    },
+    [](TagLib::Tag* tag) -> TagLib::ByteVector
+    {
+        const TagLib::ASF::AttributeListMap& attributes{ static_cast<TagLib::ASF::Tag*>(tag)->attributeListMap() };
+        return attributes.contains("WM/Picture") && !attributes["WM/Picture"].isEmpty() ? attributes["WM/Picture"].front().toPicture().picture() : TagLib::ByteVector();
+    },
+    [](TagLib::Tag* tag, const TagLib::ByteVector& albumArt)
+    {
+        TagLib::ASF::Tag* asfTag{ static_cast<TagLib::ASF::Tag*>(tag) };
+        asfTag->removeItem("WM/Picture");
+        if(!albumArt.isEmpty())
+        {
+            TagLib::ASF::Picture picture;
+            picture.setType(TagLib::ASF::Picture::Type::FrontCover);
+            picture.setPicture(albumArt);
+            asfTag->addAttribute("WM/Picture", { picture });
+        }
+    },
+    nullptr
+};
+
+/**
+ * Gets the image of an APE cover art item
+ *
+ * @param item The cover art item
+ * @returns The image
+ */
+static TagLib::ByteVector apeCoverArt(const TagLib::APE::Item& item)
+{
+    //APE cover art items hold a null terminated description followed by the image
+    TagLib::ByteVector data{ item.binaryData() };
+    int descriptionEnd{ data.find(TagLib::ByteVector('\0')) };
+    return descriptionEnd < 0 ? TagLib::ByteVector() : data.mid(descriptionEnd + 1);
+}
+
+static const TagHandler APE_TAG_HANDLER
+{
+    [](TagLib::Tag* tag, TagFields& fields)
+    {
+        for(const std::pair<const TagLib::String, TagLib::APE::Item>& pair : static_cast<TagLib::APE::Tag*>(tag)->itemListMap())
+        {
+            if(pair.first == YEAR_FIELD.keys.ape)
+            {
+                fields.year = pair.second.toString().toInt();
+            }
+            else if(pair.first == TRACK_FIELD.keys.ape)
+            {
+                std::pair<unsigned int, unsigned int> position{ parsePosition(pair.second.toString()) };
+                fields.track = position.first;
+                fields.totalTracks = position.second;
+            }
+            else if(pair.first == DISC_NUMBER_FIELD.keys.ape)
+            {
+                std::pair<unsigned int, unsigned int> position{ parsePosition(pair.second.toString()) };
+                fields.discNumber = position.first;
+                fields.totalDiscs = position.second;
+            }
+            else if(pair.first == "COVER ART (FRONT)")
+            {
+                fields.albumArt = apeCoverArt(pair.second);
+            }
+            else
+            {
+                readTextField(fields, &TagFieldKeys::ape, pair.first, pair.second.values().toString());
+            }
+        }
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& keys, const TagLib::String& value)
+    {
+        static_cast<TagLib::APE::Tag*>(tag)->addValue(keys.ape, value);
+    },
+    [](TagLib::Tag* tag, const TagFieldKeys& numberKeys, const TagFieldKeys&, unsigned int number, unsigned int total)
+    {
+        //The total is stored in the item of the number ("3/12")
+        TagLib::APE::Tag* apeTag{ static_cast<TagLib::APE::Tag*>(tag) };
+        if(number > 0 || total > 0)
+        {
+            apeTag->addValue(numberKeys.ape, formatPosition(number, total));
+        }
+        else
+        {
+            apeTag->removeItem(numberKeys.ape);
+        }
+    },
+    [](TagLib::Tag* tag) -> TagLib::ByteVector
+    {
+        const TagLib::APE::ItemListMap& items{ static_cast<TagLib::APE::Tag*>(tag)->itemListMap() };
+        return items.contains("COVER ART (FRONT)") ? apeCoverArt(items["COVER ART (FRONT)"]) : TagLib::ByteVector();
+    },
+    [](TagLib::Tag* tag, const TagLib::ByteVector& albumArt)
+    {
+        TagLib::APE::Tag* apeTag{ static_cast<TagLib::APE::Tag*>(tag) };
+        apeTag->removeItem("COVER ART (FRONT)");
+        if(!albumArt.isEmpty())
+        {
+            TagLib::ByteVector data{ "Cover Art (Front)", 18 };
+            data.append(albumArt);
+            apeTag->setData("COVER ART (FRONT)", data);
+        }
+    },
+    nullptr
+};
+
+/**
+ * Renders the ID3v2 tag at the start of an MP3 file
+ *
+ * @param file The MP3 file
+ * @param tag The ID3v2 tag of the file
+ * @param paddingSize The padding to reserve if the tag grew
+ * @returns The rendered tag, or std::nullopt if the file is left to TagLib
+ */
+static std::optional<RenderedHeader> renderMP3Header(TagLib::File& file, TagLib::Tag* tag, unsigned int paddingSize)
+{
+    TagLib::MPEG::File& mpegFile{ static_cast<TagLib::MPEG::File&>(file) };
+    TagLib::ID3v2::Tag* id3v2Tag{ static_cast<TagLib::ID3v2::Tag*>(tag) };
+    //TagLib strips ID3v1 and APE tags and removes an empty ID3v2 tag when saving, so those files are still saved by TagLib
+    if(mpegFile.hasID3v1Tag() || mpegFile.hasAPETag() || id3v2Tag->isEmpty())
+    {
+        return std::nullopt;
+    }
+    RenderedHeader header;
+    if(mpegFile.hasID3v2Tag())
+    {
+        file.seek(0);
+        if(file.readBlock(3) != TagLib::ByteVector("ID3", 3))
+        {
+            return std::nullopt;
+        }
+        header.replacedSize = id3v2Tag->header()->completeTagSize();
+    }
+    ID3V2_TAG_HANDLER.reservePadding(file, tag, paddingSize);
+    header.data = id3v2Tag->render();
+    return header;
+}
+
+/**
+ * Appends the header of a FLAC metadata block. The block is not marked as the last one, which is done once all blocks are known
+ *
+ * @param data The data to append to
+ * @param type The type of the block
+ * @param length The length of the block (without its header)
+ */
+static void appendFLACBlockHeader(TagLib::ByteVector& data, unsigned char type, unsigned int length)
+{
+    TagLib::ByteVector blockHeader{ TagLib::ByteVector::fromUInt(length) };
+    blockHeader[0] = static_cast<char>(type);
+    data.append(blockHeader);
+}
+
+/**
+ * Renders the metadata blocks at the start of a FLAC file, replacing its Vorbis comment and padding. The other blocks (stream info, seek table, pictures, etc.) are kept as they are
+ *
+ * @param file The FLAC file
+ * @param tag The Xiph comment of the file
+ * @param paddingSize The padding to reserve if the metadata grew
+ * @returns The rendered metadata, or std::nullopt if the file is left to TagLib
+ */
+static std::optional<RenderedHeader> renderFLACHeader(TagLib::File& file, TagLib::Tag* tag, unsigned int paddingSize)
+{
+    static const unsigned int MAX_BLOCK_LENGTH{ (1u << 24) - 1 };
+    static const unsigned char PADDING_BLOCK{ 1 };
+    static const unsigned char VORBIS_COMMENT_BLOCK{ 4 };
+    static const unsigned char INVALID_BLOCK{ 127 };
+    file.seek(0);
+    RenderedHeader header;
+    header.data = file.readBlock(4);
+    //Files with an ID3v2 tag in front of the FLAC stream are left to TagLib
+    if(header.data != TagLib::ByteVector("fLaC", 4))
+    {
+        return std::nullopt;
+    }
+    std::uintmax_t position{ 4 };
+    std::size_t lastBlockOffset{ 0 };
+    bool isLast{ false };
+    while(!isLast)
+    {
+        file.seek(static_cast<long>(position));
+        TagLib::ByteVector blockHeader{ file.readBlock(4) };
+        if(blockHeader.size() != 4)
+        {
+            return std::nullopt;
+        }
+        isLast = static_cast<unsigned char>(blockHeader[0]) & 0x80;
+        unsigned char type{ static_cast<unsigned char>(blockHeader[0] & 0x7F) };
+        unsigned int length{ (static_cast<unsigned int>(static_cast<unsigned char>(blockHeader[1])) << 16) | (static_cast<unsigned int>(static_cast<unsigned char>(blockHeader[2])) << 8) | static_cast<unsigned char>(blockHeader[3]) };
+        if(type == INVALID_BLOCK)
+        {
+            return std::nullopt;
+        }
+        if(type != PADDING_BLOCK && type != VORBIS_COMMENT_BLOCK)
+        {
+            file.seek(static_cast<long>(position));
+            TagLib::ByteVector block{ file.readBlock(4 + length) };
+            if(block.size() != 4 + length)
+            {
+                return std::nullopt;
+            }
+            lastBlockOffset = header.data.size();
+            header.data.append(block);
+            header.data[lastBlockOffset] = static_cast<char>(type);
+        }
+        position += 4 + length;
+    }
+    TagLib::ByteVector comment{ static_cast<TagLib::Ogg::XiphComment*>(tag)->render(false) };
+    if(comment.size() > MAX_BLOCK_LENGTH)
+    {
+        return std::nullopt;
+    }
+    lastBlockOffset = header.data.size();
+    appendFLACBlockHeader(header.data, VORBIS_COMMENT_BLOCK, comment.size());
+    header.data.append(comment);
+    header.replacedSize = position;
+    //Reuse the space of the old metadata if the new metadata fits, else reserve padding so later saves do
+    if(header.data.size() != header.replacedSize)
+    {
+        std::uintmax_t padding{ paddingSize };
+        if(header.data.size() + 4 <= header.replacedSize)
+        {
+            padding = header.replacedSize - header.data.size() - 4;
+        }
+        else
+        {
+            //Growing the metadata by whole blocks lets a rewrite share the extents of the audio with the old file
+            padding += (FileHelpers::CLONE_BLOCK_SIZE - (header.data.size() + 4 + padding - header.replacedSize) % FileHelpers::CLONE_BLOCK_SIZE) % FileHelpers::CLONE_BLOCK_SIZE;
+            padding = std::min<std::uintmax_t>(padding, MAX_BLOCK_LENGTH);
+        }
+        lastBlockOffset = header.data.size();
+        appendFLACBlockHeader(header.data, PADDING_BLOCK, static_cast<unsigned int>(padding));
+        header.data.append(TagLib::ByteVector(static_cast<unsigned int>(padding), 0));
+    }
+    header.data[lastBlockOffset] = static_cast<char>(header.data[lastBlockOffset] | 0x80);
+    return header;
+}
+
+const MusicFormatRegistry& MusicFormatRegistry::getInstance()
+{
+    static MusicFormatRegistry instance;
+    return instance;
+}
+
+MusicFormatRegistry::MusicFormatRegistry()
+{
+    //Adding a format only takes a row here, plus a TagHandler if it uses a new kind of tag
+    m_formats = {
+        { "MP3", { ".mp3" }, &ID3V2_TAG_HANDLER, TagPlacement::Start, [](const TagLib::ByteVector& header)
+        {
+            return header.size() >= 2 && static_cast<unsigned char>(header[0]) == 0xFF && (static_cast<unsigned char>(header[1]) & 0xE0) == 0xE0 && (header[1] & 0x06) != 0;
+        }, [](const std::filesystem::path& path, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle) -> OpenedMusicFile
+        {
+            TagLib::MPEG::File* file{ new TagLib::MPEG::File(path.c_str(), readProperties, readStyle) };
+            return { nullptr, std::unique_ptr<TagLib::File>(file), file->ID3v2Tag(true) };
+        }, [](TagLib::File& file)
+        {
+            return static_cast<TagLib::MPEG::File&>(file).save(TagLib::MPEG::File::TagTypes::ID3v2);
+        }, &renderMP3Header },
+        { "MP4", { ".m4a" }, &MP4_TAG_HANDLER, TagPlacement::Start, [](const TagLib::ByteVector& header)
+        {
+            return header.containsAt("ftyp", 4);
+        }, &openFile<TagLib::MP4::File>, &saveFile, nullptr },
+        { "Ogg Vorbis", { ".ogg" }, &XIPH_COMMENT_TAG_HANDLER, TagPlacement::Start, [](const TagLib::ByteVector& header)
+        {
+            return sniffOgg(header, TagLib::ByteVector("\x01vorbis", 7));
+        }, &openFile<TagLib::Ogg::Vorbis::File>, &saveFile, nullptr },
+        { "Ogg Opus", { ".opus" }, &XIPH_COMMENT_TAG_HANDLER, TagPlacement::Start, [](const TagLib::ByteVector& header)
+        {
+            return sniffOgg(header, "OpusHead");
+        }, &openFile<TagLib::Ogg::Opus::File>, &saveFile, nullptr },
+        { "Ogg FLAC", { ".oga" }, &XIPH_COMMENT_TAG_HANDLER, TagPlacement::Start, [](const TagLib::ByteVector& header)
+        {
+            return sniffOgg(header, TagLib::ByteVector("\x7F" "FLAC", 5));
+        }, &openFile<TagLib::Ogg::FLAC::File>, &saveFile, nullptr },
+        { "FLAC", { ".flac" }, &XIPH_COMMENT_TAG_HANDLER, TagPlacement::Start, [](const TagLib::ByteVector& header)
+        {
+            return header.startsWith("fLaC");
+        }, [](const std::filesystem::path& path, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle) -> OpenedMusicFile
+        {
+            TagLib::FLAC::File* file{ new TagLib::FLAC::File(path.c_str(), readProperties, readStyle) };
+            return { nullptr, std::unique_ptr<TagLib::File>(file), file->xiphComment(true) };
+        }, &saveFile, &renderFLACHeader },
+        { "WMA", { ".wma" }, &ASF_TAG_HANDLER, TagPlacement::Start, [](const TagLib::ByteVector& header)
+        {
+            return header.startsWith(TagLib::ByteVector("\x30\x26\xB2\x75\x8E\x66\xCF\x11\xA6\xD9\x00\xAA\x00\x62\xCE\x6C", 16));
+        }, &openFile<TagLib::ASF::File>, &saveFile, nullptr },
+        { "WAV", { ".wav" }, &ID3V2_TAG_HANDLER, TagPlacement::End, [](const TagLib::ByteVector& header)
+        {
+            return header.startsWith("RIFF") && header.containsAt("WAVE", 8);
+        }, [](const std::filesystem::path& path, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle) -> OpenedMusicFile
+        {
+            TagLib::RIFF::WAV::File* file{ new TagLib::RIFF::WAV::File(path.c_str(), readProperties, readStyle) };
+            return { nullptr, std::unique_ptr<TagLib::File>(file), file->ID3v2Tag() };
+        }, [](TagLib::File& file)
+        {
+            return static_cast<TagLib::RIFF::WAV::File&>(file).save(TagLib::RIFF::WAV::File::TagTypes::ID3v2);
+        }, nullptr },
+        { "AIFF", { ".aiff", ".aif" }, &ID3V2_TAG_HANDLER, TagPlacement::End, [](const TagLib::ByteVector& header)
+        {
+            return header.startsWith("FORM") && (header.containsAt("AIFF", 8) || header.containsAt("AIFC", 8));
+        }, &openFile<TagLib::RIFF::AIFF::File>, &saveFile, nullptr },
+        { "WavPack", { ".wv" }, &APE_TAG_HANDLER, TagPlacement::End, [](const TagLib::ByteVector& header)
+        {
+            return header.startsWith("wvpk");
+        }, &openAPEFile<TagLib::WavPack::File>, &saveFile, nullptr },
+        { "Monkey's Audio", { ".ape" }, &APE_TAG_HANDLER, TagPlacement::End, [](const TagLib::ByteVector& header)
+        {
+            return header.startsWith("MAC ");
+        }, &openAPEFile<TagLib::APE::File>, &saveFile, nullptr },
+        { "Musepack", { ".mpc" }, &APE_TAG_HANDLER, TagPlacement::End, [](const TagLib::ByteVector& header)
+        {
+            return header.startsWith("MPCK") || header.startsWith("MP+");
+        }, &openAPEFile<TagLib::MPC::File>, &saveFile, nullptr }
+    };
+    for(std::size_t i = 0; i < m_formats.size(); i++)
+    {
+        for(const std::string& dotExtension : m_formats[i].dotExtensions)
+        {
+            m_formatIndexes.insert({ dotExtension, i });
+        }
+    }
+}
+
+bool MusicFormatRegistry::isSupported(const std::filesystem::path& path) const
+{
+    return m_formatIndexes.contains(path.extension().string());
+}
+
+const MusicFormat* MusicFormatRegistry::getFormat(const std::filesystem::path& path) const
+{
+    std::unordered_map<std::string, std::size_t>::const_iterator it{ m_formatIndexes.find(path.extension().string()) };
+    if(it == m_formatIndexes.end())
+    {
+        return nullptr;
+    }
+    const MusicFormat* extensionFormat{ &m_formats[it->second] };
+    TagLib::ByteVector header{ readHeader(path) };
+    //Check the format of the extension first, as files are rarely mislabeled
+    if(extensionFormat->sniff(header))
+    {
+        return extensionFormat;
+    }
+    for(const MusicFormat& format : m_formats)
+    {
+        if(&format != extensionFormat && format.sniff(header))
+        {
+            return &format;
+        }
+    }
+    //Formats without a reliable signature (e.g. MP3 with junk before the first frame) are still opened by extension
+    return extensionFormat;
+}
+
+OpenedMusicFile MusicFormatRegistry::open(const std::filesystem::path& path, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle) const
+{
+    const MusicFormat* format{ getFormat(path) };
+    if(!format)
+    {
+        throw std::invalid_argument("Invalid Path. The path is not a valid music file.");
+    }
+    return open(path, *format, readProperties, readStyle);
+}
+
+OpenedMusicFile MusicFormatRegistry::open(const std::filesystem::path& path, const MusicFormat& format, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle) const
+{
+    OpenedMusicFile openedFile{ format.open(path, readProperties, readStyle) };
+    if(!openedFile.file->isValid() || !openedFile.tag)
+    {
+        throw std::invalid_argument("Invalid music file. The file could not be read as " + format.name + ".");
+    }
+    openedFile.format = &format;
+    return openedFile;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <taglib/audioproperties.h>
+#include <taglib/tag.h>
+#include <taglib/tbytevector.h>
+#include <taglib/tfile.h>
+#include <taglib/tstring.h>
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * The fields of a tag, as read in a single pass over the tag
+     */
+    struct TagFields
+    {
+    	TagLib::String title;
+    	TagLib::String artist;
+    	TagLib::String album;
+    	unsigned int year{ 0 };
+    	unsigned int track{ 0 };
+    	TagLib::String albumArtist;
+    	TagLib::String genre;
+    	TagLib::String comment;
+    	unsigned int discNumber{ 0 };
+    	unsigned int totalTracks{ 0 };
+    	unsigned int totalDiscs{ 0 };
+    	TagLib::String composer;
+    	unsigned int bpm{ 0 };
+    	TagLib::String isrc;
+    	TagLib::String musicBrainzRecordingId;
+    	TagLib::String musicBrainzReleaseId;
+    	TagLib::String lyrics;
+    	TagLib::ByteVector albumArt;
+    };
+
+    /**
+     * The keys a tag field is stored under in each kind of tag (nullptr where the kind of tag holds the field outside of its keyed frames/fields)
+     */
+    struct TagFieldKeys
+    {
+    	const char* id3v2;
+    	const char* mp4;
+    	const char* xiphComment;
+    	const char* asf;
+    	const char* ape;
+    };
+
+    /**
+     * Functions to read and write a kind of tag. Reading walks the frames/fields of the tag once, and writing covers the fields that are not part of TagLib::Tag
+     *
+     * reservePadding makes the next save reserve padding when the tag outgrew the space it has in the file. It is nullptr for kinds of tag whose padding TagLib sizes on its own
+     */
+    struct TagHandler
+    {
+    	void (*read)(TagLib::Tag* tag, TagFields& fields);
+    	void (*setText)(TagLib::Tag* tag, const TagFieldKeys& keys, const TagLib::String& value);
+    	void (*setPosition)(TagLib::Tag* tag, const TagFieldKeys& numberKeys, const TagFieldKeys& totalKeys, unsigned int number, unsigned int total);
+    	TagLib::ByteVector (*getAlbumArt)(TagLib::Tag* tag);
+    	void (*setAlbumArt)(TagLib::Tag* tag, const TagLib::ByteVector& albumArt);
+    	void (*reservePadding)(TagLib::File& file, TagLib::Tag* tag, unsigned int padding);
+    };
+
+    /**
+     * Where a format keeps its tag in the file. A tag at the start that grows past its padding moves the audio data after it, so the whole file is rewritten, while a tag at the end is only extended
+     */
+    enum class TagPlacement
+    {
+    	Start = 0,
+    	End
+    };
+
+    /**
+     * The start of a music file as rendered for a save: the tag (and whatever precedes the audio) and the size of the old start it replaces
+     */
+    struct RenderedHeader
+    {
+    	TagLib::ByteVector data;
+    	std::uintmax_t replacedSize{ 0 };
+    };
+
+    struct MusicFormat;
+
+    /**
+     * A music file opened through its MusicFormat
+     */
+    struct OpenedMusicFile
+    {
+    	const MusicFormat* format{ nullptr };
+    	std::unique_ptr<TagLib::File> file;
+    	TagLib::Tag* tag{ nullptr };
+    };
+
+    /**
+     * A description of a supported music format
+     *
+     * renderHeader renders the start of a file with its edited tag (reserving paddingSize bytes of padding if the tag grew), so a tag that fits can be written in place and one that grew can be written to a new file with the audio copied by the kernel. It is nullptr for formats whose tag is saved by TagLib alone, and returns std::nullopt for files it cannot render
+     */
+    struct MusicFormat
+    {
+    	std::string name;
+    	std::vector<std::string> dotExtensions;
+    	const TagHandler* tagHandler;
+    	TagPlacement tagPlacement;
+    	bool (*sniff)(const TagLib::ByteVector& header);
+    	OpenedMusicFile (*open)(const std::filesystem::path& path, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle);
+    	bool (*save)(TagLib::File& file);
+    	std::optional<RenderedHeader> (*renderHeader)(TagLib::File& file, TagLib::Tag* tag, unsigned int paddingSize);
+    };
+
+    /**
+     * A registry of the supported music formats. Files are dispatched to a format by the magic bytes at the start of the file, falling back to the dot extension
+     */
+    class MusicFormatRegistry
+    {
+    public:
+    	/**
+    	 * Gets the MusicFormatRegistry
+    	 *
+    	 * @returns The MusicFormatRegistry
+    	 */
+    	static const MusicFormatRegistry& getInstance();
+    	/**
+    	 * Gets whether or not a path has the dot extension of a supported music format
+    	 *
+    	 * @param path The path to check
+    	 * @returns True if supported, else false
+    	 */
+    	bool isSupported(const std::filesystem::path& path) const;
+    	/**
+    	 * Gets the format of a music file by sniffing its content
+    	 *
+    	 * @param path The path of the music file
+    	 * @returns The format of the music file, or nullptr if not supported
+    	 */
+    	const MusicFormat* getFormat(const std::filesystem::path& path) const;
+    	/**
+    	 * Opens a music file with the TagLib file type of its format
+    	 *
+    	 * @param path The path of the music file
+    	 * @param readProperties True to read the audio properties of the music file, else false
+    	 * @param readStyle How accurately audio properties are read
+    	 * @returns The opened music file
+    	 * @throws std::invalid_argument Thrown when the path is an invalid music file
+    	 */
+    	OpenedMusicFile open(const std::filesystem::path& path, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle = TagLib::AudioProperties::Average) const;
+    	/**
+    	 * Opens a file as a music file of a known format, regardless of its dot extension (e.g. a temporary copy of a music file)
+    	 *
+    	 * @param path The path of the file
+    	 * @param format The format of the file
+    	 * @param readProperties True to read the audio properties of the music file, else false
+    	 * @param readStyle How accurately audio properties are read
+    	 * @returns The opened music file
+    	 * @throws std::invalid_argument Thrown when the file is not a valid music file of the format
+    	 */
+    	OpenedMusicFile open(const std::filesystem::path& path, const MusicFormat& format, bool readProperties, TagLib::AudioProperties::ReadStyle readStyle = TagLib::AudioProperties::Average) const;
+
+    private:
+    	/**
+    	 * Constructs a MusicFormatRegistry
+    	 */
+    	MusicFormatRegistry();
+    	std::vector<MusicFormat> m_formats;
+    	std::unordered_map<std::string, std::size_t> m_formatIndexes;
+    };
+}
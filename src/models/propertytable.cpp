@@ -0,0 +1,31 @@
+#include "propertytable.hpp"
+
+using namespace NickvisionTagger::Models;
+
+PropertyTable::PropertyTable(const PropertyTable& table) : m_properties{ table.m_properties ? std::make_unique<Properties>(*table.m_properties) : nullptr }
+{
+
+}
+
+PropertyTable& PropertyTable::operator=(const PropertyTable& table)
+{
+    if(this != &table)
+    {
+        m_properties = table.m_properties ? std::make_unique<Properties>(*table.m_properties) : nullptr;
+    }
+    return *this;
+}
+
+bool PropertyTable::empty() const
+{
+    return !m_properties;
+}
+
+bool PropertyTable::operator==(const PropertyTable& toCompare) const
+{
+    if(!m_properties || !toCompare.m_properties)
+    {
+        return !m_properties && !toCompare.m_properties;
+    }
+    return m_properties->numbers == toCompare.m_properties->numbers && m_properties->texts == toCompare.m_properties->texts;
+}
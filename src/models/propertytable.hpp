@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * A compact table of the less common properties of a music file (disc number, composer, lyrics, etc.), keyed by a small integer
+     *
+     * Only properties that are present are stored, and a table without properties holds no allocation at all, so files that lack the properties cost a single null pointer
+     */
+    class PropertyTable
+    {
+    public:
+    	/**
+    	 * Constructs an empty PropertyTable
+    	 */
+    	PropertyTable() = default;
+    	/**
+    	 * Constructs a PropertyTable as a copy of another
+    	 *
+    	 * @param table The PropertyTable to copy
+    	 */
+    	PropertyTable(const PropertyTable& table);
+    	/**
+    	 * Constructs a PropertyTable by taking the properties of another
+    	 *
+    	 * @param table The PropertyTable to move
+    	 */
+    	PropertyTable(PropertyTable&& table) noexcept = default;
+    	/**
+    	 * Copies the properties of another PropertyTable
+    	 *
+    	 * @param table The PropertyTable to copy
+    	 * @returns This PropertyTable
+    	 */
+    	PropertyTable& operator=(const PropertyTable& table);
+    	/**
+    	 * Takes the properties of another PropertyTable
+    	 *
+    	 * @param table The PropertyTable to move
+    	 * @returns This PropertyTable
+    	 */
+    	PropertyTable& operator=(PropertyTable&& table) noexcept = default;
+    	/**
+    	 * Gets whether or not the table holds no properties
+    	 *
+    	 * @returns True if empty, else false
+    	 */
+    	bool empty() const;
+    	/**
+    	 * Gets the value of a property
+    	 *
+    	 * @param key The key of the property
+    	 * @returns The value of the property, or the default value (empty or 0) if the table does not hold the property
+    	 */
+    	template<typename Value>
+    	const Value& get(std::uint8_t key) const
+    	{
+    	    static const Value defaultValue{};
+    	    if(!m_properties)
+    	    {
+    	        return defaultValue;
+    	    }
+    	    const std::vector<std::pair<std::uint8_t, Value>>& values{ getValues<Value>(*m_properties) };
+    	    typename std::vector<std::pair<std::uint8_t, Value>>::const_iterator it{ find(values, key) };
+    	    return it != values.end() && it->first == key ? it->second : defaultValue;
+    	}
+    	/**
+    	 * Sets the value of a property. Setting the default value (empty or 0) removes the property
+    	 *
+    	 * @param key The key of the property
+    	 * @param value The new value of the property
+    	 */
+    	template<typename Value>
+    	void set(std::uint8_t key, const Value& value)
+    	{
+    	    bool isDefault{ value == Value{} };
+    	    if(!m_properties)
+    	    {
+    	        if(isDefault)
+    	        {
+    	            return;
+    	        }
+    	        m_properties = std::make_unique<Properties>();
+    	    }
+    	    std::vector<std::pair<std::uint8_t, Value>>& values{ getValues<Value>(*m_properties) };
+    	    typename std::vector<std::pair<std::uint8_t, Value>>::iterator it{ find(values, key) };
+    	    if(it != values.end() && it->first == key)
+    	    {
+    	        if(isDefault)
+    	        {
+    	            values.erase(it);
+    	        }
+    	        else
+    	        {
+    	            it->second = value;
+    	        }
+    	    }
+    	    else if(!isDefault)
+    	    {
+    	        values.insert(it, { key, value });
+    	    }
+    	    if(m_properties->numbers.empty() && m_properties->texts.empty())
+    	    {
+    	        m_properties.reset();
+    	    }
+    	}
+    	/**
+    	 * Compares this to toCompare via equals
+    	 *
+    	 * @param toCompare The PropertyTable to compare
+    	 * @returns True if both hold the same properties, else false
+    	 */
+    	bool operator==(const PropertyTable& toCompare) const;
+
+    private:
+    	/**
+    	 * The properties of a table, each list sorted by key
+    	 */
+    	struct Properties
+    	{
+    	    std::vector<std::pair<std::uint8_t, std::uint32_t>> numbers;
+    	    std::vector<std::pair<std::uint8_t, std::string>> texts;
+    	};
+    	/**
+    	 * Gets the list of properties of a value type
+    	 *
+    	 * @param properties The properties
+    	 * @returns The list of properties of the value type
+    	 */
+    	template<typename Value, typename PropertiesType>
+    	static auto& getValues(PropertiesType& properties)
+    	{
+    	    static_assert(std::is_same_v<Value, std::uint32_t> || std::is_same_v<Value, std::string>, "PropertyTable holds numbers and strings only");
+    	    if constexpr(std::is_same_v<Value, std::uint32_t>)
+    	    {
+    	        return properties.numbers;
+    	    }
+    	    else
+    	    {
+    	        return properties.texts;
+    	    }
+    	}
+    	/**
+    	 * Finds the position of a key in a sorted list of properties
+    	 *
+    	 * @param values The list of properties
+    	 * @param key The key
+    	 * @returns The first property whose key is not less than the key
+    	 */
+    	template<typename Values>
+    	static auto find(Values& values, std::uint8_t key)
+    	{
+    	    return std::lower_bound(values.begin(), values.end(), key, [](const auto& property, std::uint8_t value) { return property.first < value; });
+    	}
+    	std::unique_ptr<Properties> m_properties;
+    };
+}
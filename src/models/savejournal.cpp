@@ -0,0 +1,309 @@
+#include "savejournal.hpp"
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <json/json.h>
+#include "albumartstore.hpp"
+#include "tagfield.hpp"
+#include "../helpers/filehelpers.hpp"
+#include "../helpers/mediahelpers.hpp"
+
+using namespace NickvisionTagger::Helpers;
+using namespace NickvisionTagger::Models;
+
+/**
+ * Writes a record of the journal as a single line of JSON
+ *
+ * @param json The record
+ * @returns The line of the record (including the line break)
+ */
+static std::string toLine(const Json::Value& json)
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, json) + "\n";
+}
+
+/**
+ * Reads a record of the journal from a line
+ *
+ * @param line The line of the record
+ * @returns The record, or a null value if the line is not a whole record (e.g. a record cut off by a crash)
+ */
+static Json::Value fromLine(const std::string& line)
+{
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader{ builder.newCharReader() };
+    Json::Value json;
+    if(!reader->parse(line.c_str(), line.c_str() + line.size(), &json, nullptr) || !json.isObject())
+    {
+        return Json::Value();
+    }
+    return json;
+}
+
+/**
+ * Gets the name of a file album art can be kept in while it is in the journal
+ *
+ * @param albumArt The album art
+ * @param index The number of different images with the same hash kept before it
+ * @returns The filename of the album art
+ */
+static std::string getAlbumArtFilename(const TagLib::ByteVector& albumArt, unsigned int index)
+{
+    std::string filename{ std::to_string(AlbumArtStore::hash(albumArt)) };
+    if(index > 0)
+    {
+        filename += "-" + std::to_string(index);
+    }
+    return filename + ".art";
+}
+
+/**
+ * Converts changes taken from a music file to a record of the journal
+ *
+ * @param id The id of the record
+ * @param changes The changes
+ * @param albumArtFilename The name of the file the changed album art is kept in (empty if there is none)
+ * @param preserveModificationTimeStamp Whether or not the modification time stamp of the file is preserved
+ * @returns The record
+ */
+static Json::Value toRecord(std::uint64_t id, const TagChanges& changes, const std::string& albumArtFilename, bool preserveModificationTimeStamp)
+{
+    Json::Value json;
+    json["Id"] = Json::UInt64(id);
+    json["Path"] = changes.path.string();
+    json["Filename"] = changes.filename;
+    json["ChangedFields"] = changes.changedFields;
+    json["ModificationTime"] = Json::Int64(changes.modificationTime.time_since_epoch().count());
+    json["PreserveModificationTimeStamp"] = preserveModificationTimeStamp;
+    Json::Value& fields{ json["Fields"] };
+    forEachTagField([&](const auto& field)
+    {
+        //Positions are written as pairs, so both halves are kept even if only one changed
+        if(!((changes.changedFields >> field.index) & 1u) && !isPositionField(field.index))
+        {
+            return;
+        }
+        if constexpr(std::decay_t<decltype(field)>::isNumber)
+        {
+            fields[std::string(field.name)] = changes.fields.*field.tagField;
+        }
+        else
+        {
+            fields[std::string(field.name)] = (changes.fields.*field.tagField).to8Bit(true);
+        }
+    });
+    json["AlbumArtChanged"] = changes.isAlbumArtChanged;
+    json["AlbumArt"] = albumArtFilename;
+    return json;
+}
+
+/**
+ * Converts a record of the journal back to the changes it holds
+ *
+ * @param json The record
+ * @param folder The path of the folder of the journal
+ * @returns The changes
+ */
+static TagChanges fromRecord(const Json::Value& json, const std::filesystem::path& folder)
+{
+    TagChanges changes;
+    changes.path = json.get("Path", "").asString();
+    changes.filename = json.get("Filename", "").asString();
+    changes.changedFields = json.get("ChangedFields", 0).asUInt();
+    changes.modificationTime = std::filesystem::file_time_type(std::filesystem::file_time_type::duration(json.get("ModificationTime", 0).asInt64()));
+    const Json::Value& fields{ json["Fields"] };
+    forEachTagField([&](const auto& field)
+    {
+        std::string name{ field.name };
+        if(!fields.isMember(name))
+        {
+            return;
+        }
+        if constexpr(std::decay_t<decltype(field)>::isNumber)
+        {
+            changes.fields.*field.tagField = fields[name].asUInt();
+        }
+        else
+        {
+            changes.fields.*field.tagField = TagLib::String(fields[name].asString(), TagLib::String::UTF8);
+        }
+    });
+    changes.isAlbumArtChanged = json.get("AlbumArtChanged", false).asBool();
+    std::string albumArtFilename{ json.get("AlbumArt", "").asString() };
+    if(changes.isAlbumArtChanged && !albumArtFilename.empty())
+    {
+        changes.fields.albumArt = MediaHelpers::byteVectorFromFile(folder / albumArtFilename);
+    }
+    return changes;
+}
+
+SaveJournal::SaveJournal(const std::filesystem::path& folder) : m_folder{ folder }, m_path{ folder / "saves.jsonl" }, m_nextId{ 0 }
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_folder, error);
+}
+
+std::vector<std::uint64_t> SaveJournal::begin(const std::vector<TagChanges>& changes, bool preserveModificationTimeStamp)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    std::vector<std::uint64_t> ids;
+    std::string lines;
+    std::unordered_map<std::string, TagLib::ByteVector> albumArts;
+    for(const TagChanges& change : changes)
+    {
+        //Album art is kept next to the journal, once per image however many files it is set on. A file already named after its hash is only reused if it holds the same image
+        std::string albumArtFilename;
+        const TagLib::ByteVector& albumArt{ change.fields.albumArt };
+        for(unsigned int index = 0; change.isAlbumArtChanged && !albumArt.isEmpty() && albumArtFilename.empty(); index++)
+        {
+            std::string filename{ getAlbumArtFilename(albumArt, index) };
+            std::filesystem::path albumArtPath{ m_folder / filename };
+            std::unordered_map<std::string, TagLib::ByteVector>::iterator it{ albumArts.find(filename) };
+            if(it == albumArts.end())
+            {
+                std::error_code error;
+                std::uintmax_t size{ std::filesystem::file_size(albumArtPath, error) };
+                if(error)
+                {
+                    FileHelpers::writeFile(albumArtPath, albumArt.data(), albumArt.size(), false, true);
+                    it = albumArts.insert({ filename, albumArt }).first;
+                }
+                else
+                {
+                    it = albumArts.insert({ filename, size == albumArt.size() ? MediaHelpers::byteVectorFromFile(albumArtPath) : TagLib::ByteVector() }).first;
+                }
+            }
+            if(it->second.size() == albumArt.size() && it->second == albumArt)
+            {
+                albumArtFilename = filename;
+            }
+        }
+        ids.push_back(m_nextId++);
+        lines += toLine(toRecord(ids.back(), change, albumArtFilename, preserveModificationTimeStamp));
+    }
+    FileHelpers::writeFile(m_path, lines.c_str(), lines.size(), true, true);
+    m_unfinished.insert(ids.begin(), ids.end());
+    return ids;
+}
+
+void SaveJournal::finish(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    m_unfinished.erase(id);
+    if(m_unfinished.empty())
+    {
+        clear();
+        return;
+    }
+    //Finished records are not synced on their own. A record lost to a crash only replays a save that already completed, and the next batch syncs it anyway
+    Json::Value json;
+    json["Finished"] = Json::UInt64(id);
+    std::string line{ toLine(json) };
+    try
+    {
+        FileHelpers::writeFile(m_path, line.c_str(), line.size(), true, false);
+    }
+    catch(...) { }
+}
+
+bool SaveJournal::getHasUnfinishedSaves() const
+{
+    //The journal is emptied whenever no save is left unfinished
+    std::error_code error;
+    std::uintmax_t size{ std::filesystem::file_size(m_path, error) };
+    return !error && size > 0;
+}
+
+SaveReport SaveJournal::recover(unsigned int paddingSize, TagCache& tagCache)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    SaveReport report;
+    std::map<std::uint64_t, Json::Value> records;
+    std::ifstream journalFile{ m_path };
+    std::string line;
+    while(std::getline(journalFile, line))
+    {
+        Json::Value json{ fromLine(line) };
+        if(json.isMember("Finished"))
+        {
+            records.erase(json["Finished"].asUInt64());
+        }
+        else if(json.isMember("Id"))
+        {
+            records[json["Id"].asUInt64()] = json;
+        }
+    }
+    journalFile.close();
+    //Records are replayed in the order they were made, so later changes to a file win
+    for(const std::pair<const std::uint64_t, Json::Value>& pair : records)
+    {
+        TagChanges changes{ fromRecord(pair.second, m_folder) };
+        std::filesystem::path originalPath{ changes.path };
+        std::filesystem::path renamedPath{ originalPath.parent_path() / changes.filename };
+        FileHelpers::removeTemporaryFiles(originalPath);
+        FileHelpers::removeTemporaryFiles(renamedPath);
+        tagCache.remove(originalPath);
+        tagCache.remove(renamedPath);
+        if(!std::filesystem::exists(originalPath) && std::filesystem::exists(renamedPath))
+        {
+            changes.path = renamedPath;
+        }
+        SaveResult result;
+        try
+        {
+            MusicFile::writeChanges(changes, pair.second.get("PreserveModificationTimeStamp", false).asBool(), paddingSize);
+            result.rewritten = changes.rewritten;
+            result.success = true;
+        }
+        catch(const std::exception& e)
+        {
+            result.error = e.what();
+        }
+        catch(...)
+        {
+            result.error = "Unknown error.";
+        }
+        if(!result.success && changes.path != originalPath && !std::filesystem::exists(originalPath))
+        {
+            std::error_code renameError;
+            std::filesystem::rename(changes.path, originalPath, renameError);
+            if(!renameError)
+            {
+                changes.path = originalPath;
+            }
+        }
+        result.path = changes.path;
+        report.results.push_back(result);
+    }
+    report.successCount = std::count_if(report.results.begin(), report.results.end(), [](const SaveResult& result) { return result.success; });
+    report.failureCount = report.results.size() - report.successCount;
+    report.rewriteCount = std::count_if(report.results.begin(), report.results.end(), [](const SaveResult& result) { return result.rewritten; });
+    m_unfinished.clear();
+    clear();
+    return report;
+}
+
+void SaveJournal::clear()
+{
+    try
+    {
+        FileHelpers::writeFile(m_path, "", 0, false, false);
+    }
+    catch(...) { }
+    std::error_code error;
+    for(std::filesystem::directory_iterator it{ m_folder, error }; !error && it != std::filesystem::directory_iterator(); it.increment(error))
+    {
+        if(it->path().extension() == ".art")
+        {
+            std::error_code removeError;
+            std::filesystem::remove(it->path(), removeError);
+        }
+    }
+}
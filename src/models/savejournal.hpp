@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "musicfile.hpp"
+#include "tagcache.hpp"
+#include "tagsaver.hpp"
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * A model of a write-ahead journal of tag saves
+     *
+     * Changes are appended to the journal and synced to disk before any of them is written to its music file, then marked finished once written. A save left unfinished by a crash is replayed from the journal the next time the application starts, or rolled back if it can no longer be replayed
+     */
+    class SaveJournal
+    {
+    public:
+    	/**
+    	 * Constructs a SaveJournal
+    	 *
+    	 * @param folder The path of the folder to keep the journal in (created if it does not exist)
+    	 */
+    	SaveJournal(const std::filesystem::path& folder);
+    	/**
+    	 * Records changes that are about to be written, syncing them to disk before returning. A whole batch of changes costs a single sync
+    	 *
+    	 * @param changes The changes taken from the music files
+    	 * @param preserveModificationTimeStamp Whether or not the modification time stamps of the files are preserved
+    	 * @returns The ids of the records, in the order of the changes
+    	 * @throws std::filesystem::filesystem_error Thrown when the journal could not be written
+    	 */
+    	std::vector<std::uint64_t> begin(const std::vector<TagChanges>& changes, bool preserveModificationTimeStamp);
+    	/**
+    	 * Marks a recorded save as finished, whether it succeeded or not. Only call once the file of the save is synced (as MusicFile::writeChanges does), since the journal is emptied once no save is left unfinished
+    	 *
+    	 * @param id The id of the record
+    	 */
+    	void finish(std::uint64_t id);
+    	/**
+    	 * Gets whether or not the journal holds saves left unfinished when it was last used
+    	 *
+    	 * @returns True if there are saves for recover to replay, else false
+    	 */
+    	bool getHasUnfinishedSaves() const;
+    	/**
+    	 * Replays the saves left unfinished when the journal was last used, then empties the journal. A save that cannot be replayed is rolled back: its half-written temporary files are removed and its file gets its old name back
+    	 *
+    	 * @param paddingSize The padding to reserve (in bytes) in tags that outgrow their space
+    	 * @param tagCache The tag cache to remove the replayed files from, since a replay that preserves the modification time stamp leaves their cached metadata looking valid
+    	 * @returns The report of the replayed saves
+    	 */
+    	SaveReport recover(unsigned int paddingSize, TagCache& tagCache);
+
+    private:
+    	/**
+    	 * Removes the contents of the journal and the album art it holds
+    	 */
+    	void clear();
+    	std::mutex m_mutex;
+    	std::filesystem::path m_folder;
+    	std::filesystem::path m_path;
+    	std::uint64_t m_nextId;
+    	std::unordered_set<std::uint64_t> m_unfinished;
+    };
+}
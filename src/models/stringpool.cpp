@@ -0,0 +1,124 @@
+#include "stringpool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+
+using namespace NickvisionTagger::Models;
+
+StringPool& StringPool::getInstance()
+{
+    static StringPool instance;
+    return instance;
+}
+
+StringPool::StringPool()
+{
+    insert("");
+}
+
+std::uint32_t StringPool::intern(const std::string& value)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock{ m_mutex };
+        std::unordered_map<std::string_view, std::uint32_t>::const_iterator it{ m_ids.find(value) };
+        if(it != m_ids.end())
+        {
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock{ m_mutex };
+    return insert(value);
+}
+
+std::optional<std::uint32_t> StringPool::find(const std::string& value) const
+{
+    std::shared_lock<std::shared_mutex> lock{ m_mutex };
+    std::unordered_map<std::string_view, std::uint32_t>::const_iterator it{ m_ids.find(value) };
+    if(it == m_ids.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+const std::string& StringPool::get(std::uint32_t id) const
+{
+    //Strings are appended to a deque, which never moves its elements, so the reference outlives the lock
+    std::shared_lock<std::shared_mutex> lock{ m_mutex };
+    return m_strings[id];
+}
+
+std::uint32_t StringPool::getLowercaseId(std::uint32_t id) const
+{
+    std::shared_lock<std::shared_mutex> lock{ m_mutex };
+    return m_lowercaseIds[id];
+}
+
+std::size_t StringPool::getSize() const
+{
+    std::shared_lock<std::shared_mutex> lock{ m_mutex };
+    return m_strings.size();
+}
+
+std::uint32_t StringPool::insert(const std::string& value)
+{
+    //Another thread may have added the string between the shared and exclusive locks
+    std::unordered_map<std::string_view, std::uint32_t>::const_iterator it{ m_ids.find(value) };
+    if(it != m_ids.end())
+    {
+        return it->second;
+    }
+    std::string lowercase{ value };
+    std::transform(lowercase.begin(), lowercase.end(), lowercase.begin(), ::tolower);
+    std::uint32_t lowercaseId{ lowercase == value ? static_cast<std::uint32_t>(m_strings.size()) : insert(lowercase) };
+    std::uint32_t id{ static_cast<std::uint32_t>(m_strings.size()) };
+    m_strings.push_back(value);
+    m_lowercaseIds.push_back(lowercaseId);
+    m_ids.insert({ m_strings.back(), id });
+    return id;
+}
+
+InternedString::InternedString() : m_id{ StringPool::EMPTY_ID }
+{
+
+}
+
+InternedString::InternedString(const std::string& value) : m_id{ value.empty() ? StringPool::EMPTY_ID : StringPool::getInstance().intern(value) }
+{
+
+}
+
+InternedString::InternedString(const char* value) : InternedString(std::string(value))
+{
+
+}
+
+std::uint32_t InternedString::getId() const
+{
+    return m_id;
+}
+
+bool InternedString::empty() const
+{
+    return m_id == StringPool::EMPTY_ID;
+}
+
+const std::string& InternedString::get() const
+{
+    return StringPool::getInstance().get(m_id);
+}
+
+InternedString::operator const std::string&() const
+{
+    return get();
+}
+
+bool InternedString::operator==(const InternedString& toCompare) const
+{
+    return m_id == toCompare.m_id;
+}
+
+bool InternedString::operator!=(const InternedString& toCompare) const
+{
+    return m_id != toCompare.m_id;
+}
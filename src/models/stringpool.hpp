@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * A library-wide pool of interned strings. Each distinct string is held once and identified by an ID, so identical tag values share storage and compare as integers
+     *
+     * Strings are never removed from the pool, and the pool also records the ID of the lowercase form of each string for case-insensitive matching
+     */
+    class StringPool
+    {
+    public:
+    	/**
+    	 * The ID of the empty string
+    	 */
+    	static constexpr std::uint32_t EMPTY_ID{ 0 };
+    	/**
+    	 * Gets the StringPool shared by all music files
+    	 *
+    	 * @returns The StringPool
+    	 */
+    	static StringPool& getInstance();
+    	StringPool(const StringPool&) = delete;
+    	StringPool& operator=(const StringPool&) = delete;
+    	/**
+    	 * Adds a string to the pool
+    	 *
+    	 * @param value The string
+    	 * @returns The ID of the string (the existing one if the string is already held)
+    	 */
+    	std::uint32_t intern(const std::string& value);
+    	/**
+    	 * Gets the ID of a string without adding it to the pool
+    	 *
+    	 * @param value The string
+    	 * @returns The ID of the string, or std::nullopt if the string is not held
+    	 */
+    	std::optional<std::uint32_t> find(const std::string& value) const;
+    	/**
+    	 * Gets a string by its ID. The reference stays valid for the lifetime of the pool
+    	 *
+    	 * @param id The ID of the string
+    	 * @returns The string
+    	 */
+    	const std::string& get(std::uint32_t id) const;
+    	/**
+    	 * Gets the ID of the lowercase form of a string
+    	 *
+    	 * @param id The ID of the string
+    	 * @returns The ID of the lowercase form (the same ID if the string is already lowercase)
+    	 */
+    	std::uint32_t getLowercaseId(std::uint32_t id) const;
+    	/**
+    	 * Gets the number of strings held by the pool
+    	 *
+    	 * @returns The number of strings
+    	 */
+    	std::size_t getSize() const;
+
+    private:
+    	/**
+    	 * Constructs a StringPool
+    	 */
+    	StringPool();
+    	/**
+    	 * Adds a string to the pool. The caller must hold the lock exclusively
+    	 *
+    	 * @param value The string
+    	 * @returns The ID of the string
+    	 */
+    	std::uint32_t insert(const std::string& value);
+    	std::deque<std::string> m_strings;
+    	std::vector<std::uint32_t> m_lowercaseIds;
+    	std::unordered_map<std::string_view, std::uint32_t> m_ids;
+    	mutable std::shared_mutex m_mutex;
+    };
+
+    /**
+     * A string value held by the StringPool, stored as its ID
+     */
+    class InternedString
+    {
+    public:
+    	/**
+    	 * Constructs an empty InternedString
+    	 */
+    	InternedString();
+    	/**
+    	 * Constructs an InternedString, interning the value
+    	 *
+    	 * @param value The string value
+    	 */
+    	InternedString(const std::string& value);
+    	/**
+    	 * Constructs an InternedString, interning the value
+    	 *
+    	 * @param value The string value
+    	 */
+    	InternedString(const char* value);
+    	/**
+    	 * Gets the ID of the string in the StringPool
+    	 *
+    	 * @returns The ID of the string
+    	 */
+    	std::uint32_t getId() const;
+    	/**
+    	 * Gets whether or not the string is empty
+    	 *
+    	 * @returns True if empty, else false
+    	 */
+    	bool empty() const;
+    	/**
+    	 * Gets the string value
+    	 *
+    	 * @returns The string value
+    	 */
+    	const std::string& get() const;
+    	/**
+    	 * Gets the string value
+    	 *
+    	 * @returns The string value
+    	 */
+    	operator const std::string&() const;
+    	/**
+    	 * Compares this to toCompare via equals
+    	 *
+    	 * @param toCompare The InternedString to compare
+    	 * @returns True if both hold the same string, else false
+    	 */
+    	bool operator==(const InternedString& toCompare) const;
+    	/**
+    	 * Compares this to toCompare via not equals
+    	 *
+    	 * @param toCompare The InternedString to compare
+    	 * @returns True if the strings differ, else false
+    	 */
+    	bool operator!=(const InternedString& toCompare) const;
+
+    private:
+    	std::uint32_t m_id;
+    };
+}
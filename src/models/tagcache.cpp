@@ -0,0 +1,202 @@
+#include "tagcache.hpp"
+#include <fstream>
+#include <memory>
+#include <json/json.h>
+#include "tagfield.hpp"
+
+using namespace NickvisionTagger::Models;
+
+//Bump when the layout of an entry changes so that stale caches are discarded instead of misread
+static const int TAG_CACHE_VERSION{ 4 };
+
+TagCache::TagCache(const std::filesystem::path& path) : m_path{ path }, m_isDirty{ false }
+{
+    std::ifstream cacheFile{ m_path };
+    if(cacheFile.is_open())
+    {
+        Json::Value json;
+        try
+        {
+            cacheFile >> json;
+        }
+        catch(...)
+        {
+            return;
+        }
+        if(json.get("Version", 0).asInt() != TAG_CACHE_VERSION)
+        {
+            return;
+        }
+        const Json::Value& files{ json["Files"] };
+        for(Json::Value::const_iterator it = files.begin(); it != files.end(); it++)
+        {
+            const Json::Value& value{ *it };
+            TagCacheEntry entry;
+            entry.fileSize = value.get("FileSize", 0).asUInt64();
+            entry.modificationTime = value.get("ModificationTime", 0).asInt64();
+            entry.title = value.get("Title", "").asString();
+            entry.artist = value.get("Artist", "").asString();
+            entry.album = value.get("Album", "").asString();
+            entry.year = value.get("Year", 0).asUInt();
+            entry.track = value.get("Track", 0).asUInt();
+            entry.albumArtist = value.get("AlbumArtist", "").asString();
+            entry.genre = value.get("Genre", "").asString();
+            entry.comment = value.get("Comment", "").asString();
+            //Sparse fields are stored by name, and only when present
+            const Json::Value& properties{ value["Properties"] };
+            forEachTagField([&](const auto& field)
+            {
+                if constexpr(std::decay_t<decltype(field)>::isSparse)
+                {
+                    std::string name{ field.name };
+                    if(!properties.isMember(name))
+                    {
+                        return;
+                    }
+                    if constexpr(std::decay_t<decltype(field)>::isNumber)
+                    {
+                        entry.properties.set(static_cast<std::uint8_t>(field.index), static_cast<std::uint32_t>(properties[name].asUInt()));
+                    }
+                    else
+                    {
+                        entry.properties.set(static_cast<std::uint8_t>(field.index), properties[name].asString());
+                    }
+                }
+            });
+            entry.duration = value.get("Duration", -1).asInt();
+            entry.hasAlbumArt = value.get("HasAlbumArt", false).asBool();
+            entry.albumArtHash = value.get("AlbumArtHash", 0).asUInt64();
+            entry.albumArtSize = value.get("AlbumArtSize", 0).asUInt64();
+            m_entries.insert({ it.name(), entry });
+        }
+    }
+}
+
+std::optional<TagCacheEntry> TagCache::lookup(const std::filesystem::path& path, std::uintmax_t fileSize, std::int64_t modificationTime) const
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    std::unordered_map<std::string, TagCacheEntry>::const_iterator it{ m_entries.find(path.string()) };
+    if(it == m_entries.end() || it->second.fileSize != fileSize || it->second.modificationTime != modificationTime)
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void TagCache::update(const std::filesystem::path& path, const TagCacheEntry& entry)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    m_entries.insert_or_assign(path.string(), entry);
+    m_isDirty = true;
+}
+
+void TagCache::updateDuration(const std::filesystem::path& path, int duration)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    std::unordered_map<std::string, TagCacheEntry>::iterator it{ m_entries.find(path.string()) };
+    if(it != m_entries.end() && it->second.duration != duration)
+    {
+        it->second.duration = duration;
+        m_isDirty = true;
+    }
+}
+
+void TagCache::remove(const std::filesystem::path& path)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    if(m_entries.erase(path.string()) > 0)
+    {
+        m_isDirty = true;
+    }
+}
+
+void TagCache::prune(const std::filesystem::path& folderPath, const std::unordered_set<std::string>& foundPaths)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    std::string prefix{ folderPath.string() };
+    if(!prefix.empty() && prefix.back() != '/')
+    {
+        prefix += "/";
+    }
+    for(std::unordered_map<std::string, TagCacheEntry>::iterator it = m_entries.begin(); it != m_entries.end();)
+    {
+        if(it->first.rfind(prefix, 0) == 0 && !foundPaths.contains(it->first))
+        {
+            it = m_entries.erase(it);
+            m_isDirty = true;
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+void TagCache::save()
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    if(!m_isDirty)
+    {
+        return;
+    }
+    Json::Value json;
+    json["Version"] = TAG_CACHE_VERSION;
+    Json::Value& files{ json["Files"] };
+    for(const std::pair<const std::string, TagCacheEntry>& pair : m_entries)
+    {
+        Json::Value& value{ files[pair.first] };
+        value["FileSize"] = Json::UInt64(pair.second.fileSize);
+        value["ModificationTime"] = Json::Int64(pair.second.modificationTime);
+        value["Title"] = pair.second.title;
+        value["Artist"] = pair.second.artist;
+        value["Album"] = pair.second.album;
+        value["Year"] = pair.second.year;
+        value["Track"] = pair.second.track;
+        value["AlbumArtist"] = pair.second.albumArtist;
+        value["Genre"] = pair.second.genre;
+        value["Comment"] = pair.second.comment;
+        if(!pair.second.properties.empty())
+        {
+            Json::Value& properties{ value["Properties"] };
+            forEachTagField([&](const auto& field)
+            {
+                using Field = std::decay_t<decltype(field)>;
+                if constexpr(Field::isSparse)
+                {
+                    const typename Field::ValueType& property{ pair.second.properties.template get<typename Field::ValueType>(static_cast<std::uint8_t>(field.index)) };
+                    if(property != typename Field::ValueType{})
+                    {
+                        properties[std::string(field.name)] = property;
+                    }
+                }
+            });
+        }
+        value["Duration"] = pair.second.duration;
+        value["HasAlbumArt"] = pair.second.hasAlbumArt;
+        value["AlbumArtHash"] = Json::UInt64(pair.second.albumArtHash);
+        value["AlbumArtSize"] = Json::UInt64(pair.second.albumArtSize);
+    }
+    //Write compactly to a temporary file and rename it over the cache so a crash never leaves a truncated cache behind
+    std::filesystem::path tempPath{ m_path.string() + ".tmp" };
+    std::ofstream cacheFile{ tempPath };
+    if(cacheFile.is_open())
+    {
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        std::unique_ptr<Json::StreamWriter> writer{ builder.newStreamWriter() };
+        writer->write(json, &cacheFile);
+        cacheFile.close();
+        std::error_code ec;
+        //A write that failed part way (e.g. the disk is full) leaves a truncated temporary file, which must not replace the old one
+        if(!cacheFile)
+        {
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+        std::filesystem::rename(tempPath, m_path, ec);
+        if(!ec)
+        {
+            m_isDirty = false;
+        }
+    }
+}
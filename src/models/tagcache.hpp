@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "propertytable.hpp"
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * The tag metadata of a music file as stored in the TagCache
+     */
+    struct TagCacheEntry
+    {
+    	std::uintmax_t fileSize{ 0 };
+    	std::int64_t modificationTime{ 0 };
+    	std::string title;
+    	std::string artist;
+    	std::string album;
+    	unsigned int year{ 0 };
+    	unsigned int track{ 0 };
+    	std::string albumArtist;
+    	std::string genre;
+    	std::string comment;
+    	PropertyTable properties;
+    	int duration{ -1 };
+    	bool hasAlbumArt{ false };
+    	std::uint64_t albumArtHash{ 0 };
+    	std::uintmax_t albumArtSize{ 0 };
+    };
+
+    /**
+     * A persistent cache of parsed tag metadata, keyed by path and validated by file size and modification time
+     */
+    class TagCache
+    {
+    public:
+    	/**
+    	 * Constructs a TagCache (loading the cache from disk)
+    	 *
+    	 * @param path The path of the cache file
+    	 */
+    	TagCache(const std::filesystem::path& path);
+    	/**
+    	 * Gets the cached metadata of a music file
+    	 *
+    	 * @param path The path of the music file
+    	 * @param fileSize The current size of the music file on disk
+    	 * @param modificationTime The current modification time of the music file on disk
+    	 * @returns The cached metadata if the file is unchanged since it was cached, else std::nullopt
+    	 */
+    	std::optional<TagCacheEntry> lookup(const std::filesystem::path& path, std::uintmax_t fileSize, std::int64_t modificationTime) const;
+    	/**
+    	 * Adds or replaces the cached metadata of a music file
+    	 *
+    	 * @param path The path of the music file
+    	 * @param entry The metadata to cache
+    	 */
+    	void update(const std::filesystem::path& path, const TagCacheEntry& entry);
+    	/**
+    	 * Sets the duration of a cached music file, leaving the rest of its metadata as is
+    	 *
+    	 * @param path The path of the music file
+    	 * @param duration The duration of the music file (in seconds)
+    	 */
+    	void updateDuration(const std::filesystem::path& path, int duration);
+    	/**
+    	 * Removes the cached metadata of a music file, so it is read from disk again
+    	 *
+    	 * @param path The path of the music file
+    	 */
+    	void remove(const std::filesystem::path& path);
+    	/**
+    	 * Removes cached metadata of files inside a folder that were not found in the latest scan of that folder
+    	 *
+    	 * @param folderPath The path of the scanned folder
+    	 * @param foundPaths The paths of the music files found in the scan
+    	 */
+    	void prune(const std::filesystem::path& folderPath, const std::unordered_set<std::string>& foundPaths);
+    	/**
+    	 * Saves the cache to disk if it was changed
+    	 */
+    	void save();
+
+    private:
+    	std::filesystem::path m_path;
+    	std::unordered_map<std::string, TagCacheEntry> m_entries;
+    	bool m_isDirty;
+    	mutable std::mutex m_mutex;
+    };
+}
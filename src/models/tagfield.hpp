@@ -0,0 +1,252 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <taglib/tag.h>
+#include <taglib/tstring.h>
+#include "librarystore.hpp"
+#include "musicformat.hpp"
+#include "stringpool.hpp"
+#include "tagcache.hpp"
+#include "tagmap.hpp"
+
+namespace NickvisionTagger::Models
+{
+    /**
+     * A compile-time description of a tag field: its name, where it is stored and how it is read and written in every kind of tag
+     *
+     * Value is the type of the field in the LibraryStore (std::string, InternedString or std::uint32_t for numbers). Sparse fields are held in the PropertyTable of a row, keyed by their index, instead of in a column of their own, and are not stored in a TagCacheEntry member of their own
+     */
+    template<typename Value, bool Sparse = false>
+    struct TagFieldDescriptor
+    {
+    	using ValueType = Value;
+    	static constexpr bool isNumber{ std::is_same_v<Value, std::uint32_t> };
+    	static constexpr bool isSparse{ Sparse };
+    	using TagValueType = std::conditional_t<isNumber, unsigned int, TagLib::String>;
+    	using CacheValueType = std::conditional_t<isNumber, unsigned int, std::string>;
+    	using TagSetter = void (TagLib::Tag::*)(std::conditional_t<isNumber, unsigned int, const TagLib::String&>);
+    	std::size_t index;
+    	std::string_view name;
+    	TagFieldKeys keys;
+    	LibraryColumn<Value> LibraryColumns::* column;
+    	TagValueType TagFields::* tagField;
+    	CacheValueType TagCacheEntry::* cacheField;
+    	const std::string& (TagMap::* getTagMapValue)() const;
+    	void (TagMap::* setTagMapValue)(const std::string&);
+    	TagSetter setTagValue;
+    };
+
+    //The name of a field is its name in advanced search and filename format strings. Fields without a TagLib::Tag setter are written through TagHandler::setText under their keys
+    inline constexpr TagFieldDescriptor<std::string> TITLE_FIELD{ 0, "title", { "TIT2", "\251nam", "TITLE", nullptr, "TITLE" }, &LibraryColumns::titles, &TagFields::title, &TagCacheEntry::title, &TagMap::getTitle, &TagMap::setTitle, &TagLib::Tag::setTitle };
+    inline constexpr TagFieldDescriptor<InternedString> ARTIST_FIELD{ 1, "artist", { "TPE1", "\251ART", "ARTIST", nullptr, "ARTIST" }, &LibraryColumns::artists, &TagFields::artist, &TagCacheEntry::artist, &TagMap::getArtist, &TagMap::setArtist, &TagLib::Tag::setArtist };
+    inline constexpr TagFieldDescriptor<InternedString> ALBUM_FIELD{ 2, "album", { "TALB", "\251alb", "ALBUM", "WM/AlbumTitle", "ALBUM" }, &LibraryColumns::albums, &TagFields::album, &TagCacheEntry::album, &TagMap::getAlbum, &TagMap::setAlbum, &TagLib::Tag::setAlbum };
+    inline constexpr TagFieldDescriptor<std::uint32_t> YEAR_FIELD{ 3, "year", { "TDRC", "\251day", "DATE", "WM/Year", "YEAR" }, &LibraryColumns::years, &TagFields::year, &TagCacheEntry::year, &TagMap::getYear, &TagMap::setYear, &TagLib::Tag::setYear };
+    inline constexpr TagFieldDescriptor<std::uint32_t> TRACK_FIELD{ 4, "track", { "TRCK", "trkn", "TRACKNUMBER", "WM/TrackNumber", "TRACK" }, &LibraryColumns::tracks, &TagFields::track, &TagCacheEntry::track, &TagMap::getTrack, &TagMap::setTrack, &TagLib::Tag::setTrack };
+    inline constexpr TagFieldDescriptor<InternedString> ALBUM_ARTIST_FIELD{ 5, "albumartist", { "TPE2", "aART", "ALBUMARTIST", "ALBUMARTIST", "ALBUM ARTIST" }, &LibraryColumns::albumArtists, &TagFields::albumArtist, &TagCacheEntry::albumArtist, &TagMap::getAlbumArtist, &TagMap::setAlbumArtist, nullptr };
+    inline constexpr TagFieldDescriptor<InternedString> GENRE_FIELD{ 6, "genre", { "TCON", "\251gen", "GENRE", "WM/Genre", "GENRE" }, &LibraryColumns::genres, &TagFields::genre, &TagCacheEntry::genre, &TagMap::getGenre, &TagMap::setGenre, &TagLib::Tag::setGenre };
+    inline constexpr TagFieldDescriptor<std::string> COMMENT_FIELD{ 7, "comment", { "COMM", "\251cmt", "DESCRIPTION", nullptr, "COMMENT" }, &LibraryColumns::comments, &TagFields::comment, &TagCacheEntry::comment, &TagMap::getComment, &TagMap::setComment, &TagLib::Tag::setComment };
+    //Most files lack the fields below, so they are sparse. Disc numbers and totals share a frame/item with their number in some kinds of tag ("3/12"), where the total has no key of its own
+    inline constexpr TagFieldDescriptor<std::uint32_t, true> DISC_NUMBER_FIELD{ 8, "disc", { "TPOS", "disk", "DISCNUMBER", "WM/PartOfSet", "DISC" }, nullptr, &TagFields::discNumber, nullptr, &TagMap::getDiscNumber, &TagMap::setDiscNumber, nullptr };
+    inline constexpr TagFieldDescriptor<std::uint32_t, true> TOTAL_TRACKS_FIELD{ 9, "totaltracks", { nullptr, nullptr, "TRACKTOTAL", nullptr, nullptr }, nullptr, &TagFields::totalTracks, nullptr, &TagMap::getTotalTracks, &TagMap::setTotalTracks, nullptr };
+    inline constexpr TagFieldDescriptor<std::uint32_t, true> TOTAL_DISCS_FIELD{ 10, "totaldiscs", { nullptr, nullptr, "DISCTOTAL", nullptr, nullptr }, nullptr, &TagFields::totalDiscs, nullptr, &TagMap::getTotalDiscs, &TagMap::setTotalDiscs, nullptr };
+    inline constexpr TagFieldDescriptor<std::string, true> COMPOSER_FIELD{ 11, "composer", { "TCOM", "\251wrt", "COMPOSER", "WM/Composer", "COMPOSER" }, nullptr, &TagFields::composer, nullptr, &TagMap::getComposer, &TagMap::setComposer, nullptr };
+    inline constexpr TagFieldDescriptor<std::uint32_t, true> BPM_FIELD{ 12, "bpm", { "TBPM", "tmpo", "BPM", "WM/BeatsPerMinute", "BPM" }, nullptr, &TagFields::bpm, nullptr, &TagMap::getBPM, &TagMap::setBPM, nullptr };
+    inline constexpr TagFieldDescriptor<std::string, true> ISRC_FIELD{ 13, "isrc", { "TSRC", "----:com.apple.iTunes:ISRC", "ISRC", "WM/ISRC", "ISRC" }, nullptr, &TagFields::isrc, nullptr, &TagMap::getISRC, &TagMap::setISRC, nullptr };
+    inline constexpr TagFieldDescriptor<std::string, true> MUSICBRAINZ_RECORDING_ID_FIELD{ 14, "mbrecordingid", { "UFID:http://musicbrainz.org", "----:com.apple.iTunes:MusicBrainz Track Id", "MUSICBRAINZ_TRACKID", "MusicBrainz/Track Id", "MUSICBRAINZ_TRACKID" }, nullptr, &TagFields::musicBrainzRecordingId, nullptr, &TagMap::getMusicBrainzRecordingId, &TagMap::setMusicBrainzRecordingId, nullptr };
+    inline constexpr TagFieldDescriptor<std::string, true> MUSICBRAINZ_RELEASE_ID_FIELD{ 15, "mbreleaseid", { "TXXX:MusicBrainz Album Id", "----:com.apple.iTunes:MusicBrainz Album Id", "MUSICBRAINZ_ALBUMID", "MusicBrainz/Album Id", "MUSICBRAINZ_ALBUMID" }, nullptr, &TagFields::musicBrainzReleaseId, nullptr, &TagMap::getMusicBrainzReleaseId, &TagMap::setMusicBrainzReleaseId, nullptr };
+    inline constexpr TagFieldDescriptor<std::string, true> LYRICS_FIELD{ 16, "lyrics", { "USLT", "\251lyr", "LYRICS", "WM/Lyrics", "LYRICS" }, nullptr, &TagFields::lyrics, nullptr, &TagMap::getLyrics, &TagMap::setLyrics, nullptr };
+
+    /**
+     * The descriptors of all tag fields, in the order they are shown and written
+     */
+    inline constexpr std::tuple TAG_FIELDS{ TITLE_FIELD, ARTIST_FIELD, ALBUM_FIELD, YEAR_FIELD, TRACK_FIELD, ALBUM_ARTIST_FIELD, GENRE_FIELD, COMMENT_FIELD, DISC_NUMBER_FIELD, TOTAL_TRACKS_FIELD, TOTAL_DISCS_FIELD, COMPOSER_FIELD, BPM_FIELD, ISRC_FIELD, MUSICBRAINZ_RECORDING_ID_FIELD, MUSICBRAINZ_RELEASE_ID_FIELD, LYRICS_FIELD };
+    inline constexpr std::size_t TAG_FIELD_COUNT{ std::tuple_size_v<decltype(TAG_FIELDS)> };
+
+    /**
+     * Gets whether or not a tag field is a track or disc number or total. These are written in pairs through TagHandler::setPosition, as some kinds of tag store both in one frame/item
+     *
+     * @param index The index of the tag field
+     * @returns True if a position field, else false
+     */
+    inline constexpr bool isPositionField(std::size_t index)
+    {
+        return index == TRACK_FIELD.index || index == TOTAL_TRACKS_FIELD.index || index == DISC_NUMBER_FIELD.index || index == TOTAL_DISCS_FIELD.index;
+    }
+
+    /**
+     * Calls a function with the descriptor of every tag field. The calls are unrolled at compile time, so the function can specialize on the type of each field
+     *
+     * @param function A void(const TagFieldDescriptor<Value>&) function
+     */
+    template<typename Function>
+    void forEachTagField(Function&& function)
+    {
+        std::apply([&](const auto&... fields) { (function(fields), ...); }, TAG_FIELDS);
+    }
+
+    /**
+     * Gets the value of a tag field of a row of the LibraryStore
+     *
+     * @param columns The columns of the LibraryStore
+     * @param row The row
+     * @param field The descriptor of the tag field
+     * @returns The value of the tag field
+     */
+    template<typename Value, bool Sparse>
+    const Value& getTagFieldValue(const LibraryColumns& columns, std::uint32_t row, const TagFieldDescriptor<Value, Sparse>& field)
+    {
+        if constexpr(Sparse)
+        {
+            return columns.properties[row].template get<Value>(static_cast<std::uint8_t>(field.index));
+        }
+        else
+        {
+            return (columns.*field.column)[row];
+        }
+    }
+
+    /**
+     * Sets the value of a tag field of a row of the LibraryStore
+     *
+     * @param columns The columns of the LibraryStore
+     * @param row The row
+     * @param field The descriptor of the tag field
+     * @param value The new value of the tag field
+     */
+    template<typename Value, bool Sparse>
+    void setTagFieldValue(LibraryColumns& columns, std::uint32_t row, const TagFieldDescriptor<Value, Sparse>& field, const Value& value)
+    {
+        if constexpr(Sparse)
+        {
+            columns.properties[row].set(static_cast<std::uint8_t>(field.index), value);
+        }
+        else
+        {
+            (columns.*field.column)[row] = value;
+        }
+    }
+
+    /**
+     * Finds a tag field by its name
+     *
+     * @param name The name of the tag field
+     * @returns The index of the tag field, or std::nullopt if no tag field has the name
+     */
+    inline std::optional<std::size_t> findTagField(std::string_view name)
+    {
+        std::optional<std::size_t> index;
+        forEachTagField([&](const auto& field)
+        {
+            if(field.name == name)
+            {
+                index = field.index;
+            }
+        });
+        return index;
+    }
+
+    /**
+     * Converts the value of a tag field to its form in a TagMap
+     *
+     * @param value The value
+     * @returns The value as a string
+     */
+    inline std::string tagFieldToString(const std::string& value)
+    {
+        return value;
+    }
+
+    /**
+     * Converts the value of a tag field to its form in a TagMap
+     *
+     * @param value The value
+     * @returns The value as a string
+     */
+    inline std::string tagFieldToString(const InternedString& value)
+    {
+        return value.get();
+    }
+
+    /**
+     * Converts the value of a tag field to its form in a TagMap
+     *
+     * @param value The value
+     * @returns The value as a string
+     */
+    inline std::string tagFieldToString(std::uint32_t value)
+    {
+        return std::to_string(value);
+    }
+
+    /**
+     * Converts the value of a tag field to its form in a TagLib tag
+     *
+     * @param value The value
+     * @returns The value as a TagLib::String
+     */
+    inline TagLib::String tagFieldToTagValue(const std::string& value)
+    {
+        return { value, TagLib::String::Type::UTF8 };
+    }
+
+    /**
+     * Converts the value of a tag field to its form in a TagLib tag
+     *
+     * @param value The value
+     * @returns The value as a TagLib::String
+     */
+    inline TagLib::String tagFieldToTagValue(const InternedString& value)
+    {
+        return { value.get(), TagLib::String::Type::UTF8 };
+    }
+
+    /**
+     * Converts the value of a tag field to its form in a TagLib tag
+     *
+     * @param value The value
+     * @returns The value
+     */
+    inline unsigned int tagFieldToTagValue(std::uint32_t value)
+    {
+        return value;
+    }
+
+    /**
+     * Converts the value of a tag field to text for tag items that hold numbers as text
+     *
+     * @param value The value
+     * @returns The value as a TagLib::String, empty for 0
+     */
+    inline TagLib::String tagFieldToText(std::uint32_t value)
+    {
+        return value == 0 ? TagLib::String() : TagLib::String::number(static_cast<int>(value));
+    }
+
+    /**
+     * Converts a value read from a TagLib tag to the value of a tag field
+     *
+     * @param value The value read from the tag
+     * @returns The value as UTF-8
+     */
+    inline std::string tagFieldFromTagValue(const TagLib::String& value)
+    {
+        return value.to8Bit(true);
+    }
+
+    /**
+     * Converts a value read from a TagLib tag to the value of a tag field
+     *
+     * @param value The value read from the tag
+     * @returns The value
+     */
+    inline std::uint32_t tagFieldFromTagValue(unsigned int value)
+    {
+        return value;
+    }
+}
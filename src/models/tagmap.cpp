@@ -2,7 +2,7 @@
 
 using namespace NickvisionTagger::Models;
 
-TagMap::TagMap() : m_filename{ "" }, m_title{ "" }, m_artist{ "" }, m_album{ "" }, m_year{ "" }, m_track{ "" }, m_albumArtist{ "" }, m_genre{ "" }, m_comment{ "" }, m_albumArt{ "" }, m_duration{ "" }, m_fingerprint{ "" }, m_fileSize{ "" }
+TagMap::TagMap() : m_filename{ "" }, m_title{ "" }, m_artist{ "" }, m_album{ "" }, m_year{ "" }, m_track{ "" }, m_albumArtist{ "" }, m_genre{ "" }, m_comment{ "" }, m_discNumber{ "" }, m_totalTracks{ "" }, m_totalDiscs{ "" }, m_composer{ "" }, m_bpm{ "" }, m_isrc{ "" }, m_musicBrainzRecordingId{ "" }, m_musicBrainzReleaseId{ "" }, m_lyrics{ "" }, m_albumArt{ "" }, m_duration{ "" }, m_fingerprint{ "" }, m_fileSize{ "" }
 {
 
 }
@@ -97,6 +97,96 @@ void TagMap::setComment(const std::string& comment)
     m_comment = comment;
 }
 
+const std::string& TagMap::getDiscNumber() const
+{
+    return m_discNumber;
+}
+
+void TagMap::setDiscNumber(const std::string& discNumber)
+{
+    m_discNumber = discNumber;
+}
+
+const std::string& TagMap::getTotalTracks() const
+{
+    return m_totalTracks;
+}
+
+void TagMap::setTotalTracks(const std::string& totalTracks)
+{
+    m_totalTracks = totalTracks;
+}
+
+const std::string& TagMap::getTotalDiscs() const
+{
+    return m_totalDiscs;
+}
+
+void TagMap::setTotalDiscs(const std::string& totalDiscs)
+{
+    m_totalDiscs = totalDiscs;
+}
+
+const std::string& TagMap::getComposer() const
+{
+    return m_composer;
+}
+
+void TagMap::setComposer(const std::string& composer)
+{
+    m_composer = composer;
+}
+
+const std::string& TagMap::getBPM() const
+{
+    return m_bpm;
+}
+
+void TagMap::setBPM(const std::string& bpm)
+{
+    m_bpm = bpm;
+}
+
+const std::string& TagMap::getISRC() const
+{
+    return m_isrc;
+}
+
+void TagMap::setISRC(const std::string& isrc)
+{
+    m_isrc = isrc;
+}
+
+const std::string& TagMap::getMusicBrainzRecordingId() const
+{
+    return m_musicBrainzRecordingId;
+}
+
+void TagMap::setMusicBrainzRecordingId(const std::string& musicBrainzRecordingId)
+{
+    m_musicBrainzRecordingId = musicBrainzRecordingId;
+}
+
+const std::string& TagMap::getMusicBrainzReleaseId() const
+{
+    return m_musicBrainzReleaseId;
+}
+
+void TagMap::setMusicBrainzReleaseId(const std::string& musicBrainzReleaseId)
+{
+    m_musicBrainzReleaseId = musicBrainzReleaseId;
+}
+
+const std::string& TagMap::getLyrics() const
+{
+    return m_lyrics;
+}
+
+void TagMap::setLyrics(const std::string& lyrics)
+{
+    m_lyrics = lyrics;
+}
+
 const std::string& TagMap::getAlbumArt() const
 {
     return m_albumArt;
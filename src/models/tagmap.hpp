@@ -26,6 +26,24 @@ namespace NickvisionTagger::Models
 		void setGenre(const std::string& genre);
 		const std::string& getComment() const;
 		void setComment(const std::string& comment);
+		const std::string& getDiscNumber() const;
+		void setDiscNumber(const std::string& discNumber);
+		const std::string& getTotalTracks() const;
+		void setTotalTracks(const std::string& totalTracks);
+		const std::string& getTotalDiscs() const;
+		void setTotalDiscs(const std::string& totalDiscs);
+		const std::string& getComposer() const;
+		void setComposer(const std::string& composer);
+		const std::string& getBPM() const;
+		void setBPM(const std::string& bpm);
+		const std::string& getISRC() const;
+		void setISRC(const std::string& isrc);
+		const std::string& getMusicBrainzRecordingId() const;
+		void setMusicBrainzRecordingId(const std::string& musicBrainzRecordingId);
+		const std::string& getMusicBrainzReleaseId() const;
+		void setMusicBrainzReleaseId(const std::string& musicBrainzReleaseId);
+		const std::string& getLyrics() const;
+		void setLyrics(const std::string& lyrics);
 		const std::string& getAlbumArt() const;
 		void setAlbumArt(const std::string& albumArt);
 		const std::string& getDuration() const;
@@ -45,6 +63,15 @@ namespace NickvisionTagger::Models
 		std::string m_albumArtist;
 		std::string m_genre;
 		std::string m_comment;
+		std::string m_discNumber;
+		std::string m_totalTracks;
+		std::string m_totalDiscs;
+		std::string m_composer;
+		std::string m_bpm;
+		std::string m_isrc;
+		std::string m_musicBrainzRecordingId;
+		std::string m_musicBrainzReleaseId;
+		std::string m_lyrics;
 		std::string m_albumArt;
 		std::string m_duration;
 		std::string m_fingerprint;
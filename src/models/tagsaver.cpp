@@ -0,0 +1,181 @@
+#include "tagsaver.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <thread>
+#include <utility>
+#include "savejournal.hpp"
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+using namespace NickvisionTagger::Models;
+
+/**
+ * The music files of a single folder
+ */
+struct SaveGroup
+{
+    std::uint64_t device{ 0 };
+    std::vector<std::size_t> indexes;
+};
+
+/**
+ * Gets the device a folder lives on
+ *
+ * @param folder The path of the folder
+ * @returns The id of the device, or 0 if unknown
+ */
+static std::uint64_t getDevice(const std::filesystem::path& folder)
+{
+#ifdef __linux__
+    struct stat folderStat;
+    if(::stat(folder.c_str(), &folderStat) == 0)
+    {
+        return static_cast<std::uint64_t>(folderStat.st_dev);
+    }
+#endif
+    return 0;
+}
+
+/**
+ * Groups changes by the folder of their music file, ordering the groups so consecutive groups alternate between devices
+ *
+ * @param changes The changes of the music files
+ * @returns The groups of changes
+ */
+static std::vector<SaveGroup> groupChanges(const std::vector<TagChanges>& changes)
+{
+    std::map<std::filesystem::path, SaveGroup> folders;
+    for(std::size_t i = 0; i < changes.size(); i++)
+    {
+        folders[changes[i].path.parent_path()].indexes.push_back(i);
+    }
+    std::map<std::uint64_t, std::vector<SaveGroup>> devices;
+    for(std::pair<const std::filesystem::path, SaveGroup>& pair : folders)
+    {
+        pair.second.device = getDevice(pair.first);
+        devices[pair.second.device].push_back(std::move(pair.second));
+    }
+    std::vector<SaveGroup> groups;
+    groups.reserve(folders.size());
+    for(std::size_t round = 0; groups.size() < folders.size(); round++)
+    {
+        for(std::pair<const std::uint64_t, std::vector<SaveGroup>>& pair : devices)
+        {
+            if(round < pair.second.size())
+            {
+                groups.push_back(std::move(pair.second[round]));
+            }
+        }
+    }
+    return groups;
+}
+
+TagSaver::TagSaver(unsigned int workerCount) : m_workerCount{ workerCount }, m_journal{ nullptr }
+{
+
+}
+
+void TagSaver::setJournal(const std::shared_ptr<SaveJournal>& journal)
+{
+    m_journal = journal;
+}
+
+SaveReport TagSaver::save(const std::vector<std::shared_ptr<MusicFile>>& musicFiles, bool preserveModificationTimeStamp, unsigned int paddingSize) const
+{
+    std::vector<TagChanges> changes;
+    changes.reserve(musicFiles.size());
+    for(const std::shared_ptr<MusicFile>& musicFile : musicFiles)
+    {
+        changes.push_back(musicFile->takeChanges());
+    }
+    SaveReport report{ save(changes, preserveModificationTimeStamp, paddingSize) };
+    for(std::size_t i = 0; i < musicFiles.size(); i++)
+    {
+        musicFiles[i]->finishSave(changes[i], report.results[i].success);
+    }
+    return report;
+}
+
+SaveReport TagSaver::save(std::vector<TagChanges>& changes, bool preserveModificationTimeStamp, unsigned int paddingSize) const
+{
+    SaveReport report;
+    report.results.resize(changes.size());
+    //No file is touched until every change of the batch is safely in the journal
+    std::vector<std::uint64_t> journalIds;
+    if(m_journal)
+    {
+        try
+        {
+            journalIds = m_journal->begin(changes, preserveModificationTimeStamp);
+        }
+        catch(const std::exception& e)
+        {
+            for(std::size_t i = 0; i < changes.size(); i++)
+            {
+                report.results[i].path = changes[i].path;
+                report.results[i].error = e.what();
+            }
+            report.failureCount = changes.size();
+            return report;
+        }
+    }
+    std::vector<SaveGroup> groups{ groupChanges(changes) };
+    std::atomic<std::size_t> nextGroup{ 0 };
+    //Each result is only written by the worker that owns its group, so the results need no lock
+    std::function<void()> work{ [&]()
+    {
+        for(std::size_t group{ nextGroup++ }; group < groups.size(); group = nextGroup++)
+        {
+            for(std::size_t index : groups[group].indexes)
+            {
+                SaveResult& result{ report.results[index] };
+                try
+                {
+                    MusicFile::writeChanges(changes[index], preserveModificationTimeStamp, paddingSize);
+                    result.rewritten = changes[index].rewritten;
+                    result.success = true;
+                }
+                catch(const std::exception& e)
+                {
+                    result.error = e.what();
+                }
+                catch(...)
+                {
+                    result.error = "Unknown error.";
+                }
+                result.path = changes[index].path;
+                if(m_journal)
+                {
+                    m_journal->finish(journalIds[index]);
+                }
+            }
+        }
+    } };
+    unsigned int workerCount{ m_workerCount > 0 ? m_workerCount : std::max(std::thread::hardware_concurrency(), 1u) };
+    workerCount = static_cast<unsigned int>(std::min<std::size_t>(workerCount, groups.size()));
+    if(workerCount <= 1)
+    {
+        work();
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        for(unsigned int i = 0; i < workerCount; i++)
+        {
+            workers.push_back(std::thread(work));
+        }
+        for(std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+    report.successCount = std::count_if(report.results.begin(), report.results.end(), [](const SaveResult& result) { return result.success; });
+    report.failureCount = report.results.size() - report.successCount;
+    report.rewriteCount = std::count_if(report.results.begin(), report.results.end(), [](const SaveResult& result) { return result.rewritten; });
+    return report;
+}
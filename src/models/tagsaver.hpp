@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "musicfile.hpp"
+
+namespace NickvisionTagger::Models
+{
+    class SaveJournal;
+
+    /**
+     * The outcome of saving the tag of a single music file
+     */
+    struct SaveResult
+    {
+    	std::filesystem::path path;
+    	bool success{ false };
+    	bool rewritten{ false };
+    	std::string error;
+    };
+
+    /**
+     * The outcome of saving the tags of many music files
+     */
+    struct SaveReport
+    {
+    	/**
+    	 * The result of every music file, in the order the music files were given
+    	 */
+    	std::vector<SaveResult> results;
+    	std::size_t successCount{ 0 };
+    	std::size_t failureCount{ 0 };
+    	/**
+    	 * The number of saves whose tag outgrew its space, so the whole file had to be rewritten
+    	 */
+    	std::size_t rewriteCount{ 0 };
+    };
+
+    /**
+     * A model of a batch of tag saves spread across worker threads
+     *
+     * Music files are grouped by the folder they live in, and each folder is saved by a single worker so renames and writes within a folder never race each other. Folders are handed out alternating between devices, so workers keep every disk busy instead of queueing up on the same one
+     */
+    class TagSaver
+    {
+    public:
+    	/**
+    	 * Constructs a TagSaver
+    	 *
+    	 * @param workerCount The number of worker threads (0 to use one per hardware thread)
+    	 */
+    	TagSaver(unsigned int workerCount);
+    	/**
+    	 * Sets the journal to record saves in before they are written, so saves interrupted by a crash can be recovered
+    	 *
+    	 * @param journal The SaveJournal to use (nullptr to not journal saves)
+    	 */
+    	void setJournal(const std::shared_ptr<SaveJournal>& journal);
+    	/**
+    	 * Saves the tags of music files. A music file that fails to save is recorded in the report and does not stop the others
+    	 *
+    	 * @param musicFiles The music files to save
+    	 * @param preserveModificationTimeStamp Set true to preserve the modification time stamps of the files, else false
+    	 * @param paddingSize The padding to reserve (in bytes) in tags that outgrow their space
+    	 * @returns The report of the saves
+    	 */
+    	SaveReport save(const std::vector<std::shared_ptr<MusicFile>>& musicFiles, bool preserveModificationTimeStamp, unsigned int paddingSize) const;
+    	/**
+    	 * Saves changes taken from music files with MusicFile::takeChanges. The music files are not touched, so this can run away from the thread that edits them
+    	 *
+    	 * @param changes The changes to save (updated as by MusicFile::writeChanges)
+    	 * @param preserveModificationTimeStamp Set true to preserve the modification time stamps of the files, else false
+    	 * @param paddingSize The padding to reserve (in bytes) in tags that outgrow their space
+    	 * @returns The report of the saves
+    	 */
+    	SaveReport save(std::vector<TagChanges>& changes, bool preserveModificationTimeStamp, unsigned int paddingSize) const;
+
+    private:
+    	unsigned int m_workerCount;
+    	std::shared_ptr<SaveJournal> m_journal;
+    };
+}
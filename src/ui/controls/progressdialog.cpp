@@ -5,7 +5,7 @@
 
 using namespace NickvisionTagger::UI::Controls;
 
-ProgressDialog::ProgressDialog(GtkWindow* parent, const std::string& description, const std::function<void()>& work) : m_work{ work }, m_gobj{ adw_window_new() }
+ProgressDialog::ProgressDialog(GtkWindow* parent, const std::string& description, const std::function<void()>& work, const std::function<double()>& progress) : m_work{ work }, m_progress{ progress }, m_gobj{ adw_window_new() }
 {
     //Window Settings
     gtk_window_set_transient_for(GTK_WINDOW(m_gobj), parent);
@@ -20,6 +20,7 @@ ProgressDialog::ProgressDialog(GtkWindow* parent, const std::string& description
     gtk_widget_set_halign(m_lblDescription, GTK_ALIGN_START);
     //Progress Bar
     m_progBar = gtk_progress_bar_new();
+    gtk_progress_bar_set_show_text(GTK_PROGRESS_BAR(m_progBar), static_cast<bool>(m_progress));
     //Main Box
     m_mainBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 20);
     gtk_widget_set_margin_start(m_mainBox, 10);
@@ -43,7 +44,14 @@ void ProgressDialog::run()
     gtk_widget_show(m_gobj);
     while(status != std::future_status::ready)
     {
-        gtk_progress_bar_pulse(GTK_PROGRESS_BAR(m_progBar));
+        if(m_progress)
+        {
+            gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(m_progBar), m_progress());
+        }
+        else
+        {
+            gtk_progress_bar_pulse(GTK_PROGRESS_BAR(m_progBar));
+        }
         g_main_context_iteration(g_main_context_default(), false);
         status = result.wait_for(std::chrono::milliseconds(30));
     }
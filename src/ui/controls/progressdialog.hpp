@@ -18,8 +18,9 @@ namespace NickvisionTagger::UI::Controls
          * @param parent The parent window for the dialog
          * @param description The description of the long task
          * @param work The long task to preform
+         * @param progress A double() function returning the fraction of the task done (0 to 1), polled while the task runs (empty to pulse the progress bar instead)
          */
-    	ProgressDialog(GtkWindow* parent, const std::string& description, const std::function<void()>& work);
+    	ProgressDialog(GtkWindow* parent, const std::string& description, const std::function<void()>& work, const std::function<double()>& progress = {});
     	/**
     	 * Gets the GtkWidget* representing the ProgressDialog
     	 *
@@ -33,6 +34,7 @@ namespace NickvisionTagger::UI::Controls
 
     private:
     	std::function<void()> m_work;
+    	std::function<double()> m_progress;
 		GtkWidget* m_gobj{ nullptr };
 		GtkWidget* m_mainBox{ nullptr };
 		GtkWidget* m_lblDescription{ nullptr };
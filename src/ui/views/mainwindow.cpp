@@ -1,7 +1,10 @@
 #include "mainwindow.hpp"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <regex>
+#include <unordered_set>
 #include <utility>
 #include "preferencesdialog.hpp"
 #include "shortcutsdialog.hpp"
@@ -43,7 +46,7 @@ void gtk_image_set_from_byte_vector(GtkImage* image, const TagLib::ByteVector& b
     }
 }
 
-MainWindow::MainWindow(GtkApplication* application, const MainWindowController& controller) : m_controller{ controller }, m_isSelectionOccuring{ false }, m_gobj{ adw_application_window_new(application) }
+MainWindow::MainWindow(GtkApplication* application, const MainWindowController& controller) : m_controller{ controller }, m_isSelectionOccuring{ false }, m_isLoadingMusicFolder{ false }, m_isReloadPending{ false }, m_isClosePending{ false }, m_isUpdatingRows{ false }, m_gobj{ adw_application_window_new(application) }
 {
     //Window Settings
     gtk_window_set_default_size(GTK_WINDOW(m_gobj), 900, 700);
@@ -75,6 +78,11 @@ MainWindow::MainWindow(GtkApplication* application, const MainWindowController&
     //Menu Help Button
     m_btnMenuHelp = gtk_menu_button_new();
     GMenu* menuHelp{ g_menu_new() };
+    GMenu* menuLibrary{ g_menu_new() };
+    g_menu_append(menuLibrary, _("Fingerprint All Music Files"), "win.fingerprintAllMusicFiles");
+    g_menu_append(menuLibrary, _("Find Duplicate Music Files"), "win.findDuplicateMusicFiles");
+    g_menu_append_section(menuHelp, nullptr, G_MENU_MODEL(menuLibrary));
+    g_object_unref(menuLibrary);
     g_menu_append(menuHelp, _("Preferences"), "win.preferences");
     g_menu_append(menuHelp, _("Keyboard Shortcuts"), "win.keyboardShortcuts");
     g_menu_append(menuHelp, std::string(StringHelpers::format(_("About %s"), m_controller.getAppInfo().getShortName().c_str())).c_str(), "win.about");
@@ -269,6 +277,60 @@ MainWindow::MainWindow(GtkApplication* application, const MainWindowController&
     adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtComment), _("Comment"));
     adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_txtComment);
     g_signal_connect(m_txtComment, "changed", G_CALLBACK((void (*)(GtkEditable*, gpointer))[](GtkEditable*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
+    //Disc Number
+    m_txtDiscNumber = adw_entry_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtDiscNumber), _("Disc Number"));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_txtDiscNumber);
+    g_signal_connect(m_txtDiscNumber, "changed", G_CALLBACK((void (*)(GtkEditable*, gpointer))[](GtkEditable*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
+    //Total Tracks
+    m_txtTotalTracks = adw_entry_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtTotalTracks), _("Total Tracks"));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_txtTotalTracks);
+    g_signal_connect(m_txtTotalTracks, "changed", G_CALLBACK((void (*)(GtkEditable*, gpointer))[](GtkEditable*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
+    //Total Discs
+    m_txtTotalDiscs = adw_entry_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtTotalDiscs), _("Total Discs"));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_txtTotalDiscs);
+    g_signal_connect(m_txtTotalDiscs, "changed", G_CALLBACK((void (*)(GtkEditable*, gpointer))[](GtkEditable*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
+    //Composer
+    m_txtComposer = adw_entry_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtComposer), _("Composer"));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_txtComposer);
+    g_signal_connect(m_txtComposer, "changed", G_CALLBACK((void (*)(GtkEditable*, gpointer))[](GtkEditable*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
+    //BPM
+    m_txtBPM = adw_entry_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtBPM), _("BPM"));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_txtBPM);
+    g_signal_connect(m_txtBPM, "changed", G_CALLBACK((void (*)(GtkEditable*, gpointer))[](GtkEditable*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
+    //ISRC
+    m_txtISRC = adw_entry_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtISRC), _("ISRC"));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_txtISRC);
+    g_signal_connect(m_txtISRC, "changed", G_CALLBACK((void (*)(GtkEditable*, gpointer))[](GtkEditable*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
+    //MusicBrainz Recording Id
+    m_txtMusicBrainzRecordingId = adw_entry_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtMusicBrainzRecordingId), _("MusicBrainz Recording Id"));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_txtMusicBrainzRecordingId);
+    g_signal_connect(m_txtMusicBrainzRecordingId, "changed", G_CALLBACK((void (*)(GtkEditable*, gpointer))[](GtkEditable*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
+    //MusicBrainz Release Id
+    m_txtMusicBrainzReleaseId = adw_entry_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtMusicBrainzReleaseId), _("MusicBrainz Release Id"));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_txtMusicBrainzReleaseId);
+    g_signal_connect(m_txtMusicBrainzReleaseId, "changed", G_CALLBACK((void (*)(GtkEditable*, gpointer))[](GtkEditable*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
+    //Lyrics
+    //Lyrics span many lines, so they are edited in a text view that is expanded on demand
+    m_rowLyrics = adw_expander_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_rowLyrics), _("Lyrics"));
+    m_txtLyrics = gtk_text_view_new();
+    gtk_text_view_set_wrap_mode(GTK_TEXT_VIEW(m_txtLyrics), GTK_WRAP_WORD_CHAR);
+    gtk_text_view_set_left_margin(GTK_TEXT_VIEW(m_txtLyrics), 12);
+    gtk_text_view_set_right_margin(GTK_TEXT_VIEW(m_txtLyrics), 12);
+    gtk_text_view_set_top_margin(GTK_TEXT_VIEW(m_txtLyrics), 12);
+    gtk_text_view_set_bottom_margin(GTK_TEXT_VIEW(m_txtLyrics), 12);
+    gtk_widget_set_size_request(m_txtLyrics, -1, 160);
+    adw_expander_row_add_row(ADW_EXPANDER_ROW(m_rowLyrics), m_txtLyrics);
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_adwGrpProperties), m_rowLyrics);
+    g_signal_connect(gtk_text_view_get_buffer(GTK_TEXT_VIEW(m_txtLyrics)), "changed", G_CALLBACK((void (*)(GtkTextBuffer*, gpointer))[](GtkTextBuffer*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onTxtTagPropertyChanged(); }), this);
     //Duration
     m_txtDuration = adw_entry_row_new();
     adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_txtDuration), _("Duration"));
@@ -314,6 +376,14 @@ MainWindow::MainWindow(GtkApplication* application, const MainWindowController&
     m_controller.registerMusicFolderUpdatedCallback([&](bool sendToast) { onMusicFolderUpdated(sendToast); });
     //Music Files Saved Updated Callback
     m_controller.registerMusicFilesSavedUpdatedCallback([&]() { onMusicFilesSavedUpdated(); });
+    //Music File Changed Callback
+    m_controller.registerMusicFileChangedCallback([&](FolderChangeType type, std::size_t index) { onMusicFileChanged(type, index); });
+    //Folder Changes Timer
+    g_timeout_add(500, (GSourceFunc)(gboolean (*)(gpointer))[](gpointer data) -> gboolean
+    {
+        reinterpret_cast<MainWindow*>(data)->onCheckFolderChanges();
+        return G_SOURCE_CONTINUE;
+    }, this);
     //Open Music Folder Action
     m_actOpenMusicFolder = g_simple_action_new("openMusicFolder", nullptr);
     g_signal_connect(m_actOpenMusicFolder, "activate", G_CALLBACK((void (*)(GSimpleAction*, GVariant*, gpointer))[](GSimpleAction*, GVariant*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onOpenMusicFolder(); }), this);
@@ -369,6 +439,14 @@ MainWindow::MainWindow(GtkApplication* application, const MainWindowController&
     g_signal_connect(m_actSubmitToAcoustId, "activate", G_CALLBACK((void (*)(GSimpleAction*, GVariant*, gpointer))[](GSimpleAction*, GVariant*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onSubmitToAcoustId(); }), this);
     g_action_map_add_action(G_ACTION_MAP(m_gobj), G_ACTION(m_actSubmitToAcoustId));
     gtk_application_set_accels_for_action(application, "win.submitToAcoustId", new const char*[2]{ "<Ctrl>u", nullptr });
+    //Fingerprint All Music Files
+    m_actFingerprintAllMusicFiles = g_simple_action_new("fingerprintAllMusicFiles", nullptr);
+    g_signal_connect(m_actFingerprintAllMusicFiles, "activate", G_CALLBACK((void (*)(GSimpleAction*, GVariant*, gpointer))[](GSimpleAction*, GVariant*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onFingerprintAllMusicFiles(); }), this);
+    g_action_map_add_action(G_ACTION_MAP(m_gobj), G_ACTION(m_actFingerprintAllMusicFiles));
+    //Find Duplicate Music Files
+    m_actFindDuplicateMusicFiles = g_simple_action_new("findDuplicateMusicFiles", nullptr);
+    g_signal_connect(m_actFindDuplicateMusicFiles, "activate", G_CALLBACK((void (*)(GSimpleAction*, GVariant*, gpointer))[](GSimpleAction*, GVariant*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onFindDuplicateMusicFiles(); }), this);
+    g_action_map_add_action(G_ACTION_MAP(m_gobj), G_ACTION(m_actFindDuplicateMusicFiles));
     //Preferences Action
     m_actPreferences = g_simple_action_new("preferences", nullptr);
     g_signal_connect(m_actPreferences, "activate", G_CALLBACK((void (*)(GSimpleAction*, GVariant*, gpointer))[](GSimpleAction*, GVariant*, gpointer data) { reinterpret_cast<MainWindow*>(data)->onPreferences(); }), this);
@@ -403,10 +481,24 @@ void MainWindow::start()
 {
     gtk_widget_show(m_gobj);
     m_controller.startup();
+    //Saves interrupted by a crash are finished before the music folder is opened, so it shows what is on disk
+    if(m_controller.getHasInterruptedSaves())
+    {
+        ProgressDialog progressDialog{ GTK_WINDOW(m_gobj), _("Recovering interrupted saves..."), [&]() { m_controller.recoverInterruptedSaves(); } };
+        progressDialog.run();
+    }
+    m_controller.finishStartup();
 }
 
 bool MainWindow::onCloseRequest()
 {
+    if(m_isLoadingMusicFolder)
+    {
+        m_controller.cancelLoadingMusicFolder();
+        m_isClosePending = true;
+        return true;
+    }
+    onFlushSaveQueue();
     if(!m_controller.getCanClose())
     {
         MessageDialog messageDialog{ GTK_WINDOW(m_gobj), _("Apply Changes?"), _("Some music files still have changes waiting to be applied. Would you like to apply those changes to the file or discard them?"), _("Cancel"), _("Discard"), _("Apply") };
@@ -427,6 +519,18 @@ bool MainWindow::onCloseRequest()
 
 void MainWindow::onMusicFolderUpdated(bool sendToast)
 {
+    //A folder opened while another one is loading is loaded once the current load has wound down
+    if(m_isLoadingMusicFolder)
+    {
+        m_controller.cancelLoadingMusicFolder();
+        m_isReloadPending = true;
+        return;
+    }
+    m_isLoadingMusicFolder = true;
+    g_simple_action_set_enabled(m_actOpenMusicFolder, false);
+    g_simple_action_set_enabled(m_actReloadMusicFolder, false);
+    g_simple_action_set_enabled(m_actFingerprintAllMusicFiles, false);
+    g_simple_action_set_enabled(m_actFindDuplicateMusicFiles, false);
     adw_window_title_set_subtitle(ADW_WINDOW_TITLE(m_adwTitle), m_controller.getMusicFolderPath().c_str());
     gtk_widget_set_visible(m_btnReloadMusicFolder, !m_controller.getMusicFolderPath().empty());
     gtk_list_box_unselect_all(GTK_LIST_BOX(m_listMusicFiles));
@@ -435,22 +539,73 @@ void MainWindow::onMusicFolderUpdated(bool sendToast)
         gtk_list_box_remove(GTK_LIST_BOX(m_listMusicFiles), row);
     }
     m_listMusicFilesRows.clear();
-    ProgressDialog progressDialog{ GTK_WINDOW(m_gobj), _("Loading music files..."), [&]() { m_controller.reloadMusicFolder(); } };
-    progressDialog.run();
-    std::size_t musicFilesCount{ m_controller.getMusicFiles().size() };
-    adw_view_stack_set_visible_child_name(ADW_VIEW_STACK(m_viewStack), musicFilesCount > 0 ? "pageTagger" : "pageNoFiles");
-    for(const std::shared_ptr<MusicFile>& musicFile : m_controller.getMusicFiles())
+    adw_view_stack_set_visible_child_name(ADW_VIEW_STACK(m_viewStack), "pageNoFiles");
+    //Rows are appended as batches of music files finish loading, while the main loop keeps the window interactive
+    m_controller.reloadMusicFolder();
+    bool isScanFinished{ false };
+    while(!isScanFinished)
     {
-        GtkWidget* row{ adw_action_row_new() };
-        adw_preferences_row_set_title(ADW_PREFERENCES_ROW(row), std::regex_replace(musicFile->getFilename(), std::regex("\\&"), "&amp;").c_str());
-        gtk_list_box_append(GTK_LIST_BOX(m_listMusicFiles), row);
-        m_listMusicFilesRows.push_back(row);
-        g_main_context_iteration(g_main_context_default(), false);
+        isScanFinished = m_controller.waitForMusicFolderScan(std::chrono::milliseconds(15));
+        if(m_controller.takeLoadedMusicFiles() > 0)
+        {
+            const std::vector<std::shared_ptr<MusicFile>>& musicFiles{ m_controller.getMusicFiles() };
+            for(std::size_t i = m_listMusicFilesRows.size(); i < musicFiles.size(); i++)
+            {
+                GtkWidget* row{ adw_action_row_new() };
+                adw_preferences_row_set_title(ADW_PREFERENCES_ROW(row), std::regex_replace(musicFiles[i]->getFilename(), std::regex("\\&"), "&amp;").c_str());
+                gtk_list_box_append(GTK_LIST_BOX(m_listMusicFiles), row);
+                m_listMusicFilesRows.push_back(row);
+            }
+            adw_view_stack_set_visible_child_name(ADW_VIEW_STACK(m_viewStack), "pageTagger");
+        }
+        while(g_main_context_iteration(g_main_context_default(), false));
+    }
+    //Rows keep their widgets, only their titles and selection move to the sorted position of their music files
+    std::vector<std::size_t> previousIndexes{ m_controller.finishLoadingMusicFolder() };
+    std::vector<bool> wasSelected;
+    for(GtkWidget* row : m_listMusicFilesRows)
+    {
+        wasSelected.push_back(gtk_list_box_row_is_selected(GTK_LIST_BOX_ROW(row)));
     }
-    if(musicFilesCount > 0 && sendToast)
+    m_isUpdatingRows = true;
+    gtk_list_box_unselect_all(GTK_LIST_BOX(m_listMusicFiles));
+    const std::vector<std::shared_ptr<MusicFile>>& musicFiles{ m_controller.getMusicFiles() };
+    for(std::size_t i = 0; i < musicFiles.size(); i++)
+    {
+        adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_listMusicFilesRows[i]), std::regex_replace(musicFiles[i]->getFilename(), std::regex("\\&"), "&amp;").c_str());
+        if(wasSelected[previousIndexes[i]])
+        {
+            gtk_list_box_select_row(GTK_LIST_BOX(m_listMusicFiles), GTK_LIST_BOX_ROW(m_listMusicFilesRows[i]));
+        }
+    }
+    m_isUpdatingRows = false;
+    gtk_list_box_invalidate_filter(GTK_LIST_BOX(m_listMusicFiles));
+    onMusicFilesSavedUpdated();
+    if(m_controller.getSelectedMusicFilesCount() > 0)
+    {
+        onListMusicFilesSelectionChanged();
+    }
+    std::size_t musicFilesCount{ musicFiles.size() };
+    adw_view_stack_set_visible_child_name(ADW_VIEW_STACK(m_viewStack), musicFilesCount > 0 ? "pageTagger" : "pageNoFiles");
+    if(musicFilesCount > 0 && sendToast && !m_isReloadPending)
     {
         adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(m_toastOverlay), adw_toast_new(StringHelpers::format(_("Loaded %d music files."), musicFilesCount).c_str()));
     }
+    m_isLoadingMusicFolder = false;
+    g_simple_action_set_enabled(m_actOpenMusicFolder, true);
+    g_simple_action_set_enabled(m_actReloadMusicFolder, true);
+    g_simple_action_set_enabled(m_actFingerprintAllMusicFiles, true);
+    g_simple_action_set_enabled(m_actFindDuplicateMusicFiles, true);
+    if(m_isClosePending)
+    {
+        m_isClosePending = false;
+        gtk_window_close(GTK_WINDOW(m_gobj));
+    }
+    else if(m_isReloadPending)
+    {
+        m_isReloadPending = false;
+        onMusicFolderUpdated(true);
+    }
 }
 
 void MainWindow::onMusicFilesSavedUpdated()
@@ -458,11 +613,71 @@ void MainWindow::onMusicFilesSavedUpdated()
     size_t i{ 0 };
     for(bool saved : m_controller.getMusicFilesSaved())
     {
-        adw_action_row_set_icon_name(ADW_ACTION_ROW(m_listMusicFilesRows[i]), !saved ? "document-modified-symbolic" : "");
+        //Changes waiting to be saved in the background are told apart from changes waiting for Apply
+        adw_action_row_set_icon_name(ADW_ACTION_ROW(m_listMusicFilesRows[i]), saved ? "" : (m_controller.getIsMusicFileQueued(i) ? "document-save-symbolic" : "document-modified-symbolic"));
         i++;
     }
 }
 
+void MainWindow::onMusicFileChanged(FolderChangeType type, std::size_t index)
+{
+    if(type == FolderChangeType::Added)
+    {
+        GtkWidget* row{ adw_action_row_new() };
+        adw_preferences_row_set_title(ADW_PREFERENCES_ROW(row), std::regex_replace(m_controller.getMusicFiles()[index]->getFilename(), std::regex("\\&"), "&amp;").c_str());
+        gtk_list_box_insert(GTK_LIST_BOX(m_listMusicFiles), row, static_cast<int>(index));
+        m_listMusicFilesRows.insert(m_listMusicFilesRows.begin() + index, row);
+    }
+    else if(type == FolderChangeType::Removed)
+    {
+        //Removing a selected row changes the selection while the indexes of rows and music files disagree, so the selection is re-read afterwards instead
+        m_isUpdatingRows = true;
+        gtk_list_box_remove(GTK_LIST_BOX(m_listMusicFiles), m_listMusicFilesRows[index]);
+        m_isUpdatingRows = false;
+        m_listMusicFilesRows.erase(m_listMusicFilesRows.begin() + index);
+    }
+}
+
+void MainWindow::onCheckFolderChanges()
+{
+    //Changes are not applied while work runs in the background behind a modal dialog or rows are still being created, as both rely on stable indexes
+    if(m_isLoadingMusicFolder)
+    {
+        return;
+    }
+    GListModel* toplevels{ gtk_window_get_toplevels() };
+    for(guint i = 0; i < g_list_model_get_n_items(toplevels); i++)
+    {
+        GtkWindow* window{ GTK_WINDOW(g_list_model_get_item(toplevels, i)) };
+        bool isModal{ gtk_window_get_modal(window) && gtk_widget_get_visible(GTK_WIDGET(window)) };
+        g_object_unref(window);
+        if(isModal)
+        {
+            return;
+        }
+    }
+    m_controller.applySaveQueue();
+    if(m_controller.applyFolderChanges())
+    {
+        adw_view_stack_set_visible_child_name(ADW_VIEW_STACK(m_viewStack), m_controller.getMusicFiles().size() > 0 ? "pageTagger" : "pageNoFiles");
+        onMusicFilesSavedUpdated();
+        //Indexes of selected rows may have shifted, so the selection is re-read once all changes are applied
+        if(m_controller.getSelectedMusicFilesCount() > 0)
+        {
+            onListMusicFilesSelectionChanged();
+        }
+    }
+    //Only the duration field is refreshed, so that edits in progress in the other fields are kept
+    if(m_controller.applyLoadedAudioProperties())
+    {
+        gtk_editable_set_text(GTK_EDITABLE(m_txtDuration), m_controller.getSelectedTagMap().getDuration().c_str());
+    }
+    if(m_controller.applyComputedFingerprints())
+    {
+        gtk_editable_set_text(GTK_EDITABLE(m_txtChromaprintFingerprint), m_controller.getSelectedTagMap().getFingerprint().c_str());
+    }
+}
+
 void MainWindow::onOpenMusicFolder()
 {
     GtkFileChooserNative* openFolderDialog{ gtk_file_chooser_native_new(_("Open Music Folder"), GTK_WINDOW(m_gobj), GTK_FILE_CHOOSER_ACTION_SELECT_FOLDER, _("_Open"), _("_Cancel")) };
@@ -483,6 +698,7 @@ void MainWindow::onOpenMusicFolder()
 
 void MainWindow::onReloadMusicFolder()
 {
+    onFlushSaveQueue();
     if(!m_controller.getCanClose())
     {
         MessageDialog messageDialog{ GTK_WINDOW(m_gobj), _("Apply Changes?"), _("Some music files still have changes waiting to be applied. Would you like to apply those changes to the file or discard them?"), _("Cancel"), _("Discard"), _("Apply") };
@@ -502,6 +718,20 @@ void MainWindow::onReloadMusicFolder()
     }
 }
 
+void MainWindow::onFlushSaveQueue()
+{
+    if(m_controller.getHasQueuedSaves())
+    {
+        ProgressDialog progressDialog{ GTK_WINDOW(m_gobj), _("Saving tags..."), [&]() { m_controller.flushSaveQueue(); } };
+        progressDialog.run();
+    }
+    else
+    {
+        //Only the tag cache entries of the last write-behind batch are left to save
+        m_controller.flushSaveQueue();
+    }
+}
+
 void MainWindow::onApply()
 {
     ProgressDialog progressDialog{ GTK_WINDOW(m_gobj), _("Saving tags..."), [&]() { m_controller.saveTags(); } };
@@ -594,6 +824,55 @@ void MainWindow::onDownloadMusicBrainzMetadata()
     onListMusicFilesSelectionChanged();
 }
 
+void MainWindow::onFingerprintAllMusicFiles()
+{
+    std::atomic<double> progress{ 0.0 };
+    ProgressDialog progressDialog{ GTK_WINDOW(m_gobj), _("Fingerprinting music files...\n<small>(This may take a while)</small>"), [&]()
+    {
+        m_controller.fingerprintAllMusicFiles([&](std::size_t done, std::size_t total) { progress = total > 0 ? static_cast<double>(done) / total : 1.0; });
+    }, [&]() -> double { return progress; } };
+    progressDialog.run();
+    onListMusicFilesSelectionChanged();
+}
+
+void MainWindow::onFindDuplicateMusicFiles()
+{
+    std::atomic<double> progress{ 0.0 };
+    std::vector<std::vector<std::size_t>> groups;
+    ProgressDialog progressDialog{ GTK_WINDOW(m_gobj), _("Finding duplicate music files...\n<small>(This may take a while)</small>"), [&]()
+    {
+        groups = m_controller.findDuplicateMusicFiles([&](std::size_t done, std::size_t total) { progress = total > 0 ? static_cast<double>(done) / total : 1.0; });
+    }, [&]() -> double { return progress; } };
+    progressDialog.run();
+    if(groups.empty())
+    {
+        return;
+    }
+    //The list shows only the duplicates until the search is changed, which sets its own filter. Duplicates are kept by path, not row index, as the folder watcher and reloads insert and remove rows
+    using DuplicateFilter = std::pair<MainWindow*, std::unordered_set<std::string>>;
+    DuplicateFilter* duplicates{ new DuplicateFilter(this, {}) };
+    const std::vector<std::shared_ptr<MusicFile>>& musicFiles{ m_controller.getMusicFiles() };
+    for(const std::vector<std::size_t>& group : groups)
+    {
+        for(std::size_t index : group)
+        {
+            duplicates->second.insert(musicFiles[index]->getPath().string());
+        }
+    }
+    gtk_list_box_set_filter_func(GTK_LIST_BOX(m_listMusicFiles), [](GtkListBoxRow* row, gpointer data) -> int
+    {
+        DuplicateFilter* duplicates{ reinterpret_cast<DuplicateFilter*>(data) };
+        const std::vector<std::shared_ptr<MusicFile>>& musicFiles{ duplicates->first->m_controller.getMusicFiles() };
+        int index{ gtk_list_box_row_get_index(row) };
+        return index >= 0 && static_cast<std::size_t>(index) < musicFiles.size() && duplicates->second.contains(musicFiles[index]->getPath().string());
+    }, duplicates, [](gpointer data)
+    {
+        DuplicateFilter* duplicates{ reinterpret_cast<DuplicateFilter*>(data) };
+        delete duplicates;
+    });
+    onListMusicFilesSelectionChanged();
+}
+
 void MainWindow::onSubmitToAcoustId()
 {
     //Check for one file selected
@@ -671,6 +950,15 @@ void MainWindow::onAdvancedSearchInfo()
     - albumartist
     - genre
     - comment
+    - disc
+    - totaltracks
+    - totaldiscs
+    - composer
+    - bpm
+    - isrc
+    - mbrecordingid
+    - mbreleaseid
+    - lyrics
 
     Syntax Checking:
     - If the syntax of your string is valid, the textbox will turn green and will filter the listbox with your search
@@ -682,7 +970,7 @@ void MainWindow::onAdvancedSearchInfo()
 
     !genre="";year="2022"
     This search string will filter the listbox to contain music files who's genre is empty and who's year is 2022
-    (Year and Track properties will validate if the value string is a number).
+    (Year, Track, Disc, Total Tracks, Total Discs and BPM properties will validate if the value string is a number).
 
     !title="";artist="bob"
     This search string will filter the listbox to contain music files who's title is empty and who's artist is bob
@@ -768,6 +1056,10 @@ void MainWindow::onTxtSearchMusicFilesChanged()
 
 void MainWindow::onListMusicFilesSelectionChanged()
 {
+    if(m_isUpdatingRows)
+    {
+        return;
+    }
     m_isSelectionOccuring = true;
     //Update Selected Music Files
     std::vector<int> selectedIndexes;
@@ -805,6 +1097,15 @@ void MainWindow::onListMusicFilesSelectionChanged()
     gtk_editable_set_text(GTK_EDITABLE(m_txtAlbumArtist), tagMap.getAlbumArtist().c_str());
     gtk_editable_set_text(GTK_EDITABLE(m_txtGenre), tagMap.getGenre().c_str());
     gtk_editable_set_text(GTK_EDITABLE(m_txtComment), tagMap.getComment().c_str());
+    gtk_editable_set_text(GTK_EDITABLE(m_txtDiscNumber), tagMap.getDiscNumber().c_str());
+    gtk_editable_set_text(GTK_EDITABLE(m_txtTotalTracks), tagMap.getTotalTracks().c_str());
+    gtk_editable_set_text(GTK_EDITABLE(m_txtTotalDiscs), tagMap.getTotalDiscs().c_str());
+    gtk_editable_set_text(GTK_EDITABLE(m_txtComposer), tagMap.getComposer().c_str());
+    gtk_editable_set_text(GTK_EDITABLE(m_txtBPM), tagMap.getBPM().c_str());
+    gtk_editable_set_text(GTK_EDITABLE(m_txtISRC), tagMap.getISRC().c_str());
+    gtk_editable_set_text(GTK_EDITABLE(m_txtMusicBrainzRecordingId), tagMap.getMusicBrainzRecordingId().c_str());
+    gtk_editable_set_text(GTK_EDITABLE(m_txtMusicBrainzReleaseId), tagMap.getMusicBrainzReleaseId().c_str());
+    gtk_text_buffer_set_text(gtk_text_view_get_buffer(GTK_TEXT_VIEW(m_txtLyrics)), tagMap.getLyrics().c_str(), -1);
     gtk_editable_set_text(GTK_EDITABLE(m_txtDuration), tagMap.getDuration().c_str());
     gtk_editable_set_text(GTK_EDITABLE(m_txtChromaprintFingerprint), tagMap.getFingerprint().c_str());
     gtk_editable_set_text(GTK_EDITABLE(m_txtFileSize), tagMap.getFileSize().c_str());
@@ -858,6 +1159,21 @@ void MainWindow::onTxtTagPropertyChanged()
         tagMap.setAlbumArtist(gtk_editable_get_text(GTK_EDITABLE(m_txtAlbumArtist)));
         tagMap.setGenre(gtk_editable_get_text(GTK_EDITABLE(m_txtGenre)));
         tagMap.setComment(gtk_editable_get_text(GTK_EDITABLE(m_txtComment)));
+        tagMap.setDiscNumber(gtk_editable_get_text(GTK_EDITABLE(m_txtDiscNumber)));
+        tagMap.setTotalTracks(gtk_editable_get_text(GTK_EDITABLE(m_txtTotalTracks)));
+        tagMap.setTotalDiscs(gtk_editable_get_text(GTK_EDITABLE(m_txtTotalDiscs)));
+        tagMap.setComposer(gtk_editable_get_text(GTK_EDITABLE(m_txtComposer)));
+        tagMap.setBPM(gtk_editable_get_text(GTK_EDITABLE(m_txtBPM)));
+        tagMap.setISRC(gtk_editable_get_text(GTK_EDITABLE(m_txtISRC)));
+        tagMap.setMusicBrainzRecordingId(gtk_editable_get_text(GTK_EDITABLE(m_txtMusicBrainzRecordingId)));
+        tagMap.setMusicBrainzReleaseId(gtk_editable_get_text(GTK_EDITABLE(m_txtMusicBrainzReleaseId)));
+        GtkTextBuffer* lyricsBuffer{ gtk_text_view_get_buffer(GTK_TEXT_VIEW(m_txtLyrics)) };
+        GtkTextIter lyricsStart;
+        GtkTextIter lyricsEnd;
+        gtk_text_buffer_get_bounds(lyricsBuffer, &lyricsStart, &lyricsEnd);
+        char* lyrics{ gtk_text_buffer_get_text(lyricsBuffer, &lyricsStart, &lyricsEnd, false) };
+        tagMap.setLyrics(lyrics);
+        g_free(lyrics);
         m_controller.updateTags(tagMap);
         size_t i{ 0 };
         for(const std::shared_ptr<MusicFile>& musicFile : m_controller.getMusicFiles())
@@ -32,6 +32,10 @@ namespace NickvisionTagger::UI::Views
     private:
     	NickvisionTagger::Controllers::MainWindowController m_controller;
     	bool m_isSelectionOccuring;
+    	bool m_isLoadingMusicFolder;
+    	bool m_isReloadPending;
+    	bool m_isClosePending;
+    	bool m_isUpdatingRows;
 		GtkWidget* m_gobj{ nullptr };
 		GtkWidget* m_mainBox{ nullptr };
 		GtkWidget* m_headerBar{ nullptr };
@@ -68,6 +72,16 @@ namespace NickvisionTagger::UI::Views
 		GtkWidget* m_txtAlbumArtist{ nullptr };
 		GtkWidget* m_txtGenre{ nullptr };
 		GtkWidget* m_txtComment{ nullptr };
+		GtkWidget* m_txtDiscNumber{ nullptr };
+		GtkWidget* m_txtTotalTracks{ nullptr };
+		GtkWidget* m_txtTotalDiscs{ nullptr };
+		GtkWidget* m_txtComposer{ nullptr };
+		GtkWidget* m_txtBPM{ nullptr };
+		GtkWidget* m_txtISRC{ nullptr };
+		GtkWidget* m_txtMusicBrainzRecordingId{ nullptr };
+		GtkWidget* m_txtMusicBrainzReleaseId{ nullptr };
+		GtkWidget* m_rowLyrics{ nullptr };
+		GtkWidget* m_txtLyrics{ nullptr };
 		GtkWidget* m_txtDuration{ nullptr };
 		GtkWidget* m_txtChromaprintFingerprint{ nullptr };
 		GtkWidget* m_txtFileSize{ nullptr };
@@ -90,6 +104,8 @@ namespace NickvisionTagger::UI::Views
 		GSimpleAction* m_actTagToFilename{ nullptr };
 		GSimpleAction* m_actDownloadMusicBrainzMetadata{ nullptr };
 		GSimpleAction* m_actSubmitToAcoustId{ nullptr };
+		GSimpleAction* m_actFingerprintAllMusicFiles{ nullptr };
+		GSimpleAction* m_actFindDuplicateMusicFiles{ nullptr };
 		GSimpleAction* m_actPreferences{ nullptr };
 		GSimpleAction* m_actKeyboardShortcuts{ nullptr };
 		GSimpleAction* m_actAbout{ nullptr };
@@ -112,6 +128,17 @@ namespace NickvisionTagger::UI::Views
     	 * Updates the UI when the saved status of music files is updated
     	 */
     	void onMusicFilesSavedUpdated();
+    	/**
+    	 * Updates the row of a single music file when it is added to, removed from or changed in the music folder
+    	 *
+    	 * @param type The type of change
+    	 * @param index The index of the music file
+    	 */
+    	void onMusicFileChanged(NickvisionTagger::Models::FolderChangeType type, std::size_t index);
+    	/**
+    	 * Applies changes made to the music folder by other programs, unless the window is busy
+    	 */
+    	void onCheckFolderChanges();
     	/**
     	 * Prompts the user to open a music folder from disk and load it in the app
     	 */
@@ -120,6 +147,10 @@ namespace NickvisionTagger::UI::Views
     	 * Reloads the music folder and updates the UI
     	 */
     	void onReloadMusicFolder();
+    	/**
+    	 * Saves the changes queued in write-behind mode (showing progress while they are written) and the tag cache
+    	 */
+    	void onFlushSaveQueue();
     	/**
     	 * Applys the changes to the selected files' tag
     	 */
@@ -156,6 +187,14 @@ namespace NickvisionTagger::UI::Views
     	 * Uploads tag metadata of one selected file to AcoustId
     	 */
     	void onSubmitToAcoustId();
+    	/**
+    	 * Computes the chromaprint fingerprints of all music files in the folder
+    	 */
+    	void onFingerprintAllMusicFiles();
+    	/**
+    	 * Finds the music files in the folder that hold the same recording and shows only those in the list
+    	 */
+    	void onFindDuplicateMusicFiles();
     	/**
     	 * Displays the preferences dialog
     	 */
@@ -69,6 +69,15 @@ PreferencesDialog::PreferencesDialog(GtkWindow* parent, const PreferencesDialogC
     adw_action_row_add_suffix(ADW_ACTION_ROW(m_rowOverwriteTagWithMusicBrainz), m_switchOverwriteTagWithMusicBrainz);
     adw_action_row_set_activatable_widget(ADW_ACTION_ROW(m_rowOverwriteTagWithMusicBrainz), m_switchOverwriteTagWithMusicBrainz);
     adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_grpMusicFile), m_rowOverwriteTagWithMusicBrainz);
+    //Write Behind Row
+    m_rowWriteBehind = adw_action_row_new();
+    m_switchWriteBehind = gtk_switch_new();
+    gtk_widget_set_valign(m_switchWriteBehind, GTK_ALIGN_CENTER);
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_rowWriteBehind), _("Save Changes Automatically"));
+    adw_action_row_set_subtitle(ADW_ACTION_ROW(m_rowWriteBehind), _("If checked, changes to music files will be saved in the background shortly after editing stops, without having to apply them."));
+    adw_action_row_add_suffix(ADW_ACTION_ROW(m_rowWriteBehind), m_switchWriteBehind);
+    adw_action_row_set_activatable_widget(ADW_ACTION_ROW(m_rowWriteBehind), m_switchWriteBehind);
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(m_grpMusicFile), m_rowWriteBehind);
     //Fingerprinting Group
     m_grpFingerprinting = adw_preferences_group_new();
     adw_preferences_group_set_title(ADW_PREFERENCES_GROUP(m_grpFingerprinting), _("Fingerprinting"));
@@ -101,6 +110,7 @@ PreferencesDialog::PreferencesDialog(GtkWindow* parent, const PreferencesDialogC
     gtk_switch_set_active(GTK_SWITCH(m_switchRememberLastOpenedFolder), m_controller.getRememberLastOpenedFolder());
     gtk_switch_set_active(GTK_SWITCH(m_switchPreserveModificationTimeStamp), m_controller.getPreserveModificationTimeStamp());
     gtk_switch_set_active(GTK_SWITCH(m_switchOverwriteTagWithMusicBrainz), m_controller.getOverwriteTagWithMusicBrainz());
+    gtk_switch_set_active(GTK_SWITCH(m_switchWriteBehind), m_controller.getWriteBehind());
     gtk_editable_set_text(GTK_EDITABLE(m_rowAcoustIdUserAPIKey), m_controller.getAcoustIdUserAPIKey().c_str());
 }
 
@@ -120,6 +130,7 @@ void PreferencesDialog::run()
     m_controller.setRememberLastOpenedFolder(gtk_switch_get_active(GTK_SWITCH(m_switchRememberLastOpenedFolder)));
     m_controller.setPreserveModificationTimeStamp(gtk_switch_get_active(GTK_SWITCH(m_switchPreserveModificationTimeStamp)));
     m_controller.setOverwriteTagWithMusicBrainz(gtk_switch_get_active(GTK_SWITCH(m_switchOverwriteTagWithMusicBrainz)));
+    m_controller.setWriteBehind(gtk_switch_get_active(GTK_SWITCH(m_switchWriteBehind)));
     m_controller.setAcoustIdUserAPIKey(gtk_editable_get_text(GTK_EDITABLE(m_rowAcoustIdUserAPIKey)));
     m_controller.saveConfiguration();
     gtk_window_destroy(GTK_WINDOW(m_gobj));
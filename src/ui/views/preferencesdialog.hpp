@@ -47,6 +47,8 @@ namespace NickvisionTagger::UI::Views
 		GtkWidget* m_switchPreserveModificationTimeStamp{ nullptr };
 		GtkWidget* m_rowOverwriteTagWithMusicBrainz{ nullptr };
 		GtkWidget* m_switchOverwriteTagWithMusicBrainz{ nullptr };
+		GtkWidget* m_rowWriteBehind{ nullptr };
+		GtkWidget* m_switchWriteBehind{ nullptr };
 		GtkWidget* m_grpFingerprinting{ nullptr };
 		GtkWidget* m_btnGetAcoustIdUserAPIKey{ nullptr };
 		GtkWidget* m_rowAcoustIdUserAPIKey{ nullptr };